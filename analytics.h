@@ -0,0 +1,949 @@
+#ifndef ANALYTICS_H
+#define ANALYTICS_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <algorithm>
+#include <future>
+#include <thread>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <iomanip>
+#include <sstream>
+#include <fstream>
+#include <tuple>
+#include <cstdint>
+
+#include "utils.h"
+#include "storage.h"
+#include "catalog.h"
+#include "attendance_store.h"
+#include "schema.h"
+#include "table.h"
+
+using namespace std;
+
+namespace Analytics
+{
+    string formatNumber(double value)
+    {
+        if (value == floor(value) && fabs(value) < 1e15)
+            return to_string(static_cast<long long>(value));
+        ostringstream out;
+        out << fixed << setprecision(2) << value;
+        return out.str();
+    }
+
+    // Numbers compare numerically, everything else as text (ISO dates sort correctly)
+    int compareValues(const string& a, const string& b)
+    {
+        char* endA = nullptr;
+        char* endB = nullptr;
+        double x = strtod(a.c_str(), &endA);
+        double y = strtod(b.c_str(), &endB);
+        if (!a.empty() && !b.empty() && *endA == '\0' && *endB == '\0')
+            return x < y ? -1 : (x > y ? 1 : 0);
+        return a.compare(b) < 0 ? -1 : (a == b ? 0 : 1);
+    }
+
+    string termOf(const string& date)
+    {
+        if (date.size() < 7)
+            return string();
+        return (date.substr(5, 2) <= "06" ? "Spring-" : "Fall-") + date.substr(0, 4);
+    }
+
+    // "10-A" -> "10"
+    string gradeLevel(const string& className)
+    {
+        return className.substr(0, className.find('-'));
+    }
+
+    // 87 -> "80-89"; 100 falls in "90-100"
+    string scoreBand(int score)
+    {
+        if (score >= 90)
+            return "90-100";
+        int low = score / 10 * 10;
+        return to_string(low) + "-" + to_string(low + 9);
+    }
+}
+
+// One column of an in-memory table. Text columns are dictionary encoded so
+// filters and group keys work on small integer codes; numeric columns hold
+// the values directly.
+struct Column
+{
+    string name;
+    bool numeric = false;
+    vector<double> values;
+    vector<uint32_t> codes;
+    vector<string> dictionary;
+    unordered_map<string, uint32_t> lookup;
+
+    void add(const string& text)
+    {
+        auto it = lookup.find(text);
+        if (it == lookup.end())
+        {
+            it = lookup.emplace(text, static_cast<uint32_t>(dictionary.size())).first;
+            dictionary.push_back(text);
+        }
+        codes.push_back(it->second);
+    }
+
+    void add(double value)
+    {
+        values.push_back(value);
+    }
+
+    string text(size_t row) const
+    {
+        return numeric ? Analytics::formatNumber(values[row]) : dictionary[codes[row]];
+    }
+};
+
+struct Table
+{
+    string name;
+    size_t rows = 0;
+    vector<Column> columns;
+
+    int find(const string& columnName) const
+    {
+        for (size_t i = 0; i < columns.size(); ++i)
+        {
+            if (columns[i].name == columnName)
+                return static_cast<int>(i);
+        }
+        return -1;
+    }
+
+    Column& addColumn(const string& columnName, bool numeric)
+    {
+        columns.push_back(Column());
+        columns.back().name = columnName;
+        columns.back().numeric = numeric;
+        return columns.back();
+    }
+};
+
+struct QueryResult
+{
+    vector<string> headers;
+    vector<vector<string>> rows;
+    size_t scanned = 0;
+    double millis = 0;
+    string error;
+};
+
+// Ad-hoc group-by / filter / aggregate queries over grades and attendance:
+//   SELECT item, ... FROM table [WHERE col op value [AND ...]]
+//     [GROUP BY col, ...] [ORDER BY item [ASC|DESC]] [LIMIT n]
+// item is a column, * or avg|count|sum|min|max(col | *), optionally AS alias.
+// Tables are loaded once into columns; a query is split into row ranges that
+// are filtered and aggregated on all cores and merged at the end.
+class QueryEngine
+{
+private:
+    struct Token
+    {
+        string text;
+        bool quoted = false;
+    };
+
+    struct SelectItem
+    {
+        string aggregate; // empty for a plain column
+        int column = -1;  // -1 for count(*)
+        string label;
+    };
+
+    struct Predicate
+    {
+        int column = -1;
+        string op;
+        double number = 0;
+        vector<uint8_t> allowed; // per dictionary code, for text columns
+    };
+
+    struct Query
+    {
+        const Table* table = nullptr;
+        vector<SelectItem> items;
+        vector<Predicate> where;
+        vector<int> groupBy;
+        string orderBy;
+        bool descending = false;
+        size_t limit = 0;
+    };
+
+    struct AggregateState
+    {
+        double sum = 0;
+        double min = numeric_limits<double>::infinity();
+        double max = -numeric_limits<double>::infinity();
+    };
+
+    // What one worker produced for its row range
+    struct Partial
+    {
+        unordered_map<uint64_t, size_t> slots;
+        vector<uint64_t> keys;
+        vector<size_t> counts;
+        vector<AggregateState> states; // slots * aggregates
+        vector<uint32_t> rows;         // selected rows, for plain selects
+        size_t scanned = 0;
+    };
+
+    static const size_t blockSize = 1024;
+
+    map<string, Table> tables;
+
+    static vector<Token> tokenize(const string& text)
+    {
+        vector<Token> tokens;
+        size_t i = 0;
+        while (i < text.size())
+        {
+            char c = text[i];
+            if (isspace(static_cast<unsigned char>(c)))
+            {
+                i++;
+            }
+            else if (c == '\'' || c == '"')
+            {
+                size_t end = text.find(c, i + 1);
+                if (end == string::npos)
+                    end = text.size();
+                tokens.push_back(Token{ text.substr(i + 1, end - i - 1), true });
+                i = end + 1;
+            }
+            else if (c == '(' || c == ')' || c == ',' || c == '*')
+            {
+                tokens.push_back(Token{ string(1, c), false });
+                i++;
+            }
+            else if (c == '=' || c == '<' || c == '>' || c == '!')
+            {
+                size_t length = (i + 1 < text.size() && (text[i + 1] == '=' || (c == '<' && text[i + 1] == '>'))) ? 2 : 1;
+                tokens.push_back(Token{ text.substr(i, length), false });
+                i += length;
+            }
+            else
+            {
+                size_t start = i;
+                while (i < text.size() && !isspace(static_cast<unsigned char>(text[i])) && string("(),*=<>!'\"").find(text[i]) == string::npos)
+                    i++;
+                tokens.push_back(Token{ text.substr(start, i - start), false });
+            }
+        }
+        return tokens;
+    }
+
+    static bool isKeyword(const Token& token, const string& word)
+    {
+        return !token.quoted && Utils::toLower(token.text) == word;
+    }
+
+    static bool isAggregate(const string& word)
+    {
+        return word == "avg" || word == "count" || word == "sum" || word == "min" || word == "max";
+    }
+
+    bool parse(const string& text, Query& query, string& error) const
+    {
+        vector<Token> tokens = tokenize(text);
+        size_t pos = 0;
+        auto at = [&](const string& word) { return pos < tokens.size() && isKeyword(tokens[pos], word); };
+        auto next = [&]() -> const Token& {
+            static const Token end;
+            return pos < tokens.size() ? tokens[pos++] : end;
+        };
+
+        if (!at("select"))
+        {
+            error = "Query must start with SELECT";
+            return false;
+        }
+        pos++;
+
+        // Items are resolved once the table is known
+        struct RawItem { string aggregate; string column; string label; };
+        vector<RawItem> rawItems;
+        do {
+            RawItem item;
+            const Token& token = next();
+            string word = Utils::toLower(token.text);
+            if (pos < tokens.size() && tokens[pos].text == "(" && isAggregate(word))
+            {
+                pos++;
+                item.aggregate = word;
+                item.column = next().text;
+                if (next().text != ")")
+                {
+                    error = "Missing ) after " + word + "(" + item.column;
+                    return false;
+                }
+                item.label = word + "(" + item.column + ")";
+            }
+            else
+            {
+                item.column = token.text;
+                item.label = item.column;
+            }
+            if (at("as"))
+            {
+                pos++;
+                item.label = next().text;
+            }
+            rawItems.push_back(item);
+        } while (pos < tokens.size() && tokens[pos].text == "," && ++pos);
+
+        if (!at("from"))
+        {
+            error = "Expected FROM";
+            return false;
+        }
+        pos++;
+        string tableName = Utils::toLower(next().text);
+        auto table = tables.find(tableName);
+        if (table == tables.end())
+        {
+            error = "Unknown table '" + tableName + "'";
+            return false;
+        }
+        query.table = &table->second;
+        const Table& t = table->second;
+
+        auto resolve = [&](const string& columnName, int& column) {
+            column = t.find(Utils::toLower(columnName));
+            if (column < 0)
+                error = "Unknown column '" + columnName + "' in " + t.name;
+            return column >= 0;
+        };
+
+        for (const auto& raw : rawItems)
+        {
+            if (raw.aggregate.empty() && raw.column == "*")
+            {
+                for (size_t c = 0; c < t.columns.size(); ++c)
+                {
+                    query.items.push_back(SelectItem{ "", static_cast<int>(c), t.columns[c].name });
+                }
+                continue;
+            }
+
+            SelectItem item{ raw.aggregate, -1, raw.label };
+            if (!(raw.aggregate == "count" && raw.column == "*") && !resolve(raw.column, item.column))
+                return false;
+            if (!item.aggregate.empty() && item.aggregate != "count" && !t.columns[item.column].numeric)
+            {
+                error = item.aggregate + " needs a numeric column";
+                return false;
+            }
+            query.items.push_back(item);
+        }
+
+        if (at("where"))
+        {
+            pos++;
+            do {
+                Predicate predicate;
+                if (!resolve(next().text, predicate.column))
+                    return false;
+                predicate.op = next().text;
+                if (predicate.op == "<>")
+                    predicate.op = "!=";
+                if (predicate.op != "=" && predicate.op != "!=" && predicate.op != "<" && predicate.op != "<=" && predicate.op != ">" && predicate.op != ">=")
+                {
+                    error = "Unknown operator '" + predicate.op + "'";
+                    return false;
+                }
+                string value = next().text;
+
+                const Column& column = t.columns[predicate.column];
+                if (column.numeric)
+                {
+                    char* end = nullptr;
+                    predicate.number = strtod(value.c_str(), &end);
+                    if (value.empty() || *end != '\0')
+                    {
+                        error = "Column '" + column.name + "' needs a number";
+                        return false;
+                    }
+                }
+                else
+                {
+                    // Evaluate the comparison once per distinct value
+                    predicate.allowed.resize(column.dictionary.size());
+                    for (size_t code = 0; code < column.dictionary.size(); ++code)
+                    {
+                        predicate.allowed[code] = matches(Analytics::compareValues(column.dictionary[code], value), predicate.op);
+                    }
+                }
+                query.where.push_back(predicate);
+            } while (at("and") && ++pos);
+        }
+
+        if (at("group"))
+        {
+            pos++;
+            if (!at("by"))
+            {
+                error = "Expected BY after GROUP";
+                return false;
+            }
+            pos++;
+            do {
+                int column;
+                if (!resolve(next().text, column))
+                    return false;
+                if (t.columns[column].numeric)
+                {
+                    error = "Cannot group by numeric column '" + t.columns[column].name + "'";
+                    return false;
+                }
+                query.groupBy.push_back(column);
+            } while (pos < tokens.size() && tokens[pos].text == "," && ++pos);
+        }
+
+        if (at("order"))
+        {
+            pos++;
+            if (!at("by"))
+            {
+                error = "Expected BY after ORDER";
+                return false;
+            }
+            pos++;
+            query.orderBy = Utils::toLower(next().text);
+            if (pos < tokens.size() && tokens[pos].text == "(")
+            {
+                pos++;
+                query.orderBy += "(" + Utils::toLower(next().text) + ")";
+                pos++;
+            }
+            if (at("desc") || at("asc"))
+                query.descending = Utils::toLower(next().text) == "desc";
+        }
+
+        if (at("limit"))
+        {
+            pos++;
+            string count = next().text;
+            if (count.empty() || !all_of(count.begin(), count.end(), ::isdigit))
+            {
+                error = "LIMIT needs a number";
+                return false;
+            }
+            query.limit = stoul(count);
+        }
+
+        if (pos < tokens.size())
+        {
+            error = "Unexpected '" + tokens[pos].text + "'";
+            return false;
+        }
+
+        bool aggregated = !query.groupBy.empty();
+        for (const auto& item : query.items)
+        {
+            aggregated = aggregated || !item.aggregate.empty();
+        }
+        for (const auto& item : query.items)
+        {
+            if (aggregated && item.aggregate.empty() && find(query.groupBy.begin(), query.groupBy.end(), item.column) == query.groupBy.end())
+            {
+                error = "Column '" + item.label + "' must be in GROUP BY or aggregated";
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static bool matches(int comparison, const string& op)
+    {
+        if (op == "=") return comparison == 0;
+        if (op == "!=") return comparison != 0;
+        if (op == "<") return comparison < 0;
+        if (op == "<=") return comparison <= 0;
+        if (op == ">") return comparison > 0;
+        return comparison >= 0;
+    }
+
+    // Narrow sel[0, n) to the rows passing the predicate; returns the new count
+    static size_t filter(const Table& table, const Predicate& p, uint32_t* sel, size_t n)
+    {
+        const Column& column = table.columns[p.column];
+        size_t kept = 0;
+        if (!column.numeric)
+        {
+            const uint32_t* codes = column.codes.data();
+            const uint8_t* allowed = p.allowed.data();
+            for (size_t i = 0; i < n; ++i)
+            {
+                sel[kept] = sel[i];
+                kept += allowed[codes[sel[i]]];
+            }
+            return kept;
+        }
+
+        const double* values = column.values.data();
+        const double x = p.number;
+        // One tight loop per operator, so the comparison is not re-dispatched per row
+        if (p.op == "=")       for (size_t i = 0; i < n; ++i) { sel[kept] = sel[i]; kept += values[sel[i]] == x; }
+        else if (p.op == "!=") for (size_t i = 0; i < n; ++i) { sel[kept] = sel[i]; kept += values[sel[i]] != x; }
+        else if (p.op == "<")  for (size_t i = 0; i < n; ++i) { sel[kept] = sel[i]; kept += values[sel[i]] < x; }
+        else if (p.op == "<=") for (size_t i = 0; i < n; ++i) { sel[kept] = sel[i]; kept += values[sel[i]] <= x; }
+        else if (p.op == ">")  for (size_t i = 0; i < n; ++i) { sel[kept] = sel[i]; kept += values[sel[i]] > x; }
+        else                   for (size_t i = 0; i < n; ++i) { sel[kept] = sel[i]; kept += values[sel[i]] >= x; }
+        return kept;
+    }
+
+    static Partial scanRange(const Query& query, const vector<uint64_t>& strides, bool aggregated, size_t begin, size_t end)
+    {
+        const Table& table = *query.table;
+        Partial partial;
+        vector<uint32_t> sel(blockSize);
+        vector<int> aggregates;
+        for (const auto& item : query.items)
+        {
+            if (!item.aggregate.empty())
+                aggregates.push_back(item.column);
+        }
+
+        for (size_t start = begin; start < end; start += blockSize)
+        {
+            size_t n = min(blockSize, end - start);
+            for (size_t i = 0; i < n; ++i)
+            {
+                sel[i] = static_cast<uint32_t>(start + i);
+            }
+            for (const auto& predicate : query.where)
+            {
+                n = filter(table, predicate, sel.data(), n);
+            }
+            partial.scanned += n;
+
+            if (!aggregated)
+            {
+                partial.rows.insert(partial.rows.end(), sel.begin(), sel.begin() + n);
+                continue;
+            }
+
+            for (size_t i = 0; i < n; ++i)
+            {
+                uint32_t row = sel[i];
+                uint64_t key = 0;
+                for (size_t g = 0; g < query.groupBy.size(); ++g)
+                {
+                    key += table.columns[query.groupBy[g]].codes[row] * strides[g];
+                }
+
+                auto slot = partial.slots.find(key);
+                if (slot == partial.slots.end())
+                {
+                    slot = partial.slots.emplace(key, partial.keys.size()).first;
+                    partial.keys.push_back(key);
+                    partial.counts.push_back(0);
+                    partial.states.resize(partial.states.size() + aggregates.size());
+                }
+
+                partial.counts[slot->second]++;
+                AggregateState* state = &partial.states[slot->second * aggregates.size()];
+                for (size_t a = 0; a < aggregates.size(); ++a)
+                {
+                    if (aggregates[a] < 0 || !table.columns[aggregates[a]].numeric)
+                        continue;
+                    double value = table.columns[aggregates[a]].values[row];
+                    state[a].sum += value;
+                    state[a].min = min(state[a].min, value);
+                    state[a].max = max(state[a].max, value);
+                }
+            }
+        }
+        return partial;
+    }
+
+    static void sortRows(const Query& query, QueryResult& result)
+    {
+        int orderColumn = -1;
+        if (!query.orderBy.empty())
+        {
+            for (size_t i = 0; i < query.items.size(); ++i)
+            {
+                if (Utils::toLower(query.items[i].label) == query.orderBy)
+                    orderColumn = static_cast<int>(i);
+            }
+        }
+
+        stable_sort(result.rows.begin(), result.rows.end(), [&](const vector<string>& a, const vector<string>& b)
+            {
+            if (orderColumn >= 0)
+            {
+                int c = Analytics::compareValues(a[orderColumn], b[orderColumn]);
+                if (c != 0)
+                    return query.descending ? c > 0 : c < 0;
+                return false;
+            }
+            for (size_t i = 0; i < a.size(); ++i)
+            {
+                int c = Analytics::compareValues(a[i], b[i]);
+                if (c != 0)
+                    return c < 0;
+            }
+            return false;
+            });
+    }
+
+    void loadGrades(const map<string, string>& subjects)
+    {
+        Table& table = tables["grades"];
+        table.name = "grades";
+        table.columns.reserve(10);
+        Column* term = &table.addColumn("term", false);
+        Column* date = &table.addColumn("date", false);
+        Column* className = &table.addColumn("class", false);
+        Column* level = &table.addColumn("level", false);
+        Column* teacher = &table.addColumn("teacher", false);
+        Column* teacherSubjects = &table.addColumn("teacher_subjects", false);
+        Column* type = &table.addColumn("type", false);
+        Column* student = &table.addColumn("student", false);
+        Column* score = &table.addColumn("score", true);
+        Column* band = &table.addColumn("band", false);
+
+        vector<Storage::Section> sections = Storage::parseSections(Storage::readAll(Catalog::path("grades.txt")));
+
+        // A re-entered grade sheet replaces the earlier one for the same term
+        unordered_map<string, size_t> latest;
+        for (size_t i = 0; i < sections.size(); ++i)
+        {
+            latest[sections[i].header + Analytics::termOf(sections[i].committed)] = i;
+        }
+
+        for (size_t i = 0; i < sections.size(); ++i)
+        {
+            const Storage::Section& section = sections[i];
+            // [GRADES <type> CLASS <class> TEACHER <id>]
+            size_t classPos = section.header.find(" CLASS ");
+            size_t teacherPos = section.header.find(" TEACHER ");
+            if (section.header.compare(0, 8, "[GRADES ") != 0 || classPos == string::npos || teacherPos == string::npos || teacherPos < classPos)
+                continue;
+            if (latest[section.header + Analytics::termOf(section.committed)] != i)
+                continue;
+
+            string sectionType = section.header.substr(8, classPos - 8);
+            string sectionClass = section.header.substr(classPos + 7, teacherPos - classPos - 7);
+            string teacherId = section.header.substr(teacherPos + 9);
+            if (!teacherId.empty() && teacherId.back() == ']')
+                teacherId.pop_back();
+            auto subjectIt = subjects.find(teacherId);
+
+            for (const auto& line : section.lines)
+            {
+                GradeLine grade;
+                if (!Schema::parseLine(line, grade))
+                    continue;
+                int value = grade.score;
+
+                term->add(Analytics::termOf(section.committed));
+                date->add(section.committed);
+                className->add(sectionClass);
+                level->add(Analytics::gradeLevel(sectionClass));
+                teacher->add(teacherId);
+                teacherSubjects->add(subjectIt == subjects.end() ? string() : subjectIt->second);
+                type->add(sectionType);
+                student->add(grade.studentId);
+                score->add(static_cast<double>(value));
+                band->add(Analytics::scoreBand(value));
+                table.rows++;
+            }
+        }
+    }
+
+    void loadAttendance()
+    {
+        Table& table = tables["attendance"];
+        table.name = "attendance";
+        table.columns.reserve(7);
+        Column* date = &table.addColumn("date", false);
+        Column* month = &table.addColumn("month", false);
+        Column* term = &table.addColumn("term", false);
+        Column* className = &table.addColumn("class", false);
+        Column* level = &table.addColumn("level", false);
+        Column* student = &table.addColumn("student", false);
+        Column* present = &table.addColumn("present", true);
+
+        AttendanceStore::instance().scan(DateRange::all(), [&](const AttendanceEntry& e)
+            {
+            date->add(e.date);
+            month->add(e.date.substr(0, 7));
+            term->add(Analytics::termOf(e.date));
+            className->add(e.className);
+            level->add(Analytics::gradeLevel(e.className));
+            student->add(e.studentId);
+            present->add(e.present ? 1.0 : 0.0);
+            table.rows++;
+            });
+    }
+
+    // Per student, class and term totals derived from the attendance columns
+    void loadAttendanceSummary()
+    {
+        const Table& source = tables["attendance"];
+        const Column& term = source.columns[source.find("term")];
+        const Column& className = source.columns[source.find("class")];
+        const Column& student = source.columns[source.find("student")];
+        const Column& present = source.columns[source.find("present")];
+
+        map<tuple<uint32_t, uint32_t, uint32_t>, pair<size_t, size_t>> totals;
+        for (size_t row = 0; row < source.rows; ++row)
+        {
+            pair<size_t, size_t>& t = totals[make_tuple(student.codes[row], className.codes[row], term.codes[row])];
+            t.first++;
+            t.second += present.values[row] > 0 ? 1 : 0;
+        }
+
+        Table& table = tables["attendance_summary"];
+        table.name = "attendance_summary";
+        table.columns.reserve(8);
+        Column* studentOut = &table.addColumn("student", false);
+        Column* classOut = &table.addColumn("class", false);
+        Column* levelOut = &table.addColumn("level", false);
+        Column* termOut = &table.addColumn("term", false);
+        Column* days = &table.addColumn("days", true);
+        Column* presentOut = &table.addColumn("present", true);
+        Column* absent = &table.addColumn("absent", true);
+        Column* pct = &table.addColumn("pct", true);
+
+        for (const auto& item : totals)
+        {
+            const string& cls = className.dictionary[get<1>(item.first)];
+            studentOut->add(student.dictionary[get<0>(item.first)]);
+            classOut->add(cls);
+            levelOut->add(Analytics::gradeLevel(cls));
+            termOut->add(term.dictionary[get<2>(item.first)]);
+            days->add(static_cast<double>(item.second.first));
+            presentOut->add(static_cast<double>(item.second.second));
+            absent->add(static_cast<double>(item.second.first - item.second.second));
+            pct->add(round(1000.0 * item.second.second / item.second.first) / 10.0);
+            table.rows++;
+        }
+    }
+
+public:
+    void load()
+    {
+        tables.clear();
+
+        // Grade sheets name no subject, only the teacher; their subject list
+        // is carried along as is ("Math,Physics" for a teacher of both)
+        map<string, string> subjects;
+        for (const auto& teacher : Schema::loadFile<TeacherRecord>(Catalog::path("teachers.txt")))
+        {
+            subjects[teacher.id] = Utils::joinString(teacher.subjects, ",");
+        }
+
+        loadGrades(subjects);
+        loadAttendance();
+        loadAttendanceSummary();
+    }
+
+    QueryResult run(const string& text) const
+    {
+        QueryResult result;
+        auto started = chrono::steady_clock::now();
+
+        Query query;
+        if (!parse(text, query, result.error))
+            return result;
+        const Table& table = *query.table;
+
+        bool aggregated = !query.groupBy.empty();
+        for (const auto& item : query.items)
+        {
+            result.headers.push_back(item.label);
+            aggregated = aggregated || !item.aggregate.empty();
+        }
+
+        // Group key = codes in mixed radix over the dictionary sizes
+        vector<uint64_t> strides;
+        uint64_t stride = 1;
+        for (int column : query.groupBy)
+        {
+            strides.push_back(stride);
+            uint64_t size = max<size_t>(1, table.columns[column].dictionary.size());
+            if (stride > numeric_limits<uint64_t>::max() / size)
+            {
+                result.error = "Too many groups";
+                return result;
+            }
+            stride *= size;
+        }
+
+        size_t workers = max(1u, thread::hardware_concurrency());
+        workers = min(workers, table.rows / (16 * blockSize) + 1);
+        size_t perWorker = (table.rows + workers - 1) / workers;
+        perWorker = (perWorker + blockSize - 1) / blockSize * blockSize;
+
+        vector<future<Partial>> jobs;
+        for (size_t begin = 0; begin < table.rows; begin += perWorker)
+        {
+            jobs.push_back(async(launch::async, scanRange, cref(query), cref(strides), aggregated, begin, min(table.rows, begin + perWorker)));
+        }
+        vector<Partial> partials;
+        for (auto& job : jobs)
+        {
+            partials.push_back(job.get());
+            result.scanned += partials.back().scanned;
+        }
+
+        if (!aggregated)
+        {
+            for (const auto& partial : partials)
+            {
+                for (uint32_t row : partial.rows)
+                {
+                    vector<string> cells;
+                    for (const auto& item : query.items)
+                    {
+                        cells.push_back(table.columns[item.column].text(row));
+                    }
+                    result.rows.push_back(cells);
+                }
+            }
+        }
+        else
+        {
+            size_t aggregateCount = 0;
+            for (const auto& item : query.items)
+            {
+                aggregateCount += item.aggregate.empty() ? 0 : 1;
+            }
+
+            // Merge the workers' groups
+            Partial merged;
+            for (const auto& partial : partials)
+            {
+                for (size_t s = 0; s < partial.keys.size(); ++s)
+                {
+                    auto slot = merged.slots.find(partial.keys[s]);
+                    if (slot == merged.slots.end())
+                    {
+                        slot = merged.slots.emplace(partial.keys[s], merged.keys.size()).first;
+                        merged.keys.push_back(partial.keys[s]);
+                        merged.counts.push_back(0);
+                        merged.states.resize(merged.states.size() + aggregateCount);
+                    }
+                    merged.counts[slot->second] += partial.counts[s];
+                    for (size_t a = 0; a < aggregateCount; ++a)
+                    {
+                        AggregateState& to = merged.states[slot->second * aggregateCount + a];
+                        const AggregateState& from = partial.states[s * aggregateCount + a];
+                        to.sum += from.sum;
+                        to.min = min(to.min, from.min);
+                        to.max = max(to.max, from.max);
+                    }
+                }
+            }
+            // Aggregates over no rows still give one row of zeros
+            if (merged.keys.empty() && query.groupBy.empty())
+            {
+                merged.keys.push_back(0);
+                merged.counts.push_back(0);
+                merged.states.resize(aggregateCount);
+            }
+
+            for (size_t s = 0; s < merged.keys.size(); ++s)
+            {
+                vector<string> cells;
+                size_t a = 0;
+                for (const auto& item : query.items)
+                {
+                    if (item.aggregate.empty())
+                    {
+                        size_t g = find(query.groupBy.begin(), query.groupBy.end(), item.column) - query.groupBy.begin();
+                        const Column& column = table.columns[item.column];
+                        cells.push_back(column.dictionary[(merged.keys[s] / strides[g]) % max<size_t>(1, column.dictionary.size())]);
+                        continue;
+                    }
+
+                    const AggregateState& state = merged.states[s * aggregateCount + a++];
+                    size_t count = merged.counts[s];
+                    if (item.aggregate == "count")
+                        cells.push_back(to_string(count));
+                    else if (count == 0)
+                        cells.push_back("-");
+                    else if (item.aggregate == "sum")
+                        cells.push_back(Analytics::formatNumber(state.sum));
+                    else if (item.aggregate == "avg")
+                        cells.push_back(Analytics::formatNumber(state.sum / count));
+                    else if (item.aggregate == "min")
+                        cells.push_back(Analytics::formatNumber(state.min));
+                    else
+                        cells.push_back(Analytics::formatNumber(state.max));
+                }
+                result.rows.push_back(cells);
+            }
+        }
+
+        sortRows(query, result);
+        if (query.limit > 0 && result.rows.size() > query.limit)
+            result.rows.resize(query.limit);
+
+        result.millis = chrono::duration<double, milli>(chrono::steady_clock::now() - started).count();
+        return result;
+    }
+
+    static void printResult(const QueryResult& result)
+    {
+        if (!result.error.empty())
+        {
+            cout << "Query error: " << result.error << endl;
+            return;
+        }
+
+        ConsoleTable table;
+        table.underlined();
+        for (const auto& header : result.headers)
+        {
+            table.column(header);
+        }
+        for (const auto& row : result.rows)
+        {
+            for (const auto& value : row)
+            {
+                table.cell(value);
+            }
+        }
+
+        string out;
+        table.render(out);
+        out += "(" + to_string(result.rows.size()) + " rows from " + to_string(result.scanned) + " matching, ";
+        ConsoleTable::appendFixed(out, result.millis, 1);
+        out += " ms)\n";
+        cout << out;
+    }
+
+    void printTables() const
+    {
+        cout << "Tables:\n";
+        for (const auto& item : tables)
+        {
+            cout << "  " << item.first << " (" << item.second.rows << " rows):";
+            for (const auto& column : item.second.columns)
+            {
+                cout << " " << column.name;
+            }
+            cout << "\n";
+        }
+        cout << "Example: SELECT class, teacher, avg(score) FROM grades WHERE type = final GROUP BY class, teacher\n";
+    }
+};
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <string>
+#include <string_view>
+#include <memory_resource>
+#include <cstddef>
+#include <cstdio>
+
+using namespace std;
+
+// Memory for one operation such as a report run. Everything allocated from
+// it is released at once when the arena goes out of scope. The first 64 KB
+// are part of the arena object itself; bigger operations grow in a few large
+// blocks instead of one allocation per string or map node.
+class OperationArena
+{
+private:
+    alignas(max_align_t) char initial[64 * 1024];
+    pmr::monotonic_buffer_resource resource;
+
+public:
+    OperationArena() : resource(initial, sizeof(initial)) {}
+    OperationArena(const OperationArena&) = delete;
+    OperationArena& operator=(const OperationArena&) = delete;
+
+    pmr::memory_resource* get()
+    {
+        return &resource;
+    }
+};
+
+namespace ArenaLoad
+{
+    // Append a float the way ostream's default formatting prints it
+    void appendNumber(pmr::string& out, double value)
+    {
+        char buffer[32];
+        snprintf(buffer, sizeof(buffer), "%g", value);
+        out += buffer;
+    }
+}
+
+#endif
@@ -0,0 +1,305 @@
+#ifndef ATTENDANCE_IMPORT_H
+#define ATTENDANCE_IMPORT_H
+
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <set>
+#include <unordered_map>
+#include <algorithm>
+#include <future>
+#include <thread>
+#include <cstdint>
+
+#include "utils.h"
+#include "storage.h"
+#include "schema.h"
+#include "catalog.h"
+#include "records.h"
+#include "attendance_store.h"
+#include "summary.h"
+
+using namespace std;
+
+struct ImportResult
+{
+    size_t lines = 0;
+    size_t taps = 0;            // lines matched to a student and a date
+    size_t repeatTaps = 0;      // further taps by a student on a day already counted
+    size_t unknownCards = 0;
+    size_t unreadable = 0;
+    size_t sheets = 0;          // (class, date) sections written for days not marked before
+    size_t updated = 0;         // (class, date) pairs marked before that gained present students
+    size_t alreadyMarked = 0;   // (class, date) pairs marked before with every tapper already present
+    size_t present = 0;
+    size_t absent = 0;
+    bool ok = true;
+};
+
+// Presence logs exported by card readers and biometric terminals, one tap
+// per line: <card or roll number>,<YYYY-MM-DD[ HH:MM[:SS]]>[,...]. Commas,
+// semicolons or tabs separate the fields and a header line is skipped as
+// unreadable. A tap is matched to a student through cards.txt
+// (card|studentId), then the student ID itself, then a roll number used by
+// only one student. Every student of a class that tapped in on a date is
+// marked, Present or Absent, in one section for that class and date;
+// classes with no taps that day are left alone. A class and date marked
+// before keeps its marks, except that students who tapped in are raised to
+// Present, so a later or fuller export of the same day picks up late
+// arrivals without ever marking anyone absent.
+class AttendanceImport
+{
+private:
+    struct Chunk
+    {
+        vector<uint64_t> taps;  // day << 32 | student
+        size_t lines = 0;
+        size_t unknownCards = 0;
+        size_t unreadable = 0;
+    };
+
+    vector<StudentRecord> students;
+    unordered_map<string, uint32_t> keys;
+
+    void loadKeys()
+    {
+        students = Schema::loadFile<StudentRecord>(Catalog::path("students.txt"));
+
+        // Roll numbers repeat across classes; only the unique ones identify a student
+        unordered_map<string, int64_t> rolls;
+        for (uint32_t i = 0; i < students.size(); ++i)
+        {
+            auto inserted = rolls.insert(make_pair(students[i].rollNo, static_cast<int64_t>(i)));
+            if (!inserted.second)
+                inserted.first->second = -1;
+        }
+        for (const auto& roll : rolls)
+        {
+            if (roll.second >= 0 && !roll.first.empty())
+                keys[roll.first] = static_cast<uint32_t>(roll.second);
+        }
+
+        unordered_map<string, uint32_t> byId;
+        for (uint32_t i = 0; i < students.size(); ++i)
+        {
+            byId[students[i].id] = i;
+            keys[students[i].id] = i;
+        }
+
+        for (const auto& line : Utils::splitString(Storage::readAll(Catalog::path("cards.txt")), '\n'))
+        {
+            vector<string> parts = Utils::parseRecord(line);
+            if (parts.size() < 2 || line[0] == '[')
+                continue;
+            auto student = byId.find(parts[1]);
+            if (student != byId.end())
+                keys[parts[0]] = student->second;
+        }
+    }
+
+    static string_view unquote(string_view field)
+    {
+        field = Schema::trim(field);
+        if (field.size() >= 2 && field.front() == '"' && field.back() == '"')
+            field = field.substr(1, field.size() - 2);
+        return field;
+    }
+
+    // Parse every line of one chunk
+    static void parseChunk(string_view text, const unordered_map<string, uint32_t>& keys, Chunk& chunk)
+    {
+        string card;
+        string date;
+        while (!text.empty())
+        {
+            size_t end = text.find('\n');
+            string_view line = text.substr(0, end);
+            text = end == string_view::npos ? string_view() : text.substr(end + 1);
+            if (!line.empty() && line.back() == '\r')
+                line.remove_suffix(1);
+            if (Schema::trim(line).empty())
+                continue;
+            chunk.lines++;
+
+            size_t separator = line.find_first_of(",;\t");
+            if (separator == string_view::npos)
+            {
+                chunk.unreadable++;
+                continue;
+            }
+            string_view stamp = unquote(line.substr(separator + 1, line.find_first_of(",;\t", separator + 1) - separator - 1));
+            date.assign(stamp.substr(0, 10));
+            if (date.size() == 10 && date[4] == '/' && date[7] == '/')
+                date[4] = date[7] = '-';
+            long day = Utils::dateToDays(date);
+            if (day <= 0)
+            {
+                chunk.unreadable++;
+                continue;
+            }
+
+            card.assign(unquote(line.substr(0, separator)));
+            auto student = keys.find(card);
+            if (student == keys.end())
+            {
+                chunk.unknownCards++;
+                continue;
+            }
+            chunk.taps.push_back(static_cast<uint64_t>(day) << 32 | student->second);
+        }
+    }
+
+public:
+    // Import one device export; sections go through SummaryStore in one commit
+    ImportResult run(const string& path)
+    {
+        ImportResult result;
+        loadKeys();
+        string text = Storage::readAll(path);
+
+        // Chunks end on line boundaries and are parsed in parallel
+        size_t workers = max(1u, thread::hardware_concurrency());
+        workers = min(workers, text.size() / (256 * 1024) + 1);
+        vector<size_t> bounds(1, 0);
+        for (size_t w = 1; w < workers; ++w)
+        {
+            size_t cut = text.find('\n', max(bounds.back(), text.size() * w / workers));
+            if (cut == string::npos)
+                break;
+            bounds.push_back(cut + 1);
+        }
+        bounds.push_back(text.size());
+
+        vector<Chunk> chunks(bounds.size() - 1);
+        vector<future<void>> jobs;
+        string_view all(text);
+        for (size_t c = 0; c < chunks.size(); ++c)
+        {
+            jobs.push_back(async(launch::async, parseChunk, all.substr(bounds[c], bounds[c + 1] - bounds[c]), cref(keys), ref(chunks[c])));
+        }
+        for (auto& job : jobs)
+            job.get();
+
+        vector<uint64_t> taps;
+        for (const auto& chunk : chunks)
+        {
+            result.lines += chunk.lines;
+            result.unknownCards += chunk.unknownCards;
+            result.unreadable += chunk.unreadable;
+            result.taps += chunk.taps.size();
+            taps.insert(taps.end(), chunk.taps.begin(), chunk.taps.end());
+        }
+
+        // One tap per student and day
+        sort(taps.begin(), taps.end());
+        taps.erase(unique(taps.begin(), taps.end()), taps.end());
+        result.repeatTaps = result.taps - taps.size();
+        if (taps.empty())
+            return result;
+
+        // Classes of each day with at least one tap, and what is already recorded
+        long firstDay = static_cast<long>(taps.front() >> 32);
+        long lastDay = static_cast<long>(taps.back() >> 32);
+        map<pair<string, string>, map<string, bool>> recorded;
+        AttendanceStore::instance().scan(DateRange{ firstDay, lastDay }, [&](const AttendanceEntry& e)
+            {
+            recorded[make_pair(e.date, e.className)][e.studentId] = e.present;
+            });
+
+        map<string, vector<uint32_t>> classes;
+        for (uint32_t i = 0; i < students.size(); ++i)
+            classes[students[i].className].push_back(i);
+
+        vector<AttendanceSheet> sheets;
+        vector<char> tapped(students.size(), 0);
+        for (size_t begin = 0; begin < taps.size();)
+        {
+            long day = static_cast<long>(taps[begin] >> 32);
+            size_t end = begin;
+            set<string> present;
+            for (; end < taps.size() && static_cast<long>(taps[end] >> 32) == day; ++end)
+            {
+                uint32_t student = static_cast<uint32_t>(taps[end]);
+                tapped[student] = 1;
+                present.insert(students[student].className);
+            }
+
+            string date = Utils::daysToDate(day);
+            for (const auto& className : present)
+            {
+                auto marked = recorded.find(make_pair(date, className));
+                if (marked != recorded.end())
+                {
+                    map<string, bool> merged = marked->second;
+                    size_t raised = 0;
+                    for (uint32_t student : classes[className])
+                    {
+                        bool& present = merged[students[student].id];
+                        if (tapped[student] && !present)
+                        {
+                            present = true;
+                            raised++;
+                        }
+                    }
+                    if (raised == 0)
+                    {
+                        result.alreadyMarked++;
+                        continue;
+                    }
+                    AttendanceSheet sheet{ date, className, {} };
+                    for (const auto& mark : merged)
+                        sheet.marks.push_back(AttendanceLine{ mark.first, mark.second ? "Present" : "Absent" });
+                    sheets.push_back(sheet);
+                    result.updated++;
+                    result.present += raised;
+                    continue;
+                }
+                AttendanceSheet sheet{ date, className, {} };
+                for (uint32_t student : classes[className])
+                {
+                    sheet.marks.push_back(AttendanceLine{ students[student].id, tapped[student] ? "Present" : "Absent" });
+                    if (tapped[student])
+                        result.present++;
+                    else
+                        result.absent++;
+                }
+                sheets.push_back(sheet);
+                result.sheets++;
+            }
+
+            for (size_t t = begin; t < end; ++t)
+                tapped[static_cast<uint32_t>(taps[t])] = 0;
+            begin = end;
+        }
+
+        if (!sheets.empty())
+            result.ok = SummaryStore::instance().commitAttendance(sheets);
+        return result;
+    }
+
+    static void printResult(const ImportResult& result)
+    {
+        string out;
+        out += to_string(result.lines) + " line(s), " + to_string(result.taps) + " tap(s) matched, " + to_string(result.repeatTaps) + " repeat tap(s) ignored\n";
+        if (result.unknownCards > 0)
+            out += to_string(result.unknownCards) + " tap(s) with an unknown card or roll number\n";
+        if (result.unreadable > 0)
+            out += to_string(result.unreadable) + " unreadable line(s)\n";
+        if (result.alreadyMarked > 0)
+            out += to_string(result.alreadyMarked) + " class day(s) already marked, nothing to change\n";
+        if (!result.ok)
+            out += "Error: the attendance could not be saved!\n";
+        else
+        {
+            out += to_string(result.sheets) + " class day(s) marked";
+            if (result.updated > 0)
+                out += ", " + to_string(result.updated) + " marked before updated";
+            out += ": " + to_string(result.present) + " present, " + to_string(result.absent) + " absent\n";
+        }
+        cout << out;
+    }
+};
+
+#endif
@@ -0,0 +1,580 @@
+#ifndef ATTENDANCE_STORE_H
+#define ATTENDANCE_STORE_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <functional>
+#include <mutex>
+#include <limits>
+#include <algorithm>
+
+#include "utils.h"
+#include "storage.h"
+#include "catalog.h"
+#include "compaction.h"
+#include "schema.h"
+
+using namespace std;
+
+// Inclusive range of days (see Utils::dateToDays)
+struct DateRange
+{
+    long from;
+    long to;
+
+    bool contains(long day) const
+    {
+        return day >= from && day <= to;
+    }
+
+    bool overlaps(long first, long last) const
+    {
+        return first <= to && last >= from;
+    }
+
+    static DateRange all()
+    {
+        return DateRange{ numeric_limits<long>::min(), numeric_limits<long>::max() };
+    }
+
+    static DateRange lastDays(int days)
+    {
+        long today = Utils::dateToDays(Utils::getCurrentDate());
+        return DateRange{ today - max(1, days) + 1, today };
+    }
+
+    // "YYYY-MM"
+    static DateRange month(const string& monthYear)
+    {
+        long first = Utils::dateToDays(monthYear + "-01");
+        if (first == 0)
+            return DateRange{ 1, 0 };
+        int y = stoi(monthYear.substr(0, 4));
+        int m = stoi(monthYear.substr(5, 2));
+        string next = m == 12 ? to_string(y + 1) + "-01" : to_string(y) + "-" + (m < 9 ? "0" : "") + to_string(m + 1);
+        return DateRange{ first, Utils::dateToDays(next + "-01") - 1 };
+    }
+
+    // Spring runs January to June, Fall July to December, e.g. "Fall-2023"
+    static DateRange term(const string& name)
+    {
+        size_t dash = name.find('-');
+        if (dash == string::npos)
+            return all();
+        string season = Utils::toLower(name.substr(0, dash));
+        string year = name.substr(dash + 1);
+        if (year.size() != 4 || !all_of(year.begin(), year.end(), ::isdigit))
+            return all();
+        if (season == "spring")
+            return DateRange{ Utils::dateToDays(year + "-01-01"), Utils::dateToDays(year + "-06-30") };
+        if (season == "fall")
+            return DateRange{ Utils::dateToDays(year + "-07-01"), Utils::dateToDays(year + "-12-31") };
+        return all();
+    }
+
+    static string currentTermName()
+    {
+        string today = Utils::getCurrentDate();
+        return (stoi(today.substr(5, 2)) <= 6 ? "Spring-" : "Fall-") + today.substr(0, 4);
+    }
+
+    static DateRange prompt()
+    {
+        cout << "1. Current term (" << currentTermName() << ")\n2. A month\n3. Last N days\n4. All records\nSelect range: ";
+        int choice;
+        if (!(cin >> choice))
+            choice = 4;
+        Utils::clearInputBuffer();
+
+        switch (choice)
+        {
+        case 1:
+            return term(currentTermName());
+        case 2:
+        {
+            string monthYear;
+            cout << "Enter month (YYYY-MM): ";
+            getline(cin, monthYear);
+            return month(monthYear);
+        }
+        case 3:
+        {
+            int days;
+            cout << "Enter number of days: ";
+            if (!(cin >> days))
+                days = 30;
+            Utils::clearInputBuffer();
+            return lastDays(days);
+        }
+        default:
+            return all();
+        }
+    }
+};
+
+// One class's [ATTENDANCE <date> CLASS <class>] section, ready to commit
+struct AttendanceSection
+{
+    string date;
+    string text;
+};
+
+struct AttendanceEntry
+{
+    string date;
+    string className;
+    string studentId;
+    bool present;
+};
+
+// Attendance split into one file per month under attendance/, with a manifest
+//   month|file|bytes|sections|firstDate|lastDate|sealed
+// Queries open only the partitions overlapping the requested range. Months
+// before the current one are sealed: compacted once, then never rewritten, so
+// their parsed form is cached for the rest of the session.
+class AttendanceStore
+{
+private:
+    struct Partition
+    {
+        string month;
+        string file;
+        long long bytes = 0;
+        size_t sections = 0;
+        string firstDate;
+        string lastDate;
+        bool sealed = false;
+    };
+
+    struct CachedPartition
+    {
+        long long bytes = -1;
+        vector<AttendanceEntry> entries;
+    };
+
+    const string directory = Catalog::subdirectory("attendance");
+    const string manifestPath = Catalog::path("attendance/manifest.txt");
+    const string legacyPath = Catalog::path("attendance.txt");
+
+    mutex cacheLock;
+    map<string, CachedPartition> cache;
+
+    static bool parseHeader(const string& header, string& date, string& className)
+    {
+        // [ATTENDANCE <date> CLASS <class>]
+        if (header.compare(0, 12, "[ATTENDANCE ") != 0 || header.size() < 23)
+            return false;
+        date = header.substr(12, 10);
+        size_t classPos = header.find(" CLASS ");
+        if (!Utils::validateDate(date) || classPos == string::npos)
+            return false;
+        className = header.substr(classPos + 7);
+        if (!className.empty() && className.back() == ']')
+            className.pop_back();
+        return true;
+    }
+
+    // False if the manifest is missing its header or has a line that does not parse
+    bool readManifest(map<string, Partition>& partitions) const
+    {
+        istringstream in(Storage::readAll(manifestPath));
+        string line;
+        if (!getline(in, line) || line.compare(0, 21, "[ATTENDANCE MANIFEST]") != 0)
+            return false;
+
+        while (getline(in, line))
+        {
+            if (!line.empty() && line.back() == '\r')
+                line.pop_back();
+            if (line.empty() || line[0] == '[')
+                continue;
+            vector<string> parts = Utils::parseRecord(line);
+            if (parts.size() < 7)
+                return false;
+
+            // The file column is relative to the data directory; older
+            // manifests held full paths, so the file is found from the month
+            Partition p;
+            p.month = parts[0];
+            p.file = partitionPath(p.month);
+            p.firstDate = parts[4];
+            p.lastDate = parts[5];
+            p.sealed = parts[6] == "1";
+            if (p.month.size() != 7 || !Utils::validateDate(p.month + "-01") || !Utils::validateDate(p.firstDate) || !Utils::validateDate(p.lastDate)
+                || !Schema::decodeInteger(parts[2], p.bytes) || !Schema::decodeInteger(parts[3], p.sections) || (parts[6] != "0" && parts[6] != "1"))
+                return false;
+            partitions[p.month] = p;
+        }
+        return true;
+    }
+
+    // Describe every YYYY-MM.txt partition in the attendance directory from
+    // its contents; they are compacted again before being sealed
+    map<string, Partition> scanPartitions() const
+    {
+        map<string, Partition> partitions;
+        for (const auto& name : Storage::listFiles(directory))
+        {
+            string month = name.substr(0, 7);
+            if (name.size() != 11 || name.compare(7, 4, ".txt") != 0 || !Utils::validateDate(month + "-01"))
+                continue;
+
+            Partition p;
+            p.month = month;
+            p.file = partitionPath(month);
+            p.bytes = max(0LL, Storage::fileSize(p.file));
+            for (const auto& section : Storage::parseSections(Storage::readAll(p.file)))
+            {
+                string date, className;
+                if (!parseHeader(section.header, date, className))
+                    continue;
+                p.sections++;
+                p.firstDate = p.firstDate.empty() ? date : min(p.firstDate, date);
+                p.lastDate = max(p.lastDate, date);
+            }
+            if (p.sections > 0)
+                partitions[month] = p;
+        }
+        return partitions;
+    }
+
+    // Caller holds the manifest lock. A damaged manifest is rebuilt from the partitions.
+    map<string, Partition> loadManifest() const
+    {
+        map<string, Partition> partitions;
+        if (readManifest(partitions))
+            return partitions;
+
+        partitions = scanPartitions();
+        saveManifest(partitions);
+        return partitions;
+    }
+
+    // Caller holds the manifest lock
+    void saveManifest(const map<string, Partition>& partitions) const
+    {
+        string content = "[ATTENDANCE MANIFEST]\n";
+        for (const auto& entry : partitions)
+        {
+            const Partition& p = entry.second;
+            content += p.month + "|" + partitionName(p.month) + "|" + to_string(p.bytes) + "|" + to_string(p.sections) + "|" + p.firstDate + "|" + p.lastDate + "|" + (p.sealed ? "1" : "0") + "\n";
+        }
+        Storage::writeAtomicLocked(manifestPath, content);
+    }
+
+    static string partitionName(const string& month)
+    {
+        return "attendance/" + month + ".txt";
+    }
+
+    string partitionPath(const string& month) const
+    {
+        return Catalog::path(partitionName(month));
+    }
+
+    // Parse a partition, keeping only the latest section per (date, class)
+    static vector<AttendanceEntry> parsePartition(const string& path)
+    {
+        vector<Storage::Section> sections = Storage::parseSections(Storage::readAll(path));
+        map<string, size_t> latest;
+        for (size_t i = 0; i < sections.size(); ++i)
+        {
+            latest[sections[i].header] = i;
+        }
+
+        vector<AttendanceEntry> entries;
+        for (size_t i = 0; i < sections.size(); ++i)
+        {
+            string date, className;
+            if (latest[sections[i].header] != i || !parseHeader(sections[i].header, date, className))
+                continue;
+
+            for (const auto& line : sections[i].lines)
+            {
+                AttendanceLine record;
+                if (Schema::parseLine(line, record))
+                    entries.push_back(AttendanceEntry{ date, className, record.studentId, record.status == "Present" });
+            }
+        }
+        return entries;
+    }
+
+    // Split attendance.txt into monthly partitions the first time the store is used
+    void migrateLegacy()
+    {
+        if (Storage::fileSize(manifestPath) >= 0)
+            return;
+        Storage::makeDirectory(directory);
+
+        lock_guard<mutex> legacyGuard(Storage::fileLock(legacyPath));
+        vector<Storage::Section> sections = Storage::parseSections(Storage::readAll(legacyPath));
+        map<string, vector<Storage::Section>> byMonth;
+        vector<Storage::Section> remaining;
+
+        for (auto& section : sections)
+        {
+            string date, className;
+            if (!parseHeader(section.header, date, className))
+            {
+                remaining.push_back(section);
+                continue;
+            }
+            if (section.committed.empty())
+                section.committed = date;
+            byMonth[date.substr(0, 7)].push_back(section);
+        }
+
+        lock_guard<mutex> guard(Storage::fileLock(manifestPath));
+        map<string, Partition> partitions;
+        for (const auto& month : byMonth)
+        {
+            Partition p;
+            p.month = month.first;
+            p.file = partitionPath(month.first);
+            p.sections = month.second.size();
+            p.firstDate = month.second.front().header.substr(12, 10);
+            p.lastDate = p.firstDate;
+            for (const auto& section : month.second)
+            {
+                string date = section.header.substr(12, 10);
+                p.firstDate = min(p.firstDate, date);
+                p.lastDate = max(p.lastDate, date);
+            }
+
+            string content = "[ATTENDANCE]\n" + Storage::formatSections(month.second, true);
+            Storage::writeAtomic(p.file, content);
+            p.bytes = static_cast<long long>(content.size());
+            partitions[p.month] = p;
+        }
+        saveManifest(partitions);
+
+        // attendance.txt keeps only what could not be placed in a month
+        if (!byMonth.empty())
+        {
+            if (remaining.empty())
+                remaining.push_back(Storage::Section{ "[ATTENDANCE]", {}, "" });
+            Storage::writeAtomicLocked(legacyPath, Storage::formatSections(remaining));
+        }
+    }
+
+    // Compact and seal partitions for months that have ended
+    void sealOldPartitions()
+    {
+        string currentMonth = Utils::getCurrentDate().substr(0, 7);
+        lock_guard<mutex> guard(Storage::fileLock(manifestPath));
+        map<string, Partition> partitions = loadManifest();
+        bool changed = false;
+
+        for (auto& entry : partitions)
+        {
+            Partition& p = entry.second;
+            if (p.sealed || p.month >= currentMonth)
+                continue;
+
+            CompactionRule rule{ p.file, [](const string& header) { return header; }, nullptr };
+            CompactionResult result = Compactor::compactFile(rule);
+            if (result.ok)
+            {
+                p.bytes = result.bytesAfter;
+                p.sections = result.sectionsAfter > 0 ? result.sectionsAfter - 1 : 0;
+            }
+            p.sealed = true;
+            changed = true;
+        }
+
+        if (changed)
+            saveManifest(partitions);
+    }
+
+    // Caller holds cacheLock
+    const vector<AttendanceEntry>& partitionEntries(const Partition& p)
+    {
+        CachedPartition& cached = cache[p.month];
+        long long bytes = p.sealed ? p.bytes : Storage::fileSize(p.file);
+        if (cached.bytes != bytes)
+        {
+            cached.entries = parsePartition(p.file);
+            cached.bytes = bytes;
+        }
+        return cached.entries;
+    }
+
+    AttendanceStore()
+    {
+        migrateLegacy();
+        sealOldPartitions();
+    }
+
+public:
+    static AttendanceStore& instance()
+    {
+        static AttendanceStore store;
+        return store;
+    }
+
+    // Commit class sections for their dates into the month partitions, with
+    // one append per partition and one manifest update
+    bool commit(const vector<AttendanceSection>& sections)
+    {
+        map<string, string> framed;
+        for (const auto& section : sections)
+            framed[section.date.substr(0, 7)] += Storage::frameSection(section.text, section.date);
+
+        lock_guard<mutex> guard(Storage::fileLock(manifestPath));
+        map<string, Partition> partitions = loadManifest();
+        for (const auto& section : sections)
+        {
+            string month = section.date.substr(0, 7);
+            Partition& p = partitions[month];
+            if (p.file.empty())
+            {
+                p.month = month;
+                p.file = partitionPath(month);
+                p.firstDate = section.date;
+                p.lastDate = section.date;
+            }
+            p.sections++;
+            p.firstDate = min(p.firstDate, section.date);
+            p.lastDate = max(p.lastDate, section.date);
+        }
+
+        bool ok = true;
+        for (const auto& month : framed)
+        {
+            Partition& p = partitions[month.first];
+            if (Storage::fileSize(p.file) < 0)
+                Storage::appendText(p.file, "[ATTENDANCE]\n");
+            ok = Storage::appendText(p.file, month.second) && ok;
+            p.bytes = Storage::fileSize(p.file);
+        }
+        saveManifest(partitions);
+        return ok;
+    }
+
+    // Visit the entries of every partition that overlaps the range
+    void scan(const DateRange& range, const function<void(const AttendanceEntry&)>& visit)
+    {
+        map<string, Partition> partitions;
+        {
+            lock_guard<mutex> guard(Storage::fileLock(manifestPath));
+            partitions = loadManifest();
+        }
+
+        lock_guard<mutex> guard(cacheLock);
+        for (const auto& entry : partitions)
+        {
+            const Partition& p = entry.second;
+            if (!range.overlaps(Utils::dateToDays(p.firstDate), Utils::dateToDays(p.lastDate)))
+                continue;
+
+            for (const auto& record : partitionEntries(p))
+            {
+                if (range.contains(Utils::dateToDays(record.date)))
+                    visit(record);
+            }
+        }
+    }
+
+    vector<AttendanceEntry> forStudent(const string& studentId, const DateRange& range)
+    {
+        vector<AttendanceEntry> result;
+        scan(range, [&](const AttendanceEntry& e)
+            {
+            if (e.studentId == studentId)
+                result.push_back(e);
+            });
+        return result;
+    }
+
+    // (present days, recorded days) for a student in the range
+    pair<int, int> summary(const string& studentId, const DateRange& range)
+    {
+        int present = 0, total = 0;
+        scan(range, [&](const AttendanceEntry& e)
+            {
+            if (e.studentId == studentId)
+            {
+                total++;
+                if (e.present)
+                    present++;
+            }
+            });
+        return make_pair(present, total);
+    }
+
+    // Sections of the sealed partitions lying entirely inside the range
+    vector<Storage::Section> sealedSections(const DateRange& range)
+    {
+        vector<Storage::Section> sections;
+        lock_guard<mutex> guard(Storage::fileLock(manifestPath));
+        for (const auto& entry : loadManifest())
+        {
+            const Partition& p = entry.second;
+            if (!p.sealed || !range.contains(Utils::dateToDays(p.firstDate)) || !range.contains(Utils::dateToDays(p.lastDate)))
+                continue;
+            for (auto& section : Storage::parseSections(Storage::readAll(p.file)))
+            {
+                if (!section.lines.empty())
+                    sections.push_back(section);
+            }
+        }
+        return sections;
+    }
+
+    // Remove the sealed partitions returned by sealedSections for the same range
+    long long dropSealed(const DateRange& range)
+    {
+        long long freed = 0;
+        lock_guard<mutex> guard(Storage::fileLock(manifestPath));
+        map<string, Partition> partitions = loadManifest();
+
+        for (auto it = partitions.begin(); it != partitions.end();)
+        {
+            const Partition& p = it->second;
+            if (p.sealed && range.contains(Utils::dateToDays(p.firstDate)) && range.contains(Utils::dateToDays(p.lastDate)))
+            {
+                freed += max(0LL, Storage::fileSize(p.file));
+                remove(p.file.c_str());
+                {
+                    lock_guard<mutex> cacheGuard(cacheLock);
+                    cache.erase(p.month);
+                }
+                it = partitions.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+        saveManifest(partitions);
+        return freed;
+    }
+
+    // Total size of the partition files, to notice changes made elsewhere
+    long long storedBytes()
+    {
+        long long total = 0;
+        lock_guard<mutex> guard(Storage::fileLock(manifestPath));
+        for (const auto& entry : loadManifest())
+            total += max(0LL, Storage::fileSize(entry.second.file));
+        return total;
+    }
+
+    // Compaction rules for the partitions that are still being written
+    vector<CompactionRule> compactionRules()
+    {
+        vector<CompactionRule> rules;
+        lock_guard<mutex> guard(Storage::fileLock(manifestPath));
+        for (const auto& entry : loadManifest())
+        {
+            if (!entry.second.sealed)
+                rules.push_back(CompactionRule{ entry.second.file, [](const string& header) { return header; }, nullptr });
+        }
+        return rules;
+    }
+};
+
+#endif
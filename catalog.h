@@ -0,0 +1,290 @@
+#ifndef CATALOG_H
+#define CATALOG_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+
+#include "utils.h"
+#include "storage.h"
+
+using namespace std;
+
+// Where the data files live and what is known about them. The directory
+// comes from --data-dir or LMS_DATA_DIR and defaults to the working
+// directory. Its catalog.txt records each file's state as of the last time
+// the program touched it:
+//   name|schema version|size|mtime|crc32
+// Files are resolved on first use and cached for the session; a known data
+// file that is missing is created with its banner at that point, so a
+// session only touches the files its menus actually read or write.
+namespace Catalog
+{
+    struct FileSpec
+    {
+        const char* name;
+        const char* banner;
+        int version;
+    };
+
+    struct Entry
+    {
+        int version = 0;
+        long long size = -1;
+        long long modified = 0;
+        uint32_t checksum = 0;
+    };
+
+    const vector<FileSpec>& knownFiles()
+    {
+        static const vector<FileSpec> files = {
+            { "students.txt", "[STUDENT RECORD]", 1 },
+            { "teachers.txt", "[TEACHER RECORD]", 1 },
+            { "timetable.txt", "[TIMETABLE]", 1 },
+            { "attendance.txt", "[ATTENDANCE]", 1 },
+            { "termReports.txt", "[TERM REPORTS]", 1 },
+            { "assignments_due.txt", "[ASSIGNMENTS]", 1 },
+            { "fees_ledger.txt", "[FEES LEDGER]", 1 },
+            { "staff.txt", "[STAFF RECORD]", 1 },
+            { "leave_requests.txt", "[LEAVE REQUESTS]", 1 },
+            { "parent_requests.txt", "[PARENT REQUESTS]", 1 },
+            { "fee_challans.txt", "[FEE CHALLANS]", 1 },
+            { "salary_payments.txt", "[STAFF SALARIES]", 1 },
+            { "grades.txt", "[GRADES]", 1 },
+            { "rooms.txt", "[ROOMS]", 1 },
+            { "cards.txt", "[CARDS]", 1 }
+        };
+        return files;
+    }
+
+    struct State
+    {
+        mutex lock;
+        string directory = ".";
+        map<string, Entry> manifest;
+        map<string, string> resolved; // files used this session
+        bool changed = false;
+    };
+
+    State& state()
+    {
+        static State s;
+        return s;
+    }
+
+    string join(const string& directory, const string& name)
+    {
+        return directory == "." ? name : directory + "/" + name;
+    }
+
+    const FileSpec* findSpec(const string& name)
+    {
+        for (const auto& spec : knownFiles())
+        {
+            if (name == spec.name)
+                return &spec;
+        }
+        return nullptr;
+    }
+
+    // Caller holds the state lock
+    void saveManifestLocked(State& s)
+    {
+        string content = "[DATA CATALOG]\n";
+        char checksum[16];
+        for (const auto& item : s.manifest)
+        {
+            const Entry& e = item.second;
+            snprintf(checksum, sizeof(checksum), "%08x", e.checksum);
+            content += item.first + "|" + to_string(e.version) + "|" + to_string(e.size) + "|" + to_string(e.modified) + "|" + checksum + "\n";
+        }
+        Storage::writeAtomic(join(s.directory, "catalog.txt"), content);
+        s.changed = false;
+    }
+
+    // Caller holds the state lock. content is the file as just written, or
+    // null to read it back.
+    void stampLocked(State& s, const string& name, const string* content)
+    {
+        string path = join(s.directory, name);
+        Entry entry;
+        const FileSpec* spec = findSpec(name);
+        entry.version = spec ? spec->version : 1;
+        if (!Storage::fileStamp(path, entry.size, entry.modified))
+        {
+            s.changed = s.manifest.erase(name) > 0 || s.changed;
+            return;
+        }
+        if (content)
+        {
+            entry.checksum = Storage::crc32(content->data(), content->size());
+        }
+        else
+        {
+            string text = Storage::readAll(path);
+            entry.checksum = Storage::crc32(text.data(), text.size());
+        }
+        s.manifest[name] = entry;
+        s.changed = true;
+    }
+
+    // Point the catalog at directory, creating it if needed, and read its manifest
+    bool open(const string& directory)
+    {
+        State& s = state();
+        lock_guard<mutex> guard(s.lock);
+        s.directory = directory.empty() ? "." : directory;
+        while (s.directory.size() > 1 && (s.directory.back() == '/' || s.directory.back() == '\\'))
+            s.directory.pop_back();
+        s.manifest.clear();
+        s.resolved.clear();
+        if (!Storage::makeDirectory(s.directory))
+            return false;
+
+        for (const auto& line : Utils::splitString(Storage::readAll(join(s.directory, "catalog.txt")), '\n'))
+        {
+            vector<string> parts = Utils::parseRecord(line);
+            if (parts.size() < 5 || parts[0].empty() || parts[0][0] == '[')
+                continue;
+            Entry e;
+            e.version = atoi(parts[1].c_str());
+            e.size = atoll(parts[2].c_str());
+            e.modified = atoll(parts[3].c_str());
+            e.checksum = static_cast<uint32_t>(strtoul(parts[4].c_str(), nullptr, 16));
+            s.manifest[parts[0]] = e;
+        }
+        return true;
+    }
+
+    // --data-dir <dir> wins over LMS_DATA_DIR; the option is removed from args
+    string chooseDirectory(vector<string>& args)
+    {
+        for (size_t i = 0; i + 1 < args.size(); ++i)
+        {
+            if (args[i] == "--data-dir")
+            {
+                string directory = args[i + 1];
+                args.erase(args.begin() + i, args.begin() + i + 2);
+                return directory;
+            }
+        }
+        const char* env = getenv("LMS_DATA_DIR");
+        return env && *env ? string(env) : string(".");
+    }
+
+    const string& directory()
+    {
+        return state().directory;
+    }
+
+    // Full path of a file in the data directory, creating a known data file
+    // with its banner the first time it is asked for
+    string path(const string& name)
+    {
+        State& s = state();
+        lock_guard<mutex> guard(s.lock);
+        auto cached = s.resolved.find(name);
+        if (cached != s.resolved.end())
+            return cached->second;
+
+        string full = join(s.directory, name);
+        const FileSpec* spec = findSpec(name);
+        if (spec && Storage::fileSize(full) < 0)
+        {
+            Storage::writeAtomic(full, string(spec->banner) + "\n");
+            stampLocked(s, name, nullptr);
+        }
+        else if (spec && s.manifest.count(name) && s.manifest[name].version > spec->version)
+        {
+            cerr << "Warning: " << name << " was written by a newer version (schema " << s.manifest[name].version << ")" << endl;
+        }
+        s.resolved[name] = full;
+        return full;
+    }
+
+    // Subdirectory of the data directory, created if missing; not tracked
+    string subdirectory(const string& name)
+    {
+        string full = join(directory(), name);
+        Storage::makeDirectory(full);
+        return full;
+    }
+
+    // Record a file's current state, e.g. after writing an index or archive
+    void record(const string& name, const string& content)
+    {
+        State& s = state();
+        lock_guard<mutex> guard(s.lock);
+        stampLocked(s, name, &content);
+        saveManifestLocked(s);
+    }
+
+    void record(const string& name)
+    {
+        State& s = state();
+        lock_guard<mutex> guard(s.lock);
+        stampLocked(s, name, nullptr);
+        saveManifestLocked(s);
+    }
+
+    // True if the file still has the content last recorded for it. A file
+    // whose size and mtime are unchanged is trusted without being read;
+    // otherwise its checksum is recomputed. Files never recorded pass.
+    bool verify(const string& name)
+    {
+        State& s = state();
+        lock_guard<mutex> guard(s.lock);
+        auto it = s.manifest.find(name);
+        if (it == s.manifest.end())
+            return true;
+
+        string full = join(s.directory, name);
+        long long size = -1;
+        long long modified = 0;
+        if (!Storage::fileStamp(full, size, modified))
+            return false;
+        if (size == it->second.size && modified == it->second.modified)
+            return true;
+        if (size != it->second.size)
+            return false;
+
+        string text = Storage::readAll(full);
+        if (Storage::crc32(text.data(), text.size()) != it->second.checksum)
+            return false;
+        it->second.modified = modified;
+        s.changed = true;
+        return true;
+    }
+
+    // Bring the manifest up to date for the known data files used this
+    // session; only files whose size or mtime moved are read. Indexes and
+    // archives are stamped only by record() when they are written, so one
+    // changed behind the program's back keeps failing verify().
+    void save()
+    {
+        State& s = state();
+        lock_guard<mutex> guard(s.lock);
+        for (const auto& item : s.resolved)
+        {
+            if (!findSpec(item.first))
+                continue;
+            long long size = -1;
+            long long modified = 0;
+            bool exists = Storage::fileStamp(item.second, size, modified);
+            auto it = s.manifest.find(item.first);
+            if (!exists && it == s.manifest.end())
+                continue;
+            if (exists && it != s.manifest.end() && it->second.size == size && it->second.modified == modified)
+                continue;
+            stampLocked(s, item.first, nullptr);
+        }
+        if (s.changed)
+            saveManifestLocked(s);
+    }
+}
+
+#endif
@@ -0,0 +1,292 @@
+#ifndef COMPACTION_H
+#define COMPACTION_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <functional>
+#include <future>
+#include <chrono>
+#include <iomanip>
+#include <mutex>
+#include <ctime>
+#include <cstdint>
+
+#include "utils.h"
+#include "storage.h"
+#include "catalog.h"
+
+using namespace std;
+
+// How superseded data is recognised in one append-only file.
+// sectionKey: sections with the same key replace each other (latest wins).
+// lineKey:    if set, sections are kept and individual lines are deduplicated
+//             across the file instead (latest line per key wins).
+struct CompactionRule
+{
+    string fileName;
+    function<string(const string& header)> sectionKey;
+    function<string(const vector<string>& parts)> lineKey;
+};
+
+struct CompactionResult
+{
+    string fileName;
+    long long bytesBefore = 0;
+    long long bytesAfter = 0;
+    size_t sectionsBefore = 0;
+    size_t sectionsAfter = 0;
+    bool ok = false;
+};
+
+class Compactor
+{
+private:
+    static string joinFields(const vector<string>& parts, size_t count)
+    {
+        vector<string> head(parts.begin(), parts.begin() + min(count, parts.size()));
+        return Utils::joinString(head, "|");
+    }
+
+    static vector<Storage::Section> keepLatestSections(const vector<Storage::Section>& sections, const CompactionRule& rule)
+    {
+        unordered_map<string, size_t> latest;
+        for (size_t i = 0; i < sections.size(); ++i)
+        {
+            latest[rule.sectionKey(sections[i].header)] = i;
+        }
+
+        vector<Storage::Section> kept;
+        for (size_t i = 0; i < sections.size(); ++i)
+        {
+            if (latest[rule.sectionKey(sections[i].header)] == i)
+                kept.push_back(sections[i]);
+        }
+        return kept;
+    }
+
+    static vector<Storage::Section> keepLatestLines(const vector<Storage::Section>& sections, const CompactionRule& rule)
+    {
+        // Position of the latest line for each key
+        unordered_map<string, pair<size_t, size_t>> latest;
+        for (size_t s = 0; s < sections.size(); ++s)
+        {
+            for (size_t l = 0; l < sections[s].lines.size(); ++l)
+            {
+                string key = rule.lineKey(Utils::parseRecord(sections[s].lines[l]));
+                if (!key.empty())
+                    latest[key] = make_pair(s, l);
+            }
+        }
+
+        vector<Storage::Section> kept;
+        for (size_t s = 0; s < sections.size(); ++s)
+        {
+            Storage::Section section{ sections[s].header, {}, sections[s].committed };
+            for (size_t l = 0; l < sections[s].lines.size(); ++l)
+            {
+                string key = rule.lineKey(Utils::parseRecord(sections[s].lines[l]));
+                if (key.empty() || latest[key] == make_pair(s, l))
+                    section.lines.push_back(sections[s].lines[l]);
+            }
+            // The first section is the file banner and is always kept
+            if (s == 0 || !section.lines.empty())
+                kept.push_back(section);
+        }
+        return kept;
+    }
+
+public:
+    static vector<CompactionRule> defaultRules()
+    {
+        auto byHeader = [](const string& header) { return header; };
+
+        return {
+            // [ATTENDANCE <date> CLASS <class>]
+            { Catalog::path("attendance.txt"), byHeader, nullptr },
+            // [GRADES <type> CLASS <class> TEACHER <id>]
+            { Catalog::path("grades.txt"), byHeader, nullptr },
+            // [TERM REPORTS <term> CLASS <class>]
+            { Catalog::path("termReports.txt"), byHeader, nullptr },
+            // id|name|amount|date -> one payment per employee per month
+            { Catalog::path("salary_payments.txt"), byHeader, [](const vector<string>& p) {
+                return p.size() >= 4 ? p[0] + "|" + p[3].substr(0, 7) : string();
+            } },
+            // id|name|class|month|amount|status -> one challan per student per month
+            { Catalog::path("fee_challans.txt"), byHeader, [](const vector<string>& p) {
+                return p.size() >= 6 ? p[0] + "|" + p[3] : string();
+            } },
+            // teacherId|name|start|end|reason|status
+            { Catalog::path("leave_requests.txt"), byHeader, [](const vector<string>& p) {
+                return p.size() >= 6 ? joinFields(p, 5) : string();
+            } },
+            // childId|parent|type|note|status[|requestId|submitted]
+            { Catalog::path("parent_requests.txt"), byHeader, [](const vector<string>& p) {
+                if (p.size() >= 7)
+                    return "#" + p[5];
+                return p.size() >= 5 ? joinFields(p, 4) : string();
+            } },
+        };
+    }
+
+    // What a rewrite was computed from: the bytes read, plus the stamp
+    // needed to tell under the lock whether the file has only grown since
+    struct Snapshot
+    {
+        long long size = -1;
+        long long modified = 0;
+        long long takenAt = 0;
+        uint32_t crc = 0;
+        string text;
+    };
+
+    // False if the file is missing or was replaced while it was being read
+    static bool takeSnapshot(const string& fileName, Snapshot& snapshot)
+    {
+        {
+            lock_guard<mutex> guard(Storage::fileLock(fileName));
+            if (!Storage::fileStamp(fileName, snapshot.size, snapshot.modified))
+                return false;
+            snapshot.takenAt = static_cast<long long>(time(nullptr));
+        }
+        snapshot.text = Storage::readRange(fileName, 0, snapshot.size);
+        snapshot.crc = Storage::crc32(snapshot.text.data(), snapshot.text.size());
+        return static_cast<long long>(snapshot.text.size()) == snapshot.size;
+    }
+
+    // Caller holds the file lock. True if the file is still the snapshot,
+    // possibly with bytes appended; a rewrite in between fails the check.
+    // Size and mtime alone are trusted only when the mtime is from an
+    // earlier second than the snapshot, as a later write would change it.
+    static bool onlyAppendedSince(const string& fileName, const Snapshot& snapshot, long long& currentSize)
+    {
+        long long modified = 0;
+        if (!Storage::fileStamp(fileName, currentSize, modified) || currentSize < snapshot.size)
+            return false;
+        if (currentSize == snapshot.size && modified == snapshot.modified && modified < snapshot.takenAt)
+            return true;
+        string prefix = Storage::readRange(fileName, 0, snapshot.size);
+        return static_cast<long long>(prefix.size()) == snapshot.size && Storage::crc32(prefix.data(), prefix.size()) == snapshot.crc;
+    }
+
+    // Rewrite a file as keep(its sections). The file is read and rewritten
+    // without the lock; under the lock, bytes appended meanwhile are copied
+    // over just before the atomic swap, so readers and writers are never
+    // held for the duration. If the file was rewritten by someone else in
+    // the meantime the work is redone, and given up after a few tries.
+    static CompactionResult rewrite(const string& fileName, const function<vector<Storage::Section>(const vector<Storage::Section>&)>& keep)
+    {
+        CompactionResult result;
+        result.fileName = fileName;
+
+        for (int attempt = 0; attempt < 3; ++attempt)
+        {
+            Snapshot snapshot;
+            if (!takeSnapshot(fileName, snapshot))
+            {
+                if (snapshot.size < 0)
+                    return result;
+                continue;
+            }
+            result.bytesBefore = snapshot.size;
+
+            vector<Storage::Section> sections = Storage::parseSections(snapshot.text);
+            vector<Storage::Section> kept = keep(sections);
+            result.sectionsBefore = sections.size();
+            result.sectionsAfter = kept.size();
+            string content = Storage::formatSections(kept, true);
+
+            lock_guard<mutex> guard(Storage::fileLock(fileName));
+            long long currentSize = 0;
+            if (!onlyAppendedSince(fileName, snapshot, currentSize))
+                continue;
+            if (currentSize > snapshot.size)
+                content += Storage::readRange(fileName, snapshot.size, currentSize - snapshot.size);
+
+            result.ok = Storage::writeAtomicLocked(fileName, content);
+            result.bytesAfter = result.ok ? static_cast<long long>(content.size()) : result.bytesBefore;
+            return result;
+        }
+
+        result.ok = false;
+        result.bytesAfter = result.bytesBefore;
+        return result;
+    }
+
+    // Rewrites one file keeping only the latest data per logical key
+    static CompactionResult compactFile(const CompactionRule& rule)
+    {
+        return rewrite(rule.fileName, [&rule](const vector<Storage::Section>& sections)
+            {
+            return rule.lineKey ? keepLatestLines(sections, rule) : keepLatestSections(sections, rule);
+            });
+    }
+
+    // Drop the sections matching take, using the same snapshot and swap as compaction
+    static CompactionResult removeSections(const string& fileName, const function<bool(const Storage::Section&)>& take)
+    {
+        return rewrite(fileName, [&take](const vector<Storage::Section>& sections)
+            {
+            vector<Storage::Section> kept;
+            for (const auto& section : sections)
+            {
+                if (!take(section))
+                    kept.push_back(section);
+            }
+            return kept;
+            });
+    }
+
+    static vector<CompactionResult> compactAll(const vector<CompactionRule>& rules)
+    {
+        vector<CompactionResult> results;
+        for (const auto& rule : rules)
+        {
+            results.push_back(compactFile(rule));
+        }
+        return results;
+    }
+
+    // One background job at a time; results are collected on the next call
+    static future<vector<CompactionResult>>& backgroundJob()
+    {
+        static future<vector<CompactionResult>> job;
+        return job;
+    }
+
+    static bool startBackground(const vector<CompactionRule>& rules)
+    {
+        future<vector<CompactionResult>>& job = backgroundJob();
+        if (job.valid() && job.wait_for(chrono::seconds(0)) != future_status::ready)
+            return false;
+
+        job = async(launch::async, compactAll, rules);
+        return true;
+    }
+
+    static void printResults(const vector<CompactionResult>& results)
+    {
+        for (const auto& r : results)
+        {
+            if (!r.ok)
+                continue;
+            cout << left << setw(22) << r.fileName << r.sectionsBefore << " -> " << r.sectionsAfter << " sections, " << r.bytesBefore << " -> " << r.bytesAfter << " bytes\n";
+        }
+    }
+
+    // Report a finished job, or block until it finishes when wait is set
+    static void collectBackground(bool wait)
+    {
+        future<vector<CompactionResult>>& job = backgroundJob();
+        if (!job.valid())
+            return;
+        if (!wait && job.wait_for(chrono::seconds(0)) != future_status::ready)
+            return;
+
+        cout << "\nBackground compaction finished:\n";
+        printResults(job.get());
+    }
+};
+
+#endif
@@ -0,0 +1,555 @@
+#ifndef CREDENTIALS_H
+#define CREDENTIALS_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <random>
+#include <cstring>
+#include <cstddef>
+#include <cstdint>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#endif
+
+#include "storage.h"
+#include "catalog.h"
+
+using namespace std;
+
+// SHA-256 and the PBKDF2-HMAC-SHA256 password hash built on it
+namespace Sha256
+{
+    struct Context
+    {
+        uint32_t state[8];
+        uint64_t length = 0;
+        unsigned char block[64];
+        size_t used = 0;
+    };
+
+    uint32_t rotate(uint32_t x, int n)
+    {
+        return (x >> n) | (x << (32 - n));
+    }
+
+    void compress(uint32_t state[8], const unsigned char block[64])
+    {
+        static const uint32_t k[64] = {
+            0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+            0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+            0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+            0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+            0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+            0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+            0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+            0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+        };
+
+        uint32_t w[64];
+        for (int i = 0; i < 16; ++i)
+        {
+            w[i] = (uint32_t(block[i * 4]) << 24) | (uint32_t(block[i * 4 + 1]) << 16) | (uint32_t(block[i * 4 + 2]) << 8) | uint32_t(block[i * 4 + 3]);
+        }
+        for (int i = 16; i < 64; ++i)
+        {
+            uint32_t s0 = rotate(w[i - 15], 7) ^ rotate(w[i - 15], 18) ^ (w[i - 15] >> 3);
+            uint32_t s1 = rotate(w[i - 2], 17) ^ rotate(w[i - 2], 19) ^ (w[i - 2] >> 10);
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+
+        uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+        uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+        for (int i = 0; i < 64; ++i)
+        {
+            uint32_t t1 = h + (rotate(e, 6) ^ rotate(e, 11) ^ rotate(e, 25)) + ((e & f) ^ (~e & g)) + k[i] + w[i];
+            uint32_t t2 = (rotate(a, 2) ^ rotate(a, 13) ^ rotate(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+            h = g;
+            g = f;
+            f = e;
+            e = d + t1;
+            d = c;
+            c = b;
+            b = a;
+            a = t1 + t2;
+        }
+        state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+        state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+    }
+
+    void init(Context& ctx)
+    {
+        static const uint32_t initial[8] = { 0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19 };
+        memcpy(ctx.state, initial, sizeof(initial));
+        ctx.length = 0;
+        ctx.used = 0;
+    }
+
+    void update(Context& ctx, const void* data, size_t size)
+    {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        ctx.length += size;
+        while (size > 0)
+        {
+            size_t take = min(size, sizeof(ctx.block) - ctx.used);
+            memcpy(ctx.block + ctx.used, bytes, take);
+            ctx.used += take;
+            bytes += take;
+            size -= take;
+            if (ctx.used == sizeof(ctx.block))
+            {
+                compress(ctx.state, ctx.block);
+                ctx.used = 0;
+            }
+        }
+    }
+
+    void finish(Context& ctx, unsigned char digest[32])
+    {
+        uint64_t bits = ctx.length * 8;
+        unsigned char pad = 0x80;
+        update(ctx, &pad, 1);
+        pad = 0;
+        while (ctx.used != 56)
+            update(ctx, &pad, 1);
+        unsigned char length[8];
+        for (int i = 0; i < 8; ++i)
+            length[i] = static_cast<unsigned char>(bits >> (56 - i * 8));
+        update(ctx, length, 8);
+        for (int i = 0; i < 8; ++i)
+        {
+            digest[i * 4] = static_cast<unsigned char>(ctx.state[i] >> 24);
+            digest[i * 4 + 1] = static_cast<unsigned char>(ctx.state[i] >> 16);
+            digest[i * 4 + 2] = static_cast<unsigned char>(ctx.state[i] >> 8);
+            digest[i * 4 + 3] = static_cast<unsigned char>(ctx.state[i]);
+        }
+    }
+
+    void hash(const void* data, size_t size, unsigned char digest[32])
+    {
+        Context ctx;
+        init(ctx);
+        update(ctx, data, size);
+        finish(ctx, digest);
+    }
+
+    // HMAC keys are padded once; each iteration then costs two compressions
+    // for the inner and outer hash instead of re-deriving the pads
+    struct Hmac
+    {
+        Context inner;
+        Context outer;
+
+        Hmac(const void* key, size_t size)
+        {
+            unsigned char block[64] = {};
+            if (size > sizeof(block))
+                hash(key, size, block);
+            else
+                memcpy(block, key, size);
+
+            unsigned char pad[64];
+            init(inner);
+            for (int i = 0; i < 64; ++i)
+                pad[i] = block[i] ^ 0x36;
+            update(inner, pad, sizeof(pad));
+            init(outer);
+            for (int i = 0; i < 64; ++i)
+                pad[i] = block[i] ^ 0x5c;
+            update(outer, pad, sizeof(pad));
+        }
+
+        void mac(const void* data, size_t size, unsigned char out[32]) const
+        {
+            Context ctx = inner;
+            update(ctx, data, size);
+            unsigned char innerDigest[32];
+            finish(ctx, innerDigest);
+            ctx = outer;
+            update(ctx, innerDigest, sizeof(innerDigest));
+            finish(ctx, out);
+        }
+    };
+
+    // First 32-byte block of PBKDF2-HMAC-SHA256
+    void pbkdf2(const string& password, const unsigned char* salt, size_t saltSize, uint32_t iterations, unsigned char out[32])
+    {
+        Hmac hmac(password.data(), password.size());
+        unsigned char first[128];
+        memcpy(first, salt, saltSize);
+        first[saltSize] = 0;
+        first[saltSize + 1] = 0;
+        first[saltSize + 2] = 0;
+        first[saltSize + 3] = 1;
+
+        unsigned char u[32];
+        hmac.mac(first, saltSize + 4, u);
+        memcpy(out, u, sizeof(u));
+        for (uint32_t i = 1; i < iterations; ++i)
+        {
+            hmac.mac(u, sizeof(u), u);
+            for (int j = 0; j < 32; ++j)
+                out[j] ^= u[j];
+        }
+    }
+}
+
+enum class LoginResult
+{
+    Accepted,
+    Rejected,
+    Unknown, // no account yet for this role and username
+    Issued  // a one-time code matched; the user must now choose a password
+};
+
+// Accounts keyed by (role, username) in an open-addressing table stored in
+// credentials.db and memory-mapped read-only. A slot holds the first 16
+// bytes of SHA-256(role, username), a random salt and the PBKDF2 hash of
+// the password. Lookup hashes the key once and probes linearly; a missing
+// account costs the same password hash and comparison as a wrong password,
+// so the response time does not tell which accounts exist. Accounts are
+// only created by issuing a one-time code (an admin, or "lms issue-code"
+// for the first admin); the code's slot is replaced by the password the
+// user chooses at their first login.
+//
+//   header   magic, capacity (power of two), count, accounts per role
+//   slots    capacity x 72 bytes: key[16] salt[16] hash[32] iterations used
+class CredentialStore
+{
+private:
+    static const size_t headerSize = 64;
+    static const size_t slotSize = 72;
+    static const size_t keySize = 16;
+    static const size_t saltSize = 16;
+    static const uint32_t defaultIterations = 20000;
+
+    struct Slot
+    {
+        unsigned char key[keySize];
+        unsigned char salt[saltSize];
+        unsigned char hash[32];
+        uint32_t iterations;
+        uint32_t used;          // 0 empty, 1 password, 2 one-time code
+    };
+    static_assert(sizeof(Slot) == 72, "slot layout must match the file");
+
+    static const char* const* roles()
+    {
+        static const char* const names[] = { "admin", "teacher", "student", "parent", "principal", nullptr };
+        return names;
+    }
+
+    // Offset of the role's account count in the header
+    static size_t roleOffset(const string& role)
+    {
+        const char* const* names = roles();
+        for (size_t i = 0; names[i]; ++i)
+        {
+            if (role == names[i])
+                return 24 + i * 4;
+        }
+        return 0;
+    }
+
+    string path;
+    const unsigned char* mapped = nullptr;
+    size_t mappedSize = 0;
+    uint64_t capacity = 0;
+    uint64_t count = 0;
+#ifdef _WIN32
+    HANDLE fileHandle = INVALID_HANDLE_VALUE;
+    HANDLE mappingHandle = nullptr;
+#endif
+
+    static void makeKey(const string& role, const string& username, unsigned char key[keySize])
+    {
+        string text = role + '\0' + username;
+        unsigned char digest[32];
+        Sha256::hash(text.data(), text.size(), digest);
+        memcpy(key, digest, keySize);
+    }
+
+    static uint64_t slotIndex(const unsigned char key[keySize], uint64_t capacity)
+    {
+        uint64_t h;
+        memcpy(&h, key, sizeof(h));
+        return h & (capacity - 1);
+    }
+
+    // Differences anywhere in the buffers take the same time to find
+    static bool equalBytes(const unsigned char* a, const unsigned char* b, size_t size)
+    {
+        unsigned char diff = 0;
+        for (size_t i = 0; i < size; ++i)
+            diff |= a[i] ^ b[i];
+        return diff == 0;
+    }
+
+    static string emptyFile(uint64_t slots)
+    {
+        string content(headerSize + slots * slotSize, '\0');
+        memcpy(&content[0], "LMSCRED1", 8);
+        memcpy(&content[8], &slots, sizeof(slots));
+        return content;
+    }
+
+    void unmap()
+    {
+        if (!mapped)
+            return;
+#ifdef _WIN32
+        UnmapViewOfFile(mapped);
+        CloseHandle(mappingHandle);
+        CloseHandle(fileHandle);
+        fileHandle = INVALID_HANDLE_VALUE;
+        mappingHandle = nullptr;
+#else
+        munmap(const_cast<unsigned char*>(mapped), mappedSize);
+#endif
+        mapped = nullptr;
+        mappedSize = 0;
+        capacity = 0;
+        count = 0;
+    }
+
+    bool map()
+    {
+        unmap();
+        long long size = Storage::fileSize(path);
+        if (size < static_cast<long long>(headerSize))
+            return false;
+#ifdef _WIN32
+        fileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (fileHandle == INVALID_HANDLE_VALUE)
+            return false;
+        mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        void* view = mappingHandle ? MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0) : nullptr;
+        if (!view)
+        {
+            if (mappingHandle)
+                CloseHandle(mappingHandle);
+            CloseHandle(fileHandle);
+            fileHandle = INVALID_HANDLE_VALUE;
+            mappingHandle = nullptr;
+            return false;
+        }
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return false;
+        void* view = mmap(nullptr, static_cast<size_t>(size), PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (view == MAP_FAILED)
+            return false;
+#endif
+        mapped = static_cast<const unsigned char*>(view);
+        mappedSize = static_cast<size_t>(size);
+
+        uint64_t slots;
+        memcpy(&slots, mapped + 8, sizeof(slots));
+        if (memcmp(mapped, "LMSCRED1", 8) != 0 || slots == 0 || (slots & (slots - 1)) != 0 || headerSize + slots * slotSize > mappedSize)
+        {
+            unmap();
+            return false;
+        }
+        capacity = slots;
+        memcpy(&count, mapped + 16, sizeof(count));
+        return true;
+    }
+
+    Slot slotAt(uint64_t index) const
+    {
+        Slot slot;
+        memcpy(&slot, mapped + headerSize + index * slotSize, slotSize);
+        return slot;
+    }
+
+    // Slot holding key, or the empty slot where it would go
+    uint64_t probe(const unsigned char key[keySize], bool& found) const
+    {
+        uint64_t index = slotIndex(key, capacity);
+        for (uint64_t step = 0; step < capacity; ++step)
+        {
+            Slot slot = slotAt(index);
+            if (!slot.used)
+                break;
+            if (equalBytes(slot.key, key, keySize))
+            {
+                found = true;
+                return index;
+            }
+            index = (index + 1) & (capacity - 1);
+        }
+        found = false;
+        return index;
+    }
+
+    // Rewrite the table at twice the size; caller holds the file lock
+    bool grow()
+    {
+        uint64_t slots = capacity * 2;
+        string content = emptyFile(slots);
+        for (uint64_t i = 0; i < capacity; ++i)
+        {
+            Slot slot = slotAt(i);
+            if (!slot.used)
+                continue;
+            uint64_t index = slotIndex(slot.key, slots);
+            while (content[headerSize + index * slotSize + offsetof(Slot, used)] != 0)
+                index = (index + 1) & (slots - 1);
+            memcpy(&content[headerSize + index * slotSize], &slot, slotSize);
+        }
+        memcpy(&content[16], mapped + 16, headerSize - 16);
+        unmap();
+        return Storage::writeAtomicLocked(path, content) && map();
+    }
+
+    // Write one slot in place, plus the counts if it is a new account; the
+    // shared mapping sees the change
+    bool writeSlot(uint64_t index, const Slot& slot, bool added, size_t roleCount)
+    {
+        FILE* file = fopen(path.c_str(), "r+b");
+        if (!file)
+            return false;
+        bool ok = fseek(file, static_cast<long>(headerSize + index * slotSize), SEEK_SET) == 0 && fwrite(&slot, slotSize, 1, file) == 1;
+        if (added)
+        {
+            uint64_t newCount = count + 1;
+            uint32_t newRoleCount = 0;
+            if (roleCount)
+            {
+                memcpy(&newRoleCount, mapped + roleCount, sizeof(newRoleCount));
+                newRoleCount++;
+            }
+            ok = ok && fseek(file, 16, SEEK_SET) == 0 && fwrite(&newCount, sizeof(newCount), 1, file) == 1;
+            if (roleCount)
+                ok = ok && fseek(file, static_cast<long>(roleCount), SEEK_SET) == 0 && fwrite(&newRoleCount, sizeof(newRoleCount), 1, file) == 1;
+        }
+        ok = fclose(file) == 0 && ok;
+        if (ok && added)
+            count++;
+        return ok;
+    }
+
+public:
+    explicit CredentialStore(const string& name = "credentials.db") : path(Catalog::path(name)) {}
+
+    ~CredentialStore()
+    {
+        unmap();
+    }
+
+    CredentialStore(const CredentialStore&) = delete;
+    CredentialStore& operator=(const CredentialStore&) = delete;
+
+    // Map the table, creating an empty one on first use
+    bool open()
+    {
+        if (map())
+            return true;
+        lock_guard<mutex> guard(Storage::fileLock(path));
+        if (Storage::fileSize(path) < 0 && !Storage::writeAtomicLocked(path, emptyFile(1024)))
+            return false;
+        return map();
+    }
+
+    size_t size() const
+    {
+        return static_cast<size_t>(count);
+    }
+
+    static bool isRole(const string& role)
+    {
+        return roleOffset(role) != 0;
+    }
+
+    // Whether any account of the role exists yet
+    bool hasAccounts(const string& role) const
+    {
+        size_t offset = roleOffset(role);
+        uint32_t accounts = 0;
+        if (mapped && offset)
+            memcpy(&accounts, mapped + offset, sizeof(accounts));
+        return accounts > 0;
+    }
+
+    LoginResult verify(const string& role, const string& username, const string& password) const
+    {
+        static const unsigned char dummySalt[saltSize] = {};
+        unsigned char key[keySize];
+        makeKey(role, username, key);
+
+        bool found = false;
+        Slot slot = {};
+        if (mapped)
+        {
+            uint64_t index = probe(key, found);
+            if (found)
+                slot = slotAt(index);
+        }
+        if (!found)
+        {
+            memcpy(slot.salt, dummySalt, saltSize);
+            slot.iterations = defaultIterations;
+        }
+
+        unsigned char hash[32];
+        Sha256::pbkdf2(password, slot.salt, saltSize, slot.iterations, hash);
+        bool match = equalBytes(hash, slot.hash, sizeof(hash));
+        if (!found)
+            return LoginResult::Unknown;
+        if (!match)
+            return LoginResult::Rejected;
+        return slot.used == 2 ? LoginResult::Issued : LoginResult::Accepted;
+    }
+
+    static CredentialStore& instance()
+    {
+        static CredentialStore store;
+        return store;
+    }
+
+    // Set the account's password, creating the account if needed
+    bool enroll(const string& role, const string& username, const string& password)
+    {
+        return store(role, username, password, 1);
+    }
+
+    // A one-time code that lets username log in once as role and choose a
+    // password; replaces any password the account had. Empty on failure.
+    string issueCode(const string& role, const string& username)
+    {
+        static const char alphabet[] = "ABCDEFGHJKLMNPQRSTUVWXYZ23456789";
+        random_device random;
+        string code;
+        for (int i = 0; i < 10; ++i)
+            code += alphabet[random() % (sizeof(alphabet) - 1)];
+        return store(role, username, code, 2) ? code : string();
+    }
+
+private:
+    bool store(const string& role, const string& username, const string& secret, uint32_t kind)
+    {
+        lock_guard<mutex> guard(Storage::fileLock(path));
+        if (!mapped && !map())
+            return false;
+        if ((count + 1) * 10 > capacity * 7 && !grow())
+            return false;
+
+        Slot slot = {};
+        makeKey(role, username, slot.key);
+        random_device random;
+        for (size_t i = 0; i < saltSize; ++i)
+            slot.salt[i] = static_cast<unsigned char>(random());
+        slot.iterations = defaultIterations;
+        slot.used = kind;
+        Sha256::pbkdf2(secret, slot.salt, saltSize, slot.iterations, slot.hash);
+
+        bool found = false;
+        uint64_t index = probe(slot.key, found);
+        return writeSlot(index, slot, !found, roleOffset(role));
+    }
+};
+
+#endif
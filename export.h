@@ -0,0 +1,443 @@
+#ifndef EXPORT_H
+#define EXPORT_H
+
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <charconv>
+#include <cstdio>
+
+#include "utils.h"
+#include "storage.h"
+#include "schema.h"
+#include "catalog.h"
+#include "attendance_store.h"
+#include "report_catalog.h"
+#include "summary.h"
+#include "table.h"
+
+using namespace std;
+
+enum class ExportFormat { Csv, Jsonl };
+
+// Rows written as CSV (with a header row) or as one JSON object per line.
+// Every field is formatted straight into one buffer that is handed to the
+// file whenever it passes flushBytes and then reused, so memory stays the
+// same however many rows go through.
+class ExportWriter
+{
+private:
+    static const size_t flushBytes = 64 * 1024;
+
+    FILE* out;
+    ExportFormat format;
+    vector<string> columns;
+    string buffer;
+    size_t field = 0;
+    size_t rows = 0;
+    bool failed = false;
+
+    void flush()
+    {
+        if (!buffer.empty() && fwrite(buffer.data(), 1, buffer.size(), out) != buffer.size())
+            failed = true;
+        buffer.clear();
+    }
+
+    // Separator or key before the next field
+    void next()
+    {
+        if (format == ExportFormat::Csv)
+        {
+            if (field > 0)
+                buffer += ',';
+        }
+        else
+        {
+            buffer += field == 0 ? "{\"" : ",\"";
+            buffer += field < columns.size() ? columns[field] : to_string(field);
+            buffer += "\":";
+        }
+        field++;
+    }
+
+    void quoted(string_view value)
+    {
+        if (format == ExportFormat::Csv)
+        {
+            if (value.find_first_of(",\"\r\n") == string_view::npos)
+            {
+                buffer += value;
+                return;
+            }
+            buffer += '"';
+            for (char c : value)
+            {
+                if (c == '"')
+                    buffer += '"';
+                buffer += c;
+            }
+            buffer += '"';
+            return;
+        }
+
+        buffer += '"';
+        for (char c : value)
+        {
+            if (c == '"' || c == '\\')
+            {
+                buffer += '\\';
+                buffer += c;
+            }
+            else if (static_cast<unsigned char>(c) < 0x20)
+            {
+                char escaped[8];
+                snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned char>(c));
+                buffer += escaped;
+            }
+            else
+                buffer += c;
+        }
+        buffer += '"';
+    }
+
+public:
+    ExportWriter(FILE* out, ExportFormat format, const vector<string>& columns) : out(out), format(format), columns(columns)
+    {
+        buffer.reserve(flushBytes + 4096);
+        if (format == ExportFormat::Csv)
+        {
+            for (const auto& column : columns)
+                text(column);
+            endRow();
+            rows = 0;
+        }
+    }
+
+    ExportWriter& text(string_view value)
+    {
+        next();
+        quoted(value);
+        return *this;
+    }
+
+    ExportWriter& integer(long long value)
+    {
+        next();
+        char digits[24];
+        to_chars_result result = to_chars(digits, digits + sizeof(digits), value);
+        buffer.append(digits, result.ptr - digits);
+        return *this;
+    }
+
+    ExportWriter& decimal(double value, int precision = 2)
+    {
+        next();
+        ConsoleTable::appendFixed(buffer, value, precision);
+        return *this;
+    }
+
+    // A number already written out as text; empty means no value, and
+    // anything that is not a plain number is kept as text
+    ExportWriter& number(string_view value)
+    {
+        if (value.empty())
+            return missing();
+        if (value.find_first_not_of("0123456789.") != string_view::npos && !(value[0] == '-' && value.size() > 1 && value.find_first_not_of("0123456789.", 1) == string_view::npos))
+            return text(value);
+        next();
+        buffer += value;
+        return *this;
+    }
+
+    ExportWriter& missing()
+    {
+        next();
+        if (format == ExportFormat::Jsonl)
+            buffer += "null";
+        return *this;
+    }
+
+    void endRow()
+    {
+        buffer += format == ExportFormat::Csv ? "\n" : "}\n";
+        field = 0;
+        rows++;
+        if (buffer.size() >= flushBytes)
+            flush();
+    }
+
+    // Write out what is buffered; false if any write failed
+    bool finish()
+    {
+        flush();
+        return !failed && fflush(out) == 0;
+    }
+
+    size_t rowCount() const
+    {
+        return rows;
+    }
+};
+
+// What to export and where; empty term and class mean all of them
+struct ExportOptions
+{
+    string dataset;
+    ExportFormat format = ExportFormat::Csv;
+    string term;
+    string className;
+    string outPath;     // empty writes to standard output
+};
+
+// lms export <reports|gradebook|attendance> [--format csv|jsonl]
+//            [--term Fall-2024] [--class 10-A] [--out file]
+//   reports     the latest term report of every student, one row each
+//   gradebook   each student's current score per assessment; grades are
+//               kept per class, so there is no subject column, and only
+//               the current ones, so --term is refused
+//   attendance  present and recorded days per student and month
+class Exporter
+{
+private:
+    struct RosterEntry
+    {
+        string name;
+        string className;
+    };
+
+    ExportOptions options;
+    unordered_map<string, RosterEntry> roster;
+
+    void loadRoster()
+    {
+        Schema::forEach<StudentView>(Storage::readAll(Catalog::path("students.txt")), [this](const StudentView& s)
+            {
+            roster[string(s.id)] = RosterEntry{ string(s.name), string(s.className) };
+            });
+    }
+
+    const RosterEntry& lookup(const string& id) const
+    {
+        static const RosterEntry unknown;
+        auto found = roster.find(id);
+        return found == roster.end() ? unknown : found->second;
+    }
+
+    static string_view after(string_view line, string_view prefix)
+    {
+        return line.compare(0, prefix.size(), prefix) == 0 ? Schema::trim(line.substr(prefix.size())) : string_view();
+    }
+
+    // One report section, one row per STUDENT block as Teacher::generateReports writes them
+    static void exportReport(ExportWriter& writer, const ReportEntry& entry, string_view text)
+    {
+        string_view id, name, quiz, midterm, finalExam, weighted, rank, attendance;
+        auto emit = [&]()
+            {
+            if (id.empty())
+                return;
+            // "12/20 (60.00%)"
+            string_view present, recorded;
+            size_t slash = attendance.find('/');
+            if (slash != string_view::npos)
+            {
+                present = attendance.substr(0, slash);
+                recorded = attendance.substr(slash + 1, attendance.find(' ', slash) - slash - 1);
+            }
+            size_t open = attendance.find('(');
+            string_view percent = open == string_view::npos ? string_view() : attendance.substr(open + 1, attendance.find('%', open) - open - 1);
+
+            writer.text(entry.term).text(entry.className).text(id).text(name);
+            writer.number(quiz).number(midterm).number(finalExam).number(weighted).text(rank == "-" ? string_view() : rank);
+            writer.number(present).number(recorded).number(percent);
+            writer.endRow();
+            id = string_view();
+            };
+
+        while (!text.empty())
+        {
+            size_t end = text.find('\n');
+            string_view line = text.substr(0, end);
+            text = end == string_view::npos ? string_view() : text.substr(end + 1);
+            if (!line.empty() && line.back() == '\r')
+                line.remove_suffix(1);
+
+            string_view value;
+            if (!(value = after(line, "STUDENT:")).empty())
+            {
+                emit();
+                size_t open = value.rfind('(');
+                if (open == string_view::npos)
+                    continue;
+                name = Schema::trim(value.substr(0, open));
+                id = value.substr(open + 1, value.find(')', open) - open - 1);
+                quiz = midterm = finalExam = weighted = rank = attendance = string_view();
+            }
+            else if (!(value = after(line, "WEIGHTED GRADE:")).empty())
+                weighted = value.substr(0, value.find('/'));
+            else if (!(value = after(line, "CLASS RANK:")).empty())
+                rank = value;
+            else if (!(value = after(line, "ATTENDANCE:")).empty())
+                attendance = value;
+            else if (line.compare(0, 2, "  ") == 0)
+            {
+                // "  quiz: 80/100"
+                string_view grade = Schema::trim(line);
+                size_t colon = grade.find(':');
+                if (colon == string_view::npos)
+                    continue;
+                string_view type = grade.substr(0, colon);
+                string_view score = Schema::trim(grade.substr(colon + 1));
+                score = score.substr(0, score.find('/'));
+                if (type == "quiz")
+                    quiz = score;
+                else if (type == "midterm")
+                    midterm = score;
+                else if (type == "final")
+                    finalExam = score;
+            }
+        }
+        emit();
+    }
+
+    void reports(ExportWriter& writer)
+    {
+        ReportCatalog catalog;
+        catalog.refresh();
+        for (const auto& entry : catalog.list())
+        {
+            if ((!options.term.empty() && entry.term != options.term) || (!options.className.empty() && entry.className != options.className))
+                continue;
+            // One class's section in memory at a time
+            exportReport(writer, entry, catalog.readReport(entry));
+        }
+    }
+
+    void gradebook(ExportWriter& writer)
+    {
+        loadRoster();
+        SummaryStore::instance().forEach([&](const string& id, const StudentSummary& summary)
+            {
+            const RosterEntry& student = lookup(id);
+            // Keyed by the class the grades were entered for, not by subject
+            for (const auto& graded : summary.subjects)
+            {
+                if (!options.className.empty() && graded.first != options.className)
+                    continue;
+                for (const auto& score : graded.second)
+                {
+                    writer.text(id).text(student.name).text(graded.first).text(score.first).integer(score.second);
+                    writer.endRow();
+                }
+            }
+            });
+    }
+
+    void attendance(ExportWriter& writer)
+    {
+        loadRoster();
+        DateRange range = options.term.empty() ? DateRange::all() : DateRange::term(options.term);
+        SummaryStore::instance().forEach([&](const string& id, const StudentSummary& summary)
+            {
+            const RosterEntry& student = lookup(id);
+            if (!options.className.empty() && student.className != options.className)
+                return;
+            for (const auto& month : summary.months)
+            {
+                DateRange days = DateRange::month(month.first);
+                if (!range.contains(days.from) || !range.contains(days.to))
+                    continue;
+                writer.text(id).text(student.name).text(student.className).text(month.first);
+                writer.integer(month.second.first).integer(month.second.second).decimal((month.second.first * 100.0) / max(1, month.second.second));
+                writer.endRow();
+            }
+            });
+    }
+
+public:
+    explicit Exporter(const ExportOptions& options) : options(options) {}
+
+    static const char* usage()
+    {
+        return "Usage: lms export <reports|gradebook|attendance> [--format csv|jsonl] [--term Fall-2024] [--class 10-A] [--out file]";
+    }
+
+    // args as given after "export"
+    static bool parseArgs(const vector<string>& args, ExportOptions& options, string& error)
+    {
+        if (args.empty())
+        {
+            error = "No dataset given";
+            return false;
+        }
+        options.dataset = args[0];
+        if (options.dataset != "reports" && options.dataset != "gradebook" && options.dataset != "attendance")
+        {
+            error = "Unknown dataset: " + options.dataset;
+            return false;
+        }
+        for (size_t i = 1; i < args.size(); i += 2)
+        {
+            if (i + 1 >= args.size())
+            {
+                error = "Missing value for " + args[i];
+                return false;
+            }
+            const string& value = args[i + 1];
+            if (args[i] == "--format" && (value == "csv" || value == "jsonl"))
+                options.format = value == "csv" ? ExportFormat::Csv : ExportFormat::Jsonl;
+            else if (args[i] == "--term")
+                options.term = value;
+            else if (args[i] == "--class")
+                options.className = value;
+            else if (args[i] == "--out")
+                options.outPath = value;
+            else
+            {
+                error = "Unknown option: " + args[i] + " " + value;
+                return false;
+            }
+        }
+        // The summaries hold only each student's current grades, not a term's
+        if (options.dataset == "gradebook" && !options.term.empty())
+        {
+            error = "--term does not apply to gradebook; it always exports the current grades";
+            return false;
+        }
+        return true;
+    }
+
+    // Write the dataset; returns how many rows went out, or -1 on a write error
+    long long run()
+    {
+        vector<string> columns;
+        if (options.dataset == "reports")
+            columns = { "term", "class", "student_id", "name", "quiz", "midterm", "final", "weighted_grade", "class_rank", "present", "recorded", "attendance_percent" };
+        else if (options.dataset == "gradebook")
+            columns = { "student_id", "name", "class", "type", "score" };
+        else
+            columns = { "student_id", "name", "class", "month", "present", "recorded", "attendance_percent" };
+
+        FILE* out = options.outPath.empty() ? stdout : fopen(options.outPath.c_str(), "wb");
+        if (!out)
+            return -1;
+
+        ExportWriter writer(out, options.format, columns);
+        if (options.dataset == "reports")
+            reports(writer);
+        else if (options.dataset == "gradebook")
+            gradebook(writer);
+        else
+            attendance(writer);
+        bool ok = writer.finish();
+
+        if (out != stdout && fclose(out) != 0)
+            ok = false;
+        return ok ? static_cast<long long>(writer.rowCount()) : -1;
+    }
+};
+
+#endif
@@ -0,0 +1,351 @@
+#ifndef FEE_LEDGER_H
+#define FEE_LEDGER_H
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <mutex>
+#include <cstdio>
+#include <cstdint>
+
+#include "utils.h"
+#include "storage.h"
+#include "schema.h"
+#include "catalog.h"
+#include "money.h"
+
+using namespace std;
+
+// A charge or payment to post; amounts are positive
+struct FeePosting
+{
+    string studentId;
+    string kind;        // Challan or Payment
+    string month;
+    Paisa amount;
+};
+
+struct FeeAccount
+{
+    string studentId;
+    Paisa balance;
+    size_t entries;
+};
+
+// Fee charges and payments per student. fees_ledger.txt is append-only:
+// every batch of postings is one committed section whose lines carry the
+// student's running balance. fees.idx keeps each student's balance and the
+// byte offsets of their lines, so a statement reads only that student's
+// lines and balances need no ledger read at all:
+//   W|<ledger bytes>|<crc of its last 64 bytes>
+//   A|studentId|balance|offset,offset...
+// Postings append A lines for the offsets they add; the index is rewritten
+// once those outgrow the snapshot. Lines appended to the ledger some other
+// way are indexed on the next read, and a ledger that was rewritten is
+// indexed again from the start. The old id|month|amount|status lines are
+// converted the first time the ledger is indexed.
+class FeeLedger
+{
+private:
+    struct Account
+    {
+        Paisa balance = 0;
+        vector<long long> offsets;
+    };
+
+    mutex lock;
+    const string ledgerPath = Catalog::path("fees_ledger.txt");
+    const string indexPath = Catalog::path("fees.idx");
+    unordered_map<string, Account> accounts;
+    long long indexedBytes = -1;
+    uint32_t fingerprint = 0;
+    bool loaded = false;
+    long long snapshotBytes = 0;
+    long long journalBytes = 0;
+
+    uint32_t fingerprintAt(long long end) const
+    {
+        long long start = max(0LL, end - 64);
+        string tail = Storage::readRange(ledgerPath, start, end - start);
+        return Storage::crc32(tail.data(), tail.size());
+    }
+
+    static Paisa signedAmount(const string& kind, Paisa amount)
+    {
+        return kind == "Payment" ? -amount : amount;
+    }
+
+    string markLine() const
+    {
+        char crc[16];
+        snprintf(crc, sizeof(crc), "%08x", fingerprint);
+        return "W|" + to_string(indexedBytes) + "|" + crc + "\n";
+    }
+
+    // Index the ledger lines in text, which starts at byte base of the file
+    string indexText(string_view text, long long base)
+    {
+        struct Visitor
+        {
+            FeeLedger& ledger;
+            string_view text;
+            long long base;
+            string journal;
+
+            void section(string_view, string_view) {}
+
+            void line(string_view line)
+            {
+                FeeEntry entry;
+                Paisa amount = 0;
+                if (!Schema::parseLine(line, entry) || !Money::parse(entry.amount, amount))
+                    return;
+                Account& account = ledger.accounts[entry.studentId];
+                account.balance += signedAmount(entry.kind, amount);
+                account.offsets.push_back(base + (line.data() - text.data()));
+                journal += "A|" + entry.studentId + "|" + to_string(account.balance) + "|" + to_string(account.offsets.back()) + "\n";
+            }
+        } visitor{ *this, text, base, string() };
+
+        Storage::walkSections(text, visitor);
+        return visitor.journal;
+    }
+
+    // Rewrite id|month|amount|status lines as entries with running balances
+    void migrateLegacy(const string& text)
+    {
+        string content;
+        bool legacy = false;
+        unordered_map<string, Paisa> balances;
+        for (const auto& line : Utils::splitString(text, '\n'))
+        {
+            if (line.empty() || line[0] == '[')
+                continue;
+            FeeEntry entry;
+            Paisa amount = 0;
+            if (Schema::parseLine(line, entry) && Money::parse(entry.amount, amount))
+            {
+                balances[entry.studentId] += signedAmount(entry.kind, amount);
+                Schema::appendLine(content, entry);
+                continue;
+            }
+            vector<string> parts = Utils::parseRecord(line);
+            if (parts.size() != 4 || !Money::parse(parts[2], amount))
+                continue;
+            legacy = true;
+            Paisa& balance = balances[parts[0]];
+            balance += amount;
+            Schema::appendLine(content, FeeEntry{ parts[0], "-", "Challan", parts[1], Money::format(amount), Money::format(balance) });
+            if (parts[3] == "Paid")
+            {
+                balance -= amount;
+                Schema::appendLine(content, FeeEntry{ parts[0], "-", "Payment", parts[1], Money::format(amount), Money::format(balance) });
+            }
+        }
+        if (legacy)
+            Storage::writeAtomic(ledgerPath, "[FEES LEDGER]\n" + content);
+    }
+
+    // Caller holds the lock
+    void writeSnapshotLocked()
+    {
+        string content = "[FEE INDEX]\n" + markLine();
+        for (const auto& item : accounts)
+        {
+            content += "A|" + item.first + "|" + to_string(item.second.balance) + "|";
+            for (size_t i = 0; i < item.second.offsets.size(); ++i)
+                content += (i > 0 ? "," : "") + to_string(item.second.offsets[i]);
+            content += "\n";
+        }
+        if (Storage::writeAtomic(indexPath, content))
+        {
+            snapshotBytes = static_cast<long long>(content.size());
+            journalBytes = 0;
+        }
+    }
+
+    // Caller holds the lock
+    void journalLocked(string lines)
+    {
+        lines += markLine();
+        Storage::appendText(indexPath, lines);
+        journalBytes += static_cast<long long>(lines.size());
+        if (journalBytes > max(snapshotBytes, 64LL * 1024))
+            writeSnapshotLocked();
+    }
+
+    // Caller holds the lock
+    void rebuildLocked()
+    {
+        migrateLegacy(Storage::readAll(ledgerPath));
+        string text = Storage::readAll(ledgerPath);
+        accounts.clear();
+        indexText(text, 0);
+        indexedBytes = static_cast<long long>(text.size());
+        fingerprint = fingerprintAt(indexedBytes);
+        writeSnapshotLocked();
+    }
+
+    void replay(const string& text)
+    {
+        for (const auto& line : Utils::splitString(text, '\n'))
+        {
+            vector<string> parts = Utils::parseRecord(line);
+            if (parts.size() == 3 && parts[0] == "W")
+            {
+                indexedBytes = atoll(parts[1].c_str());
+                fingerprint = static_cast<uint32_t>(strtoul(parts[2].c_str(), nullptr, 16));
+            }
+            else if (parts.size() == 4 && parts[0] == "A")
+            {
+                Account& account = accounts[parts[1]];
+                account.balance = atoll(parts[2].c_str());
+                for (const auto& offset : Utils::splitString(parts[3], ','))
+                    account.offsets.push_back(atoll(offset.c_str()));
+            }
+        }
+    }
+
+    // Caller holds the lock. Load the index once, then follow the ledger.
+    void syncLocked()
+    {
+        if (!loaded)
+        {
+            string index = Storage::readAll(indexPath);
+            snapshotBytes = static_cast<long long>(index.size());
+            replay(index);
+            loaded = true;
+        }
+
+        long long size = max(0LL, Storage::fileSize(ledgerPath));
+        if (indexedBytes < 0 || size < indexedBytes || fingerprintAt(indexedBytes) != fingerprint)
+        {
+            rebuildLocked();
+            return;
+        }
+        if (size > indexedBytes)
+        {
+            string text = Storage::readRange(ledgerPath, indexedBytes, size - indexedBytes);
+            size_t complete = text.rfind('\n');
+            if (complete == string::npos)
+                return;
+            text.resize(complete + 1);
+            string lines = indexText(text, indexedBytes);
+            indexedBytes += static_cast<long long>(text.size());
+            fingerprint = fingerprintAt(indexedBytes);
+            journalLocked(lines);
+        }
+    }
+
+public:
+    static FeeLedger& instance()
+    {
+        static FeeLedger ledger;
+        return ledger;
+    }
+
+    // Append postings as one section; false if nothing could be written
+    bool post(const vector<FeePosting>& postings, const string& date)
+    {
+        if (postings.empty())
+            return true;
+
+        lock_guard<mutex> guard(lock);
+        syncLocked();
+
+        unordered_map<string, Paisa> balances;
+        string section = "\n[FEES " + date + "]\n";
+        vector<size_t> positions;
+        for (const auto& p : postings)
+        {
+            auto known = balances.find(p.studentId);
+            if (known == balances.end())
+            {
+                auto account = accounts.find(p.studentId);
+                known = balances.insert(make_pair(p.studentId, account == accounts.end() ? 0 : account->second.balance)).first;
+            }
+            known->second += signedAmount(p.kind, p.amount);
+            positions.push_back(section.size() - 1);
+            Schema::appendLine(section, FeeEntry{ p.studentId, date, p.kind, p.month, Money::format(p.amount), Money::format(known->second) });
+        }
+
+        // Offsets of the lines once framed: the frame adds a header line and
+        // drops the section's leading newline
+        string framed = Storage::frameSection(section, date);
+        long long start = max(0LL, Storage::fileSize(ledgerPath));
+        long long base = start + static_cast<long long>(framed.find('\n', 1)) + 1;
+        if (!Storage::appendText(ledgerPath, framed))
+            return false;
+
+        string lines;
+        for (size_t i = 0; i < postings.size(); ++i)
+        {
+            Account& account = accounts[postings[i].studentId];
+            account.balance = balances[postings[i].studentId];
+            account.offsets.push_back(base + static_cast<long long>(positions[i]));
+            lines += "A|" + postings[i].studentId + "|" + to_string(account.balance) + "|" + to_string(account.offsets.back()) + "\n";
+        }
+        indexedBytes = start + static_cast<long long>(framed.size());
+        fingerprint = fingerprintAt(indexedBytes);
+        journalLocked(lines);
+        return true;
+    }
+
+    // What the student owes; negative if paid in advance
+    Paisa balance(const string& studentId)
+    {
+        lock_guard<mutex> guard(lock);
+        syncLocked();
+        auto found = accounts.find(studentId);
+        return found == accounts.end() ? 0 : found->second.balance;
+    }
+
+    // The student's entries in posting order, read from their own offsets
+    vector<FeeEntry> statement(const string& studentId)
+    {
+        lock_guard<mutex> guard(lock);
+        syncLocked();
+        vector<FeeEntry> entries;
+        auto found = accounts.find(studentId);
+        if (found == accounts.end())
+            return entries;
+
+        ifstream file(ledgerPath, ios::binary);
+        string line;
+        for (long long offset : found->second.offsets)
+        {
+            file.clear();
+            file.seekg(offset);
+            FeeEntry entry;
+            if (getline(file, line) && Schema::parseLine(line, entry))
+                entries.push_back(entry);
+        }
+        return entries;
+    }
+
+    // Students owing money, largest balance first
+    vector<FeeAccount> defaulters()
+    {
+        lock_guard<mutex> guard(lock);
+        syncLocked();
+        vector<FeeAccount> owing;
+        for (const auto& item : accounts)
+        {
+            if (item.second.balance > 0)
+                owing.push_back(FeeAccount{ item.first, item.second.balance, item.second.offsets.size() });
+        }
+        sort(owing.begin(), owing.end(), [](const FeeAccount& a, const FeeAccount& b)
+            {
+            if (a.balance != b.balance)
+                return a.balance > b.balance;
+            return a.studentId < b.studentId;
+            });
+        return owing;
+    }
+};
+
+#endif
@@ -6,6 +6,8 @@
 #include <memory>
 
 #include "models.h"
+#include "credentials.h"
+#include "export.h"
 #include "utils.h"
 using namespace std;
 
@@ -13,34 +15,28 @@ class LMS
 {
 private:
     unique_ptr<User> currentUser;
+    CredentialStore& credentials = CredentialStore::instance();
 
-    void initializeFiles() 
+    // First login with a one-time code: the user replaces it with a password
+    bool choosePassword(const string& role, const string& username)
     {
-        vector<pair<string, string>> requiredFiles = {
-            {"students.txt", "[STUDENT RECORD]\n"},
-            {"teachers.txt", "[TEACHER RECORD]\n"},
-            {"timetable.txt", "[TIMETABLE]\n"},
-            {"attendance.txt", "[ATTENDANCE]\n"},
-            {"termReports.txt", "[TERM REPORTS]\n"},
-            {"assignments_due.txt", "[ASSIGNMENTS]\n"},
-            {"fees_ledger.txt", "[FEES LEDGER]\n"},
-            {"staff.txt", "[STAFF RECORD]\n"},
-            {"leave_requests.txt", "[LEAVE REQUESTS]\n"},
-            {"parent_requests.txt", "[PARENT REQUESTS]\n"},
-            {"fee_challans.txt", "[FEE CHALLANS]\n"}, {"salary_payments.txt", "[STAFF SALARIES]\n"},
-            {"grades.txt", "[GRADES]\n"}
-        };
-        for (const auto& file : requiredFiles)
+        string password, confirm;
+        cout << "Choose a new password: ";
+        getline(cin, password);
+        cout << "Confirm password: ";
+        getline(cin, confirm);
+        if (password.empty() || password != confirm)
         {
-            ifstream infile(file.first);
-            if (!infile.good()) 
-            {
-                ofstream outfile(file.first);
-                outfile << file.second;
-                outfile.close();
-            }
-            infile.close();
+            cout << "Passwords do not match!" << endl;
+            return false;
         }
+        if (!credentials.enroll(role, username, password))
+        {
+            cout << "Error: could not save the password!" << endl;
+            return false;
+        }
+        cout << "Password saved for " << username << "." << endl;
+        return true;
     }
 
     string selectRole() 
@@ -98,6 +94,19 @@ private:
             return false;
         }
 
+        // Unknown accounts and wrong passwords get the same answer
+        LoginResult result = credentials.verify(role, username, password);
+        if (result == LoginResult::Issued)
+        {
+            if (!choosePassword(role, username))
+                return false;
+        }
+        else if (result != LoginResult::Accepted)
+        {
+            cout << "Invalid username or password!" << endl;
+            return false;
+        }
+
         // Create user based on selected role
         if (role == "admin")
         {
@@ -145,6 +154,14 @@ private:
             cout << "5. Handle Leave Requests" << endl;
             cout << "6. Generate Fee Challans" << endl;
             cout << "7. Yearly Class Allocation" << endl;
+            cout << "8. Compact Data Files" << endl;
+            cout << "9. Close Term" << endl;
+            cout << "10. Search by Name" << endl;
+            cout << "11. Generate Timetable" << endl;
+            cout << "12. Check Timetable" << endl;
+            cout << "13. Fee Defaulters" << endl;
+            cout << "14. Import Attendance" << endl;
+            cout << "15. Issue Login Code" << endl;
             cout << "0. Logout" << endl;
             cout << "Enter your choice: ";
 
@@ -179,6 +196,30 @@ private:
             case 7: 
                 admin->yearlyClassAllocation(); 
                 break;
+            case 8:
+                admin->compactDataFiles();
+                break;
+            case 9:
+                admin->closeTerm();
+                break;
+            case 10:
+                admin->searchNames();
+                break;
+            case 11:
+                admin->generateTimetable();
+                break;
+            case 12:
+                admin->checkTimetable();
+                break;
+            case 13:
+                admin->viewFeeDefaulters();
+                break;
+            case 14:
+                admin->importAttendance();
+                break;
+            case 15:
+                admin->issueLoginCode();
+                break;
             case 0: 
                 break;
             default: cout << "Invalid choice!" << endl;
@@ -202,6 +243,7 @@ private:
             cout << "3. Generate Reports" << endl;
             cout << "4. Apply for Leave" << endl;
             cout << "5. View Timetable" << endl;
+            cout << "6. Class Rankings" << endl;
             cout << "0. Logout" << endl;
             cout << "Enter your choice: ";
 
@@ -230,6 +272,9 @@ private:
             case 5:
                 teacher->viewTimetable();
                 break;
+            case 6:
+                teacher->viewRankings();
+                break;
             case 0:
                 break;
             default: cout << "Invalid choice!" << endl;
@@ -250,6 +295,7 @@ private:
             cout << "2. View Assignments" << endl;
             cout << "3. View Grades" << endl;
             cout << "4. View Attendance" << endl;
+            cout << "5. View Past Term" << endl;
             cout << "0. Logout" << endl;
             cout << "Enter your choice: ";
 
@@ -275,6 +321,9 @@ private:
             case 4: 
                 student->viewAttendance();
                 break;
+            case 5:
+                student->viewPastTerm();
+                break;
             case 0:
                 break;
             default: cout << "Invalid choice!" << endl;
@@ -295,6 +344,7 @@ private:
             cout << "2. View Fee Status" << endl;
             cout << "3. Submit Request" << endl;
             cout << "4. View Child Attendance" << endl;
+            cout << "5. View Past Term" << endl;
             cout << "0. Logout" << endl;
             cout << "Enter your choice: ";
 
@@ -320,6 +370,9 @@ private:
             case 4: 
                 parent->viewChildAttendance(); 
                 break;
+            case 5:
+                parent->viewPastTerm();
+                break;
             case 0: 
                 break;
             default: cout << "Invalid choice!" << endl;
@@ -340,6 +393,8 @@ private:
             cout << "2. Manage Staff Salaries" << endl;
             cout << "3. View School Reports" << endl;
             cout << "4. Approve Leave Requests" << endl;
+            cout << "5. Analytics Queries" << endl;
+            cout << "6. Class Rankings" << endl;
             cout << "0. Logout" << endl;
             cout << "Enter your choice: ";
 
@@ -365,6 +420,12 @@ private:
             case 4: 
                 principal->approveLeaveRequests(); 
                 break;
+            case 5:
+                principal->runQueries();
+                break;
+            case 6:
+                principal->viewRankings();
+                break;
             case 0: 
                 break;
             default: cout << "Invalid choice!" << endl;
@@ -375,7 +436,10 @@ private:
 public:
     LMS()
     {
-        initializeFiles();
+        if (!credentials.open())
+            cerr << "Warning: could not open the credential store" << endl;
+        else if (!credentials.hasAccounts("admin"))
+            cerr << "No admin account yet: run \"lms issue-code admin <name>\" for a first login code" << endl;
     }
 
     void run()
@@ -412,6 +476,7 @@ public:
             }
 
             currentUser.reset();
+            Compactor::collectBackground(false);
 
             cout << "\nWould you like to exit? (y/n): ";
             char choice;
@@ -419,16 +484,122 @@ public:
             clearInputBuffer();
             if (tolower(choice) == 'y') 
             {
+                Compactor::collectBackground(true);
                 break;
             }
         }
     }
 };
 
-int main() 
+int main(int argc, char* argv[]) 
 {
+    vector<string> args(argv + 1, argv + argc);
+    string dataDirectory = Catalog::chooseDirectory(args);
+    if (!Catalog::open(dataDirectory))
+    {
+        cerr << "Cannot use data directory " << dataDirectory << endl;
+        return 1;
+    }
+
+    // lms query "<query>" runs one analytics query and exits
+    if (!args.empty() && args[0] == "query")
+    {
+        QueryEngine engine;
+        engine.load();
+        if (args.size() < 2)
+        {
+            engine.printTables();
+            Catalog::save();
+            return 0;
+        }
+        QueryResult result = engine.run(args[1]);
+        QueryEngine::printResult(result);
+        Catalog::save();
+        return result.error.empty() ? 0 : 1;
+    }
+
+    // lms issue-code admin <username> prints a one-time login code for the
+    // first admin; once any admin account exists, codes come only from the
+    // Admin menu
+    if (!args.empty() && args[0] == "issue-code")
+    {
+        if (args.size() < 3 || args[1] != "admin")
+        {
+            cerr << "Usage: lms issue-code admin <username>" << endl;
+            return 2;
+        }
+        CredentialStore& credentials = CredentialStore::instance();
+        if (!credentials.open())
+        {
+            cerr << "Could not open the credential store" << endl;
+            return 1;
+        }
+        if (credentials.hasAccounts("admin"))
+        {
+            cerr << "An admin account already exists; issue login codes from the Admin menu" << endl;
+            return 1;
+        }
+        string code = credentials.issueCode(args[1], args[2]);
+        Catalog::save();
+        if (code.empty())
+        {
+            cerr << "Could not issue a code for " << args[2] << endl;
+            return 1;
+        }
+        cout << code << endl;
+        return 0;
+    }
+
+    // lms import-attendance <file> imports a card reader export and exits;
+    // it writes attendance, so an admin signs in first
+    if (!args.empty() && args[0] == "import-attendance")
+    {
+        if (args.size() < 2 || Storage::fileSize(args[1]) < 0)
+        {
+            cerr << "Usage: lms import-attendance <device export file>" << endl;
+            return 2;
+        }
+        CredentialStore& credentials = CredentialStore::instance();
+        string username, password;
+        cout << "Admin username: ";
+        getline(cin, username);
+        cout << "Password: ";
+        getline(cin, password);
+        if (!credentials.open() || credentials.verify("admin", username, password) != LoginResult::Accepted)
+        {
+            cerr << "Invalid username or password!" << endl;
+            return 1;
+        }
+        ImportResult result = AttendanceImport().run(args[1]);
+        AttendanceImport::printResult(result);
+        Catalog::save();
+        return result.ok ? 0 : 1;
+    }
+
+    // lms export <dataset> [options] streams a dataset as CSV or JSON Lines
+    if (!args.empty() && args[0] == "export")
+    {
+        ExportOptions options;
+        string error;
+        if (!Exporter::parseArgs(vector<string>(args.begin() + 1, args.end()), options, error))
+        {
+            cerr << error << "\n" << Exporter::usage() << endl;
+            return 2;
+        }
+        long long rows = Exporter(options).run();
+        Catalog::save();
+        if (rows < 0)
+        {
+            cerr << "Export failed: could not write " << (options.outPath.empty() ? "output" : options.outPath) << endl;
+            return 1;
+        }
+        cerr << rows << " row(s) exported" << endl;
+        return 0;
+    }
+
 	cout << "\n\t--------------  ADVANCED LEARNING MANAGEMENT SYSTEM  --------------\n\n";
     LMS system;
     system.run();
+    Catalog::save();
     return 0;
 }
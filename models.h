@@ -15,68 +15,32 @@
 #include <limits>
 
 #include "utils.h"
+#include "records.h"
+#include "schema.h"
+#include "request_queue.h"
+#include "storage.h"
+#include "compaction.h"
+#include "attendance_store.h"
+#include "report_catalog.h"
+#include "term_archive.h"
+#include "promotion.h"
+#include "analytics.h"
+#include "arena.h"
+#include "roster.h"
+#include "table.h"
+#include "parent_index.h"
+#include "name_search.h"
+#include "ranking.h"
+#include "summary.h"
+#include "timetable.h"
+#include "payroll.h"
+#include "fee_ledger.h"
+#include "attendance_import.h"
+#include "credentials.h"
 
 
 using namespace std;
 
-// Record Structures
-struct StaffRecord 
-{
-    string id;
-    string name;
-    string role;
-    string contact;
-    string salary;
-    int leavesTaken;
-
-    StaffRecord(const string& id, const string& name, const string& role, const string& contact, const string& salary, int leaves) : id(id), name(name), role(role), contact(contact), salary(salary), leavesTaken(leaves) {}
-
-    string toString() const 
-    {
-        return "ID: " + id + " | Name: " + name + " | Role: " + role + " | Contact: " + contact + " | Salary: " + salary + " | Leaves Taken: " + to_string(leavesTaken);
-    }
-};
-
-class StudentRecord 
-{
-public:
-    string id;
-    string name;
-    string className;
-    string rollNo;
-    string parentContact;
-    string feeStatus;
-
-    StudentRecord(const string& id, const string& name, const string& className, const string& rollNo, const string& parentContact, const string& feeStatus) : id(id), name(name), className(className), rollNo(rollNo), parentContact(parentContact), feeStatus(feeStatus) {}
-
-    string toString() const
-    {
-        return "ID: " + id + " | Name: " + name + " | Class: " + className + " | Roll No: " + rollNo + " | Parent Contact: " + parentContact + " | Fee Status: " + feeStatus;
-    }
-};
-
-class TeacherRecord 
-{
-public:
-    string id;
-    string name;
-    vector<string> subjects;
-    string qualification;
-    string contact;
-	int leavesTaken = 0; // Default to 0 leaves taken
-    vector<string> assignedClasses;
-    int periodsPerWeek;
-
-    TeacherRecord(const string& id, const string& name, const vector<string>& subjects, const string& qualification, const string& contact, const vector<string>& assignedClasses, int periodsPerWeek) : id(id), name(name), subjects(subjects), qualification(qualification), contact(contact), assignedClasses(assignedClasses), periodsPerWeek(periodsPerWeek) {}
-
-    string toString() const 
-    {
-        string subjs = Utils::joinString(subjects, ", ");
-        string classes = Utils::joinString(assignedClasses, ", ");
-        return "ID: " + id + " | Name: " + name + " | Subjects: " + subjs + " | Qualification: " + qualification + " | Contact: " + contact + " | Classes: " + classes + " | Periods/Week: " + to_string(periodsPerWeek);
-    }
-};
-
 // Base User Class
 class User 
 {
@@ -105,6 +69,21 @@ class Admin : public User
 {
 private:
     vector<StaffRecord> staffMembers;
+    NameIndex names;
+    bool namesLoaded = false;
+
+    // The index is built on the first search and kept current by the edits after it
+    void indexName(NameKind kind, const string& id, const string& name)
+    {
+        if (namesLoaded)
+            names.add(kind, id, name);
+    }
+
+    void unindexName(NameKind kind, const string& id)
+    {
+        if (namesLoaded)
+            names.remove(kind, id);
+    }
 
 public:
     Admin(const string& uname, const string& pwd) : User(uname, pwd) {}
@@ -113,6 +92,7 @@ public:
     {
         cout << "\n=== Manage Students ===" << endl;
         vector<StudentRecord> students = loadStudents();
+        bool unsaved = false;
 
         int choice;
         do {
@@ -125,15 +105,18 @@ public:
             {
             case 1: 
                 addStudent(students);
+                unsaved = true;
                 break;
             case 2:
-                viewStudents(students); 
+                viewStudents(students, unsaved);
                 break;
             case 3: 
                 updateStudent(students); 
+                unsaved = true;
                 break;
             case 4: 
                 removeStudent(students); 
+                unsaved = true;
                 break;
             case 0: break;
             default:
@@ -148,6 +131,7 @@ public:
     {
         cout << "\n=== Manage Teachers ===" << endl;
         vector<TeacherRecord> teachers = loadTeachers();
+        bool unsaved = false;
 
         int choice;
         do {
@@ -159,15 +143,18 @@ public:
             switch (choice) {
             case 1:
                 addTeacher(teachers);
+                unsaved = true;
                 break;
             case 2: 
-                viewTeachers(teachers); 
+                viewTeachers(teachers, unsaved);
                 break;
             case 3: 
                 updateTeacher(teachers);
+                unsaved = true;
                 break;
             case 4: 
                 removeTeacher(teachers); 
+                unsaved = true;
                 break;
             case 0: break;
             default: cout << "Invalid choice!" << endl;
@@ -181,6 +168,7 @@ public:
     {
         cout << "\n=== Manage Staff ===" << endl;
         staffMembers = loadStaff();
+        bool unsaved = false;
 
         int choice;
         do {
@@ -190,10 +178,10 @@ public:
             Utils::clearInputBuffer();
 
             switch (choice) {
-            case 1: addStaff(staffMembers); break;
-            case 2: viewStaff(staffMembers); break;
-            case 3: updateStaff(staffMembers); break;
-            case 4: removeStaff(staffMembers); break;
+            case 1: addStaff(staffMembers); unsaved = true; break;
+            case 2: viewStaff(staffMembers, unsaved); break;
+            case 3: updateStaff(staffMembers); unsaved = true; break;
+            case 4: removeStaff(staffMembers); unsaved = true; break;
             case 0: break;
             default: cout << "Invalid choice!" << endl;
             }
@@ -227,7 +215,7 @@ public:
     void handleLeaveRequests() 
     {
         cout << "\n=== Handle Leave Requests ===" << endl;
-        ifstream file("leave_requests.txt");
+        ifstream file(Catalog::path("leave_requests.txt"));
         string line;
         vector<string> pendingRequests;
 
@@ -274,8 +262,7 @@ public:
             parts[5] = status;
 
             // Update the request in the file
-            ofstream outFile("leave_requests.txt", ios::app);
-            outFile << Utils::joinString(parts, "|") << "\n";
+            Storage::appendText(Catalog::path("leave_requests.txt"), Utils::joinString(parts, "|") + "\n");
             cout << "Request " << status << " successfully!" << endl;
         }
     }
@@ -289,8 +276,9 @@ public:
         cout << "Enter month and year (MM-YYYY): ";
         getline(cin, monthYear);
 
-        ofstream challanFile("fee_challans.txt", ios::app);
+        ostringstream challanFile;
         challanFile << "\n[FEE CHALLANS " << monthYear << "]\n";
+        vector<FeePosting> charges;
 
         for (const auto& student : students)
         {
@@ -302,49 +290,312 @@ public:
             if (tolower(choice) == 'y') 
             {
                 string amount;
+                Paisa fee = 0;
                 cout << "Enter fee amount: ";
                 getline(cin, amount);
+                if (!Money::parse(amount, fee) || fee <= 0)
+                {
+                    cout << "Invalid amount! No challan for " << student.name << endl;
+                    continue;
+                }
 
-                challanFile << student.id << "|" << student.name << "|" << student.className << "|" << monthYear << "|" << amount << "|Unpaid\n";
-                cout << "Challan generated for " << student.name << endl;
+                challanFile << student.id << "|" << student.name << "|" << student.className << "|" << monthYear << "|" << Money::format(fee) << "|Unpaid\n";
+                charges.push_back(FeePosting{ student.id, "Challan", monthYear, fee });
             }
         }
 
-        cout << "\nFee challan generation complete." << endl;
+        // The ledger holds the balances, so the challans are only printed
+        // once it has taken the charges
+        string currentDate = Utils::getCurrentDate();
+        if (!FeeLedger::instance().post(charges, currentDate))
+        {
+            cout << "Error: could not record the challans in the fee ledger! No challans were generated." << endl;
+            return;
+        }
+        if (!Storage::commitSection(Catalog::path("fee_challans.txt"), challanFile.str(), currentDate))
+        {
+            cout << "Error: the charges are in the fee ledger, but fee_challans.txt could not be written!" << endl;
+            return;
+        }
+        cout << "\n" << charges.size() << " fee challan(s) generated." << endl;
+    }
+
+    void compactDataFiles()
+    {
+        cout << "\n=== Compact Data Files ===" << endl;
+        vector<CompactionRule> rules = Compactor::defaultRules();
+        vector<CompactionRule> partitions = AttendanceStore::instance().compactionRules();
+        rules.insert(rules.end(), partitions.begin(), partitions.end());
+
+        if (Compactor::startBackground(rules))
+        {
+            cout << "Compaction started in the background. Superseded attendance, grade, report, payment and request sections will be dropped." << endl;
+        }
+        else
+        {
+            cout << "A compaction is already running." << endl;
+        }
+    }
+
+    void closeTerm()
+    {
+        cout << "\n=== Close Term ===" << endl;
+        string termName;
+        cout << "Enter term to close (e.g., Fall-2023): ";
+        getline(cin, termName);
+
+        DateRange range = DateRange::term(termName);
+        if (range.from == DateRange::all().from)
+        {
+            cout << "Invalid term name!" << endl;
+            return;
+        }
+        if (range.to >= Utils::dateToDays(Utils::getCurrentDate()))
+        {
+            cout << "Term " << termName << " has not ended yet!" << endl;
+            return;
+        }
+
+        TermArchive::CloseResult result;
+        if (!TermArchive::closeTerm(termName, result))
+        {
+            if (result.unreadableArchive)
+                cout << "The existing archive for " << termName << " could not be read; nothing was changed!" << endl;
+            else
+                cout << "Failed to write the archive for " << termName << "!" << endl;
+            return;
+        }
+        if (result.sections == 0)
+        {
+            cout << "No live records found for " << termName << "." << endl;
+            return;
+        }
+
+        cout << "Archived " << result.sections << " sections (" << result.rawBytes << " bytes -> " << result.archiveBytes << " bytes compressed)." << endl;
+        cout << "Live files reduced by " << result.liveBytesFreed << " bytes." << endl;
+    }
+
+    void searchNames()
+    {
+        cout << "\n=== Search by Name ===" << endl;
+        if (!namesLoaded)
+        {
+            names.load();
+            namesLoaded = true;
+        }
+
+        string query;
+        cout << "Enter a name or the start of one: ";
+        getline(cin, query);
+
+        vector<NameMatch> matches = names.search(query, 10);
+        if (matches.empty())
+        {
+            cout << "No matching names found." << endl;
+            return;
+        }
+
+        ConsoleTable table;
+        table.column("Type", 10).column("ID", 10).column("Name", 25).column("Match", 10).rules(55);
+        for (const auto& match : matches)
+        {
+            table.cell(NameIndex::kindName(match.kind)).cell(match.id).cell(match.name);
+            if (match.score >= 1.0f)
+                table.cell("prefix");
+            else
+                table.cell(to_string(static_cast<int>(match.score * 100)) + "%");
+        }
+        table.print();
     }
 
     void yearlyClassAllocation() 
     {
         cout << "\n=== Yearly Class Allocation ===" << endl;
         vector<StudentRecord> students = loadStudents();
+        if (students.empty())
+        {
+            cout << "No students found." << endl;
+            return;
+        }
+
+        string input;
+        size_t capacity = 40;
+        cout << "Section capacity [40]: ";
+        getline(cin, input);
+        if (!input.empty() && all_of(input.begin(), input.end(), ::isdigit) && stoul(input) > 0)
+            capacity = stoul(input);
+
+        PromotionPlan plan = PromotionEngine::plan(students, capacity);
+        PromotionEngine::printSummary(plan);
 
-        for (auto& student : students) 
+        cout << "Apply this allocation? (y/n): ";
+        getline(cin, input);
+        if (input != "y" && input != "Y")
         {
-            string currentClass = student.className;
-            if (!currentClass.empty() && isdigit(currentClass[0]))
-            {
-                // Promote to next class (e.g., 10-A becomes 11-A)
-                int classNum = stoi(currentClass.substr(0, currentClass.find('-')));
-                if (classNum < 12)
-                {  // Don't promote beyond 12th grade
-                    classNum++;
-                    string newClass = to_string(classNum) + currentClass.substr(currentClass.find('-'));
-                    cout << "Promoting " << student.name << " from " << currentClass << " to " << newClass << endl;
-                    student.className = newClass;
-                }
-            }
+            cout << "Allocation cancelled." << endl;
+            return;
         }
 
-        saveStudents(students);
+        saveStudents(plan.students);
         cout << "Yearly class promotion completed successfully!" << endl;
     }
 
+    void generateTimetable()
+    {
+        cout << "\n=== Generate Timetable ===" << endl;
+        vector<TeacherRecord> teachers = loadTeachers();
+        if (teachers.empty())
+        {
+            cout << "No teachers found." << endl;
+            return;
+        }
+
+        string input;
+        int days = 5;
+        int periods = 8;
+        cout << "School days per week (1-6) [5]: ";
+        getline(cin, input);
+        if (!input.empty() && all_of(input.begin(), input.end(), ::isdigit) && stoi(input) >= 1 && stoi(input) <= 6)
+            days = stoi(input);
+        cout << "Periods per day [8]: ";
+        getline(cin, input);
+        if (!input.empty() && all_of(input.begin(), input.end(), ::isdigit) && stoi(input) >= 1 && stoi(input) * days <= 64)
+            periods = stoi(input);
+
+        cout << "Scheduling " << days << " days x " << periods << " periods..." << endl;
+        TimetablePlan plan = TimetableSolver::solve(teachers, days, periods);
+        TimetableSolver::printSummary(plan);
+        if (!plan.solved)
+            return;
+
+        cout << "Replace timetable.txt with this timetable? (y/n): ";
+        getline(cin, input);
+        if (input != "y" && input != "Y")
+        {
+            cout << "Timetable discarded." << endl;
+            return;
+        }
+
+        if (TimetableSolver::save(plan))
+            cout << "Timetable saved with " << plan.rows.size() << " lessons." << endl;
+        else
+            cout << "Error: could not write timetable.txt" << endl;
+    }
+
+    void viewFeeDefaulters()
+    {
+        cout << "\n=== Fee Defaulters ===" << endl;
+        vector<FeeAccount> owing = FeeLedger::instance().defaulters();
+        if (owing.empty())
+        {
+            cout << "No outstanding fees." << endl;
+            return;
+        }
+
+        map<string, StudentRecord> byId;
+        for (auto& student : loadStudents())
+            byId[student.id] = student;
+
+        Paisa total = 0;
+        ConsoleTable table;
+        table.column("ID", 10).column("Name", 22).column("Class", 8).column("Outstanding", 14, ConsoleTable::Right).column("Entries", 8, ConsoleTable::Right).underlined();
+        for (const auto& account : owing)
+        {
+            auto student = byId.find(account.studentId);
+            table.cell(account.studentId).cell(student == byId.end() ? "-" : student->second.name).cell(student == byId.end() ? "-" : student->second.className);
+            table.cell(Money::format(account.balance)).cell(account.entries);
+            total += account.balance;
+        }
+        string out;
+        table.render(out);
+        out += to_string(owing.size()) + " student(s) owe " + Money::format(total) + "\n";
+        cout << out;
+    }
+
+    void importAttendance()
+    {
+        cout << "\n=== Import Attendance ===" << endl;
+        string path;
+        cout << "Enter device export file: ";
+        getline(cin, path);
+        if (Storage::fileSize(path) < 0)
+        {
+            cout << "Cannot open " << path << "!" << endl;
+            return;
+        }
+        AttendanceImport::printResult(AttendanceImport().run(path));
+    }
+
+    // Teachers and students log in with their name, parents with their contact
+    void issueLoginCode()
+    {
+        cout << "\n=== Issue Login Code ===" << endl;
+        string role, username;
+        cout << "Role (admin/teacher/student/parent/principal): ";
+        getline(cin, role);
+        role = Utils::toLower(role);
+        if (!CredentialStore::isRole(role))
+        {
+            cout << "Unknown role!" << endl;
+            return;
+        }
+        cout << "Username: ";
+        getline(cin, username);
+        if (username.empty())
+        {
+            cout << "Username cannot be empty!" << endl;
+            return;
+        }
+
+        CredentialStore& credentials = CredentialStore::instance();
+        string code = credentials.open() ? credentials.issueCode(role, username) : string();
+        if (code.empty())
+        {
+            cout << "Error: could not issue a code!" << endl;
+            return;
+        }
+        cout << "One-time code for " << username << ": " << code << endl;
+        cout << "It replaces any current password and is changed at the next login." << endl;
+    }
+
+    void checkTimetable()
+    {
+        cout << "\n=== Check Timetable ===" << endl;
+        TimetableCheck timetable;
+        timetable.load();
+        const vector<TimetableEntry>& entries = timetable.entries();
+        const vector<Clash>& clashes = timetable.clashes();
+
+        cout << entries.size() << " lessons checked";
+        if (timetable.unreadableEntries() > 0)
+            cout << ", " << timetable.unreadableEntries() << " skipped (day or period not recognised)";
+        cout << "." << endl;
+        if (clashes.empty())
+        {
+            cout << "No double bookings found." << endl;
+            return;
+        }
+
+        ConsoleTable table;
+        table.column("Clash", 9).column("Name", 12).column("Day", 11).column("Period", 8).column("First lesson", 20).column("Second lesson", 20).rules(80);
+        for (const auto& clash : clashes)
+        {
+            const TimetableEntry& first = entries[clash.first];
+            const TimetableEntry& second = entries[clash.second];
+            table.cell(TimetableCheck::ownerName(clash.owner)).cell(clash.name).cell(second.day).cell(second.period);
+            table.cell(first.teacherId + " " + first.className + " " + first.room);
+            table.cell(second.teacherId + " " + second.className + " " + second.room);
+        }
+        table.print();
+        cout << clashes.size() << " double booking(s) found." << endl;
+    }
+
     void displayMenu() override
     {
         int choice;
         do {
             cout << "\n=== ADMIN MENU ===" << endl;
-            cout << "1. Manage Students\n2. Manage Teachers\n3. Manage Staff\n" << "4. Process Payments\n5. Handle Leave Requests\n" << "6. Generate Fee Challans\n7. Yearly Class Allocation\n" << "0. Logout\nEnter choice: ";
+            cout << "1. Manage Students\n2. Manage Teachers\n3. Manage Staff\n" << "4. Process Payments\n5. Handle Leave Requests\n" << "6. Generate Fee Challans\n7. Yearly Class Allocation\n" << "8. Compact Data Files\n9. Close Term\n10. Search by Name\n11. Generate Timetable\n12. Check Timetable\n13. Fee Defaulters\n14. Import Attendance\n15. Issue Login Code\n0. Logout\nEnter choice: ";
             cin >> choice;
             Utils::clearInputBuffer();
 
@@ -356,6 +607,14 @@ public:
             case 5: handleLeaveRequests(); break;
             case 6: generateFeeChallans(); break;
             case 7: yearlyClassAllocation(); break;
+            case 8: compactDataFiles(); break;
+            case 9: closeTerm(); break;
+            case 10: searchNames(); break;
+            case 11: generateTimetable(); break;
+            case 12: checkTimetable(); break;
+            case 13: viewFeeDefaulters(); break;
+            case 14: importAttendance(); break;
+            case 15: issueLoginCode(); break;
             case 0: cout << "Logging out...\n"; break;
             default: cout << "Invalid choice!" << endl;
             }
@@ -366,33 +625,13 @@ private:
     // Student Management
     vector<StudentRecord> loadStudents() 
     {
-        vector<StudentRecord> students;
-        ifstream file("students.txt");
-        string line;
-
-        while (getline(file, line)) 
-        {
-            if (line.empty() || line[0] == '[') continue;
-
-            vector<string> parts = Utils::parseRecord(line);
-            if (parts.size() >= 6) {
-                students.emplace_back(parts[0], parts[1], parts[2], parts[3], parts[4], parts[5]);
-            }
-        }
-
-        return students;
+        return Schema::loadFile<StudentRecord>(Catalog::path("students.txt"));
     }
 
     void saveStudents(const vector<StudentRecord>& students)
     {
-        ofstream file("students.txt");
-        file << "[STUDENT RECORD]\n";
-
-        for (const auto& student : students) 
-        {
-            file << student.id << "|" << student.name << "|" << student.className << "|"
-                << student.rollNo << "|" << student.parentContact << "|" << student.feeStatus << "\n";
-        }
+        if (Schema::saveFile(Catalog::path("students.txt"), "[STUDENT RECORD]", students))
+            ParentIndex().rebuild(students);
     }
 
     void addStudent(vector<StudentRecord>& students) 
@@ -413,21 +652,18 @@ private:
         getline(cin, feeStatus);
 
         students.emplace_back(id, name, className, rollNo, parentContact, feeStatus);
+        indexName(NameKind::Student, id, name);
         cout << "Student added successfully!" << endl;
     }
 
-    void viewStudents(const vector<StudentRecord>& students)
+    // Listings page through the file, so edits made in this menu since the
+    // last save are written out first
+    void viewStudents(const vector<StudentRecord>& students, bool& unsaved)
     {
-        if (students.empty())
-        {
-            cout << "No students found!" << endl;
-            return;
-        }
-
-        for (const auto& student : students) 
-        {
-            cout << student.toString() << endl;
-        }
+        if (unsaved)
+            saveStudents(students);
+        unsaved = false;
+        Roster::list<StudentRecord>(Catalog::path("students.txt"), { "ID", "Name", "Class", "Roll No", "Parent Contact", "Fee Status" }, { { "class", "class" }, { "feeStatus", "fee status" } }, { { "id", "ID" }, { "name", "Name" }, { "class", "Class" }, { "rollNo", "Roll No" } }, "No students found!");
     }
 
     void updateStudent(vector<StudentRecord>& students) 
@@ -453,7 +689,10 @@ private:
         cout << "Enter new name (leave empty to keep current): ";
         getline(cin, name);
         if (!name.empty()) 
+        {
             it->name = name;
+            indexName(NameKind::Student, it->id, name);
+        }
 
         cout << "Enter new class (leave empty to keep current): ";
         getline(cin, className);
@@ -495,6 +734,7 @@ private:
             return;
         }
 
+        unindexName(NameKind::Student, it->id);
         students.erase(it);
         cout << "Student removed successfully!" << endl;
     }
@@ -502,38 +742,12 @@ private:
     // Teacher Management
     vector<TeacherRecord> loadTeachers() 
     {
-        vector<TeacherRecord> teachers;
-        ifstream file("teachers.txt");
-        string line;
-
-        while (getline(file, line))
-        {
-            if (line.empty() || line[0] == '[') 
-                continue;
-
-            vector<string> parts = Utils::parseRecord(line);
-            if (parts.size() >= 7)
-            {
-                vector<string> subjects = Utils::splitString(parts[2], ',');
-                vector<string> classes = Utils::splitString(parts[5], ',');
-                int periods = stoi(parts[6]);
-
-                teachers.emplace_back(parts[0], parts[1], subjects, parts[3], parts[4], classes, periods);
-            }
-        }
-
-        return teachers;
+        return Schema::loadFile<TeacherRecord>(Catalog::path("teachers.txt"));
     }
 
     void saveTeachers(const vector<TeacherRecord>& teachers) 
     {
-        ofstream file("teachers.txt");
-        file << "[TEACHER RECORD]\n";
-
-        for (const auto& teacher : teachers)
-        {
-            file << teacher.id << "|" << teacher.name << "|" << Utils::joinString(teacher.subjects, ",") << "|" << teacher.qualification << "|" << teacher.contact << "|" << Utils::joinString(teacher.assignedClasses, ",") << "|" << teacher.periodsPerWeek << "\n";
-        }
+        Schema::saveFile(Catalog::path("teachers.txt"), "[TEACHER RECORD]", teachers);
     }
 
     void addTeacher(vector<TeacherRecord>& teachers)
@@ -567,21 +781,16 @@ private:
         Utils::clearInputBuffer();
 
         teachers.emplace_back(id, name, subjects, qualification, contact, assignedClasses, periodsPerWeek);
+        indexName(NameKind::Teacher, id, name);
         cout << "Teacher added successfully!" << endl;
     }
 
-    void viewTeachers(const vector<TeacherRecord>& teachers) 
+    void viewTeachers(const vector<TeacherRecord>& teachers, bool& unsaved)
     {
-        if (teachers.empty())
-        {
-            cout << "No teachers found!" << endl;
-            return;
-        }
-
-        for (const auto& teacher : teachers) 
-        {
-            cout << teacher.toString() << endl;
-        }
+        if (unsaved)
+            saveTeachers(teachers);
+        unsaved = false;
+        Roster::list<TeacherRecord>(Catalog::path("teachers.txt"), { "ID", "Name", "Subjects", "Qualification", "Contact", "Classes", "Periods/Week", "Leaves" }, { { "classes", "class" }, { "subjects", "subject" } }, { { "id", "ID" }, { "name", "Name" }, { "periodsPerWeek", "Periods/Week" } }, "No teachers found!");
     }
 
     void updateTeacher(vector<TeacherRecord>& teachers) 
@@ -610,7 +819,10 @@ private:
         cout << "Enter new name (leave empty to keep current): ";
         getline(cin, name);
         if (!name.empty()) 
+        {
             it->name = name;
+            indexName(NameKind::Teacher, it->id, name);
+        }
 
         cout << "Enter new subjects (comma separated, leave empty to keep current): ";
         string subjInput;
@@ -660,6 +872,7 @@ private:
             return;
         }
 
+        unindexName(NameKind::Teacher, it->id);
         teachers.erase(it);
         cout << "Teacher removed successfully!" << endl;
     }
@@ -667,35 +880,12 @@ private:
     // Staff Management
     vector<StaffRecord> loadStaff() 
     {
-        vector<StaffRecord> staff;
-        ifstream file("staff.txt");
-        string line;
-
-        while (getline(file, line))
-        {
-            if (line.empty() || line[0] == '[') 
-                continue;
-
-            vector<string> parts = Utils::parseRecord(line);
-            if (parts.size() >= 6) 
-            {
-                staff.emplace_back(parts[0], parts[1], parts[2], parts[3], parts[4], stoi(parts[5]));
-            }
-        }
-
-        return staff;
+        return Schema::loadFile<StaffRecord>(Catalog::path("staff.txt"));
     }
 
     void saveStaff(const vector<StaffRecord>& staff) 
     {
-        ofstream file("staff.txt");
-        file << "[STAFF RECORD]\n";
-
-        for (const auto& member : staff)
-        {
-            file << member.id << "|" << member.name << "|" << member.role << "|"
-                << member.contact << "|" << member.salary << "|" << member.leavesTaken << "\n";
-        }
+        Schema::saveFile(Catalog::path("staff.txt"), "[STAFF RECORD]", staff);
     }
 
     void addStaff(vector<StaffRecord>& staff) 
@@ -715,21 +905,16 @@ private:
         getline(cin, salary);
 
         staff.emplace_back(id, name, role, contact, salary, leaves);
+        indexName(NameKind::Staff, id, name);
         cout << "Staff member added successfully!" << endl;
     }
 
-    void viewStaff(const vector<StaffRecord>& staff)
+    void viewStaff(const vector<StaffRecord>& staff, bool& unsaved)
     {
-        if (staff.empty())
-        {
-            cout << "No staff members found!" << endl;
-            return;
-        }
-
-        for (const auto& member : staff) 
-        {
-            cout << member.toString() << endl;
-        }
+        if (unsaved)
+            saveStaff(staff);
+        unsaved = false;
+        Roster::list<StaffRecord>(Catalog::path("staff.txt"), { "ID", "Name", "Role", "Contact", "Salary", "Leaves" }, { { "role", "role" } }, { { "id", "ID" }, { "name", "Name" }, { "role", "Role" }, { "salary", "Salary" } }, "No staff members found!");
     }
 
     void updateStaff(vector<StaffRecord>& staff) 
@@ -755,7 +940,10 @@ private:
         cout << "Enter new name (leave empty to keep current): ";
         getline(cin, name);
         if (!name.empty())
+        {
             it->name = name;
+            indexName(NameKind::Staff, it->id, name);
+        }
 
         cout << "Enter new role (leave empty to keep current): ";
         getline(cin, role);
@@ -792,6 +980,7 @@ private:
             return;
         }
 
+        unindexName(NameKind::Staff, it->id);
         staff.erase(it);
         cout << "Staff member removed successfully!" << endl;
     }
@@ -800,56 +989,30 @@ private:
     void processTeacherPayments(vector<TeacherRecord>& teachers)
     {
         cout << "\n=== Teacher Salary Payments ===" << endl;
-        ofstream paymentFile("salary_payments.txt", ios::app);
         string currentDate = Utils::getCurrentDate();
+        PayrollBatch batch = PayrollEngine::teachers(teachers, PayrollEngine::paidIn(currentDate.substr(0, 7)));
+        PayrollEngine::printBatch(batch);
 
-        paymentFile << "\n[TEACHER SALARIES " << currentDate << "]\n";
-
-        for (auto& teacher : teachers) 
+        if (!PayrollEngine::commit(batch, "TEACHER SALARIES", currentDate))
         {
-            // Check if salary already processed this month
-            if (isSalaryProcessed(teacher.id, currentDate.substr(0, 7))) 
-            {
-                cout << "Salary already processed for " << teacher.name << endl;
-                continue;
-            }
-
-            // Calculate salary (basic salary - deductions for excess leaves)
-            float salary = calculateTeacherSalary(teacher);
-
-            cout << "Processing payment for " << teacher.name << " (" << teacher.id << "): " << fixed << setprecision(2) << salary << endl;
-
-            paymentFile << teacher.id << "|" << teacher.name << "|" << salary << "|" << currentDate << "\n";
+            cout << "Error: could not record the payments!" << endl;
+            return;
         }
-
         cout << "Teacher salary processing complete." << endl;
     }
 
     void processStaffPayments(vector<StaffRecord>& staff) 
     {
         cout << "\n=== Staff Salary Payments ===" << endl;
-        ofstream paymentFile("salary_payments.txt", ios::app);
         string currentDate = Utils::getCurrentDate();
+        PayrollBatch batch = PayrollEngine::staff(staff, PayrollEngine::paidIn(currentDate.substr(0, 7)));
+        PayrollEngine::printBatch(batch);
 
-        paymentFile << "\n[STAFF SALARIES " << currentDate << "]\n";
-
-        for (auto& member : staff) 
+        if (!PayrollEngine::commit(batch, "STAFF SALARIES", currentDate))
         {
-            // Check if salary already processed this month
-            if (isSalaryProcessed(member.id, currentDate.substr(0, 7))) 
-            {
-                cout << "Salary already processed for " << member.name << endl;
-                continue;
-            }
-
-            // Calculate salary (basic salary - deductions for excess leaves)
-            float salary = calculateStaffSalary(member);
-
-            cout << "Processing payment for " << member.name << " (" << member.id << "): " << fixed << setprecision(2) << salary << endl;
-
-            paymentFile << member.id << "|" << member.name << "|" << salary << "|" << currentDate << "\n";
+            cout << "Error: could not record the payments!" << endl;
+            return;
         }
-
         cout << "Staff salary processing complete." << endl;
     }
 
@@ -858,118 +1021,71 @@ private:
         cout << "\n=== Student Fee Payments ===" << endl;
         vector<StudentRecord> students = loadStudents();
         string currentDate = Utils::getCurrentDate();
+        FeeLedger& ledger = FeeLedger::instance();
+        vector<FeePosting> payments;
 
         for (auto& student : students)
         {
-            // Skip if fee already paid
-            if (student.feeStatus.find("Paid till") != string::npos) {
+            // Only students with an outstanding balance
+            Paisa due = ledger.balance(student.id);
+            if (due <= 0)
                 continue;
-            }
 
-            cout << "\nStudent: " << student.name << " (" << student.id << ")" << "\nClass: " << student.className << "\nFee Status: " << student.feeStatus << "\nEnter amount received: ";
+            cout << "\nStudent: " << student.name << " (" << student.id << ")" << "\nClass: " << student.className << "\nOutstanding: " << Money::format(due) << "\nEnter amount received (blank to skip): ";
 
             string amount;
+            Paisa paid = 0;
             getline(cin, amount);
+            if (amount.empty())
+                continue;
+            if (!Money::parse(amount, paid) || paid <= 0)
+            {
+                cout << "Invalid amount! Skipping " << student.name << endl;
+                continue;
+            }
 
-            // Update fee status
-            student.feeStatus = "Paid till " + currentDate.substr(0, 7);
+            payments.push_back(FeePosting{ student.id, "Payment", currentDate.substr(0, 7), paid });
+            due -= paid;
+            student.feeStatus = due <= 0 ? "Paid till " + currentDate.substr(0, 7) : "Due " + Money::format(due);
             cout << "Fee payment recorded for " << student.name << endl;
         }
 
+        if (payments.empty())
+        {
+            cout << "No fee payments recorded." << endl;
+            return;
+        }
+        if (!ledger.post(payments, currentDate))
+        {
+            cout << "Error: could not record the payments in the fee ledger!" << endl;
+            return;
+        }
+
         // Save updated student records
         saveStudents(students);
         cout << "Fee payment processing complete." << endl;
     }
+};
 
-    bool isSalaryProcessed(const string& id, const string& monthYear)
-    {
-        ifstream paymentFile("salary_payments.txt");
-        string line;
-
-        while (getline(paymentFile, line)) {
-            if (line.find(id) != string::npos && line.find(monthYear) != string::npos) 
-            {
-                return true;
-            }
-        }
-        return false;
-    }
-
-    float calculateTeacherSalary(const TeacherRecord& teacher) 
-    {
-        // Base salary calculation (example: 2000 per period)
-        float baseSalary = teacher.periodsPerWeek * 2000 * 4; // Monthly salary
-
-        // Deduct for excess leaves (example: 500 per excess leave)
-        int allowedLeaves = 2; // 2 leaves per month allowed
-        int excessLeaves = max(0, (teacher.leavesTaken - allowedLeaves));
-        class TeacherRecord 
-        {  
-        public:  
-            string id;  
-            string name;  
-            vector<string> subjects;  
-            string qualification;  
-            string contact;  
-            vector<string> assignedClasses;  
-            int periodsPerWeek;  
-            int leavesTaken;   
-
-            TeacherRecord(const string& id, const string& name, const vector<string>& subjects,  
-                const string& qualification, const string& contact, const vector<string>& assignedClasses, int periodsPerWeek, int leavesTaken = 0)  
-                : id(id), name(name), subjects(subjects), qualification(qualification), contact(contact), assignedClasses(assignedClasses), periodsPerWeek(periodsPerWeek), leavesTaken(leavesTaken) {}  
-
-            string toString() const 
-            {  
-                string subjs = Utils::joinString(subjects, ", ");  
-                string classes = Utils::joinString(assignedClasses, ", ");  
-                return "ID: " + id + " | Name: " + name + " | Subjects: " + subjs + " | Qualification: " + qualification + " | Contact: " + contact +   " | Classes: " + classes + " | Periods/Week: " + to_string(periodsPerWeek) +   " | Leaves Taken: " + to_string(leavesTaken); // Include leavesTaken in the string representation  
-            }  
-        };
-        float deductions = excessLeaves * 500;
-
-        return max(0.0f, baseSalary - deductions);
-    }
-
-    float calculateStaffSalary(const StaffRecord& staff) 
-    {
-        // Convert string salary to float
-        float salary = stof(staff.salary);
-
-        // Deduct for excess leaves (example: 1% per excess leave)
-        int allowedLeaves = 2; // 2 leaves per month allowed
-        int excessLeaves = max(0, (staff.leavesTaken - allowedLeaves));
-        float deductions = salary * (excessLeaves * 0.01f);
-
-        return max(0.0f, salary - deductions);
-    }
-};
-
-// Teacher Class
-class Teacher : public User
-{
-private:
-    string teacherId;
-    vector<string> subjects;
-    vector<string> assignedClasses;
+// Teacher Class
+class Teacher : public User
+{
+private:
+    string teacherId;
+    vector<string> subjects;
+    vector<string> assignedClasses;
 
 public:
     Teacher(const string& uname, const string& pwd) : User(uname, pwd)
     {
         // Load teacher data from file
-        ifstream file("teachers.txt");
-        string line;
-
-        while (getline(file, line)) {
-            if (line.empty() || line[0] == '[')
-                continue;
-
-            vector<string> parts = Utils::parseRecord(line);
-            if (parts.size() >= 2 && parts[1] == username) 
+        for (const auto& teacher : Schema::loadFile<TeacherRecord>(Catalog::path("teachers.txt")))
+        {
+            if (teacher.name == username) 
             {
-                teacherId = parts[0];
-                subjects = Utils::splitString(parts[2], ',');
-                assignedClasses = Utils::splitString(parts[5], ',');
+                teacherId = teacher.id;
+                subjects = teacher.subjects;
+                assignedClasses = teacher.assignedClasses;
                 break;
             }
         }
@@ -1006,21 +1122,9 @@ public:
         }
 
         // Load students for the selected class
-        vector<StudentRecord> students;
-        ifstream file("students.txt");
-        string line;
-
-        while (getline(file, line)) 
-        {
-            if (line.empty() || line[0] == '[') 
-                continue;
-
-            vector<string> parts = Utils::parseRecord(line);
-            if (parts.size() >= 3 && parts[2] == selectedClass) 
-            {
-                students.emplace_back(parts[0], parts[1], parts[2], parts[3], parts[4], parts[5]);
-            }
-        }
+        vector<StudentRecord> students = Schema::loadFile<StudentRecord>(Catalog::path("students.txt"), [&selectedClass](const StudentRecord& s) {
+            return s.className == selectedClass;
+            });
 
         if (students.empty())
         {
@@ -1029,8 +1133,7 @@ public:
         }
 
         // Mark attendance for each student
-        ofstream attFile("attendance.txt", ios::app);
-        attFile << "\n[ATTENDANCE " << date << " CLASS " << selectedClass << "]\n";
+        vector<AttendanceLine> marks;
 
         for (const auto& student : students)
         {
@@ -1039,9 +1142,10 @@ public:
             cin >> present;
             Utils::clearInputBuffer();
 
-            attFile << student.id << ": " << (tolower(present) == 'y' ? "Present" : "Absent") << "\n";
+            marks.push_back(AttendanceLine{ student.id, tolower(present) == 'y' ? "Present" : "Absent" });
         }
 
+        SummaryStore::instance().commitAttendance(date, selectedClass, marks);
         cout << "Attendance marked successfully for class " << selectedClass << "!\n";
     }
 
@@ -1070,21 +1174,9 @@ public:
         }
 
         // Load students
-        vector<StudentRecord> students;
-        ifstream file("students.txt");
-        string line;
-
-        while (getline(file, line))
-        {
-            if (line.empty() || line[0] == '[') 
-                continue;
-
-            vector<string> parts = Utils::parseRecord(line);
-            if (parts.size() >= 3 && parts[2] == selectedClass) 
-            {
-                students.emplace_back(parts[0], parts[1], parts[2], parts[3], parts[4], parts[5]);
-            }
-        }
+        vector<StudentRecord> students = Schema::loadFile<StudentRecord>(Catalog::path("students.txt"), [&selectedClass](const StudentRecord& s) {
+            return s.className == selectedClass;
+            });
 
         if (students.empty())
         {
@@ -1098,8 +1190,7 @@ public:
         getline(cin, assignmentType);
 
         // Enter grades
-        ofstream gradeFile("grades.txt", ios::app);
-        gradeFile << "\n[GRADES " << assignmentType << " CLASS " << selectedClass << " TEACHER " << teacherId << "]\n";
+        vector<GradeLine> grades;
 
         for (const auto& student : students)
         {
@@ -1115,7 +1206,7 @@ public:
                     cout << "Invalid grade! Must be 0-100. Skipping...\n";
                     continue;
                 }
-                gradeFile << student.id << "|" << grade << "\n";
+                grades.push_back(GradeLine{ student.id, grade });
             }
             catch (...) 
             {
@@ -1123,6 +1214,7 @@ public:
             }
         }
 
+        SummaryStore::instance().commitGrades(selectedClass, assignmentType, teacherId, grades);
         cout << "Grades entered successfully!\n";
     }
 
@@ -1149,22 +1241,16 @@ public:
             return;
         }
 
-        // Load students
-        vector<StudentRecord> students;
-        ifstream studentFile("students.txt");
-        string line;
-
-        while (getline(studentFile, line))
-        {
-            if (line.empty() || line[0] == '[')
-                continue;
+        // Everything below is released together when the arena goes out of scope
+        OperationArena arena;
 
-            vector<string> parts = Utils::parseRecord(line);
-            if (parts.size() >= 3 && parts[2] == selectedClass)
-            {
-                students.emplace_back(parts[0], parts[1], parts[2], parts[3], parts[4], parts[5]);
-            }
-        }
+        // Load students
+        pmr::string studentText = Storage::readAll(Catalog::path("students.txt"), arena.get());
+        pmr::vector<StudentView> students(arena.get());
+        Schema::forEach<StudentView>(studentText, [&](const StudentView& s) {
+            if (s.className == selectedClass)
+                students.push_back(s);
+            }, arena.get());
 
         if (students.empty()) 
         {
@@ -1178,48 +1264,52 @@ public:
         getline(cin, currentTerm);
 
         // Generate report for each student
-        ofstream reportFile("termReports.txt", ios::app);
-        reportFile << "\n[TERM REPORTS " << currentTerm << " CLASS " << selectedClass << "]\n";
+        DateRange term = DateRange::term(currentTerm);
+        pmr::string reportFile(arena.get());
+        reportFile += "\n[TERM REPORTS " + currentTerm + " CLASS " + selectedClass + "]\n";
 
+        TypeScores noScores;
         for (const auto& student : students)
         {
-            // Get grades
-            map<string, int> grades = loadStudentGrades(student.id);
-            // Get attendance
-            pair<int, int> attendance = loadStudentAttendance(student.id);
-
-            // Calculate weighted grade
-            float weightedGrade = 0.0f;
-            if (grades.count("quiz")) weightedGrade += grades["quiz"] * 0.3f;
-            if (grades.count("midterm")) weightedGrade += grades["midterm"] * 0.4f;
-            if (grades.count("final")) weightedGrade += grades["final"] * 0.3f;
+            // Scores this class's teachers entered for the student
+            StudentSummary summary = SummaryStore::instance().get(string(student.id));
+            auto found = summary.subjects.find(selectedClass);
+            const TypeScores& scores = found == summary.subjects.end() ? noScores : found->second;
+            pair<int, int> attendance = summary.attendance(term);
+            float weightedGrade = StudentSummary::weighted(scores);
 
             // Generate report
-            reportFile << "STUDENT: " << student.name << " (" << student.id << ")\n";
-            reportFile << "CLASS: " << selectedClass << "\n";
-            reportFile << "TERM: " << currentTerm << "\n";
+            reportFile.append("STUDENT: ").append(student.name).append(" (").append(student.id).append(")\n");
+            reportFile.append("CLASS: ").append(selectedClass).append("\n");
+            reportFile.append("TERM: ").append(currentTerm).append("\n");
 
             // Grades section
-            reportFile << "GRADES:\n";
-            for (const auto& grade : grades) 
+            reportFile += "GRADES:\n";
+            for (const auto& grade : scores) 
             {
-                reportFile << "  " << grade.first << ": " << grade.second << "/100\n";
+                reportFile.append("  ").append(grade.first).append(": ").append(to_string(grade.second)).append("/100\n");
             }
-            reportFile << "WEIGHTED GRADE: " << weightedGrade << "/100\n";
+            reportFile += "WEIGHTED GRADE: ";
+            ArenaLoad::appendNumber(reportFile, weightedGrade);
+            reportFile += "/100\n";
+            reportFile.append("CLASS RANK: ").append(RankingEngine::describe(RankingEngine::instance().standing(string(student.id), false))).append("\n");
 
             // Attendance section
             float attendancePercent = (attendance.first * 100.0f) / max(1, attendance.second);
-            reportFile << "ATTENDANCE: " << attendance.first << "/" << attendance.second
-                << " (" << attendancePercent << "%)\n";
+            reportFile.append("ATTENDANCE: ").append(to_string(attendance.first)).append("/").append(to_string(attendance.second)).append(" (");
+            ArenaLoad::appendNumber(reportFile, attendancePercent);
+            reportFile += "%)\n";
 
             // Comments
-            reportFile << "COMMENTS: \n";
-            reportFile << "----------------------------------------\n";
+            reportFile += "COMMENTS: \n";
+            reportFile += "----------------------------------------\n";
 
             // Print to console
             cout << "\nGenerated report for " << student.name << " (" << student.id << ")\n";
         }
 
+        Storage::commitSection(Catalog::path("termReports.txt"), string(reportFile), Utils::getCurrentDate());
+        ReportCatalog().refresh();
         cout << "\nReports generated successfully for " << selectedClass << "!\n";
         cout << "Saved to termReports.txt\n";
     }
@@ -1248,8 +1338,7 @@ public:
         cout << "Enter reason: ";
         getline(cin, reason);
 
-        ofstream file("leave_requests.txt", ios::app);
-        file << teacherId << "|" << username << "|" << startDate << "|" << endDate << "|" << reason << "|Pending\n";
+        Storage::appendText(Catalog::path("leave_requests.txt"), teacherId + "|" + username + "|" + startDate + "|" + endDate + "|" + reason + "|Pending\n");
 
         cout << "Leave application submitted successfully!" << endl;
     }
@@ -1257,39 +1346,53 @@ public:
     void viewTimetable()
     {
         cout << "\n=== View Timetable ===" << endl;
-        ifstream file("timetable.txt");
-        if (!file.is_open())
-        {
-            cout << "Timetable not found or unable to open!" << endl;
-            return;
-        }
+        TimetableCheck timetable;
+        timetable.load();
 
-        cout << "\nYour Weekly Schedule:\n";
-        cout << "--------------------------------------------------\n";
-        cout << left << setw(10) << "Day" << setw(15) << "Period"
-            << setw(15) << "Class" << setw(15) << "Room" << endl;
-        cout << "--------------------------------------------------\n";
-
-        string line;
-        bool found = false;
-
-        while (getline(file, line)) {
-            if (line.empty() || line[0] == '[') 
-                continue;
+        ConsoleTable table;
+        table.column("Day", 10).column("Period", 15).column("Class", 15).column("Room", 15).column("", 8).rules(58);
 
-            vector<string> parts = Utils::parseRecord(line);
-            if (parts.size() >= 5 && parts[2] == teacherId)
+        size_t clashes = 0;
+        for (const auto& entry : timetable.entries())
+        {
+            if (entry.teacherId == teacherId)
             {
-                cout << left << setw(10) << parts[0] << setw(15) << parts[1] << setw(15) << parts[3] << setw(15) << parts[4] << endl;
-                found = true;
+                table.cell(entry.day).cell(entry.period).cell(entry.className).cell(entry.room).cell(entry.clash ? "CLASH" : "");
+                clashes += entry.clash;
             }
         }
 
-        if (!found) 
+        if (table.empty()) 
         {
             cout << "No timetable entries found for you." << endl;
+            return;
         }
-        cout << "--------------------------------------------------\n";
+        cout << "\nYour Weekly Schedule:\n";
+        table.print();
+        if (clashes > 0)
+            cout << clashes << " of these lessons are double-booked; please inform the admin." << endl;
+    }
+
+    void viewRankings()
+    {
+        cout << "\n=== Class Rankings ===" << endl;
+        cout << "Your assigned classes: ";
+        for (const auto& cls : assignedClasses)
+        {
+            cout << cls << " ";
+        }
+        cout << endl;
+
+        string selectedClass;
+        cout << "Enter class: ";
+        getline(cin, selectedClass);
+        if (find(assignedClasses.begin(), assignedClasses.end(), selectedClass) == assignedClasses.end())
+        {
+            cout << "You are not assigned to this class!\n";
+            return;
+        }
+
+        RankingEngine::instance().printBoard(selectedClass, false, 5);
     }
 
     void displayMenu() override 
@@ -1298,7 +1401,7 @@ public:
         do {
             cout << "\n=== TEACHER MENU ===" << endl;
             cout << "1. Mark Attendance\n2. Enter Grades\n3. Generate Reports\n"
-                << "4. Apply for Leave\n5. View Timetable\n0. Logout\nEnter choice: ";
+                << "4. Apply for Leave\n5. View Timetable\n6. Class Rankings\n0. Logout\nEnter choice: ";
             cin >> choice;
             Utils::clearInputBuffer();
 
@@ -1309,6 +1412,7 @@ public:
             case 3: generateReports(); break;
             case 4: applyForLeave(); break;
             case 5: viewTimetable(); break;
+            case 6: viewRankings(); break;
             case 0: cout << "Logging out...\n"; break;
             default: cout << "Invalid choice!" << endl;
             }
@@ -1316,87 +1420,11 @@ public:
     }
 
 private:
-    map<string, int> loadStudentGrades(const string& studentId) 
-    {
-        map<string, int> grades;
-        ifstream gradeFile("grades.txt");
-        string line;
-        string currentSection;
-
-        while (getline(gradeFile, line)) 
-        {
-            if (line.empty()) continue;
-
-            if (line[0] == '[') 
-            {
-                currentSection = line;
-                continue;
-            }
-
-            if (currentSection.find(studentId) != string::npos) 
-            {
-                vector<string> parts = Utils::parseRecord(line);
-                if (parts.size() >= 2)
-                {
-                    string type = currentSection.substr(currentSection.find("GRADES") + 6);
-                    type = type.substr(0, type.find(" "));
-                    grades[type] = stoi(parts[1]);
-                }
-            }
-        }
-
-        return grades;
-    }
-
-    pair<int, int> loadStudentAttendance(const string& studentId) 
-    {
-        int present = 0, total = 0;
-        ifstream attFile("attendance.txt");
-        string line;
-        string currentDate;
-
-        while (getline(attFile, line))
-        {
-            if (line.empty()) 
-                continue;
-
-            if (line.find("[ATTENDANCE") != string::npos) 
-            {
-                currentDate = line;
-                total++;
-                continue;
-            }
-
-            if (line.find(studentId) != string::npos && line.find("Present") != string::npos) 
-            {
-                present++;
-            }
-        }
-
-        return make_pair(present, total);
-    }
-
     vector<StudentRecord> loadStudentsForClass()
     {
-        vector<StudentRecord> students;
-        ifstream file("students.txt");
-        string line;
-
-        while (getline(file, line)) {
-            if (line.empty() || line[0] == '[') 
-                continue;
-
-            vector<string> parts = Utils::parseRecord(line);
-            if (parts.size() >= 3)
-            {
-                if (find(assignedClasses.begin(), assignedClasses.end(), parts[2]) != assignedClasses.end()) 
-                {
-                    students.emplace_back(parts[0], parts[1], parts[2], parts[3], parts[4], parts[5]);
-                }
-            }
-        }
-
-        return students;
+        return Schema::loadFile<StudentRecord>(Catalog::path("students.txt"), [this](const StudentRecord& s) {
+            return find(assignedClasses.begin(), assignedClasses.end(), s.className) != assignedClasses.end();
+            });
     }
 };
 
@@ -1410,23 +1438,17 @@ private:
 
     string getTeacherName(const string& teacherId) 
     {
-        ifstream file("teachers.txt");
-        if (!file.is_open())
+        if (Storage::fileSize(Catalog::path("teachers.txt")) < 0)
         {
             cerr << "Error opening teachers file!" << endl;
             return "Unknown";
         }
 
-        string line;
-        while (getline(file, line))
+        for (const auto& teacher : Schema::loadFile<TeacherRecord>(Catalog::path("teachers.txt")))
         {
-            if (line.empty() || line[0] == '[') 
-                continue;
-
-            vector<string> parts = Utils::parseRecord(line);
-            if (parts.size() >= 2 && parts[0] == teacherId)
+            if (teacher.id == teacherId)
             {
-                return parts[1];
+                return teacher.name;
             }
         }
         return "Unknown Teacher";
@@ -1436,19 +1458,13 @@ public:
     Student(const string& uname, const string& pwd) : User(uname, pwd)
     {
         // Load student data from file
-        ifstream file("students.txt");
-        string line;
-
-        while (getline(file, line)) {
-            if (line.empty() || line[0] == '[') 
-                continue;
-
-            vector<string> parts = Utils::parseRecord(line);
-            if (parts.size() >= 2 && parts[1] == username) 
+        for (const auto& student : Schema::loadFile<StudentRecord>(Catalog::path("students.txt")))
+        {
+            if (student.name == username) 
             {
-                studentId = parts[0];
-                className = parts[2];
-                parentContact = parts[4];
+                studentId = student.id;
+                className = student.className;
+                parentContact = student.parentContact;
                 break;
             }
         }
@@ -1459,50 +1475,37 @@ public:
         cout << "\n=== My Timetable ===" << endl;
         cout << "Student Class: " << className << endl;
 
-        ifstream file("timetable.txt");
-        if (!file.is_open()) 
-        {
-            cout << "ERROR: Could not open timetable file!" << endl;
-            return;
-        }
+        TimetableCheck timetable;
+        timetable.load();
 
-        cout << "\nWeekly Schedule for " << className << ":\n";
-        cout << "-------------------------------------------------------------\n";
-        cout << left << setw(10) << "Day" << setw(12) << "Period"
-            << setw(25) << "Teacher" << setw(15) << "Room" << endl;
-        cout << "-------------------------------------------------------------\n";
+        ConsoleTable table;
+        table.column("Day", 10).column("Period", 12).column("Teacher", 25).column("Room", 15).column("", 8).rules(69);
 
-        string line;
-        bool found = false;
-
-        while (getline(file, line)) 
+        size_t clashes = 0;
+        for (const auto& entry : timetable.entries())
         {
-            if (line.empty() || line[0] == '[' || line.find("--") != string::npos) 
-            {
-                continue;
-            }
-
-            vector<string> parts = Utils::parseRecord(line);
-
-            if (parts.size() >= 5 && parts[3] == className)
+            if (entry.className == className)
             {
-                string teacherName = getTeacherName(parts[2]);
-                cout << left << setw(10) << parts[0] << setw(12) << parts[1] << setw(25) << teacherName << setw(15) << parts[4] << endl;
-                found = true;
+                table.cell(entry.day).cell(entry.period).cell(getTeacherName(entry.teacherId)).cell(entry.room).cell(entry.clash ? "CLASH" : "");
+                clashes += entry.clash;
             }
         }
 
-        if (!found) 
+        if (table.empty()) 
         {
             cout << "No classes found for your class (" << className << ")" << endl;
+            return;
         }
-        cout << "-------------------------------------------------------------\n";
+        cout << "\nWeekly Schedule for " << className << ":\n";
+        table.print();
+        if (clashes > 0)
+            cout << clashes << " of these lessons are double-booked; the timetable is being corrected." << endl;
     }
 
     void viewAssignments() 
     {
     cout << "\n=== View Assignments ===" << endl;
-    ifstream file("assignments_due.txt");
+    ifstream file(Catalog::path("assignments_due.txt"));
 
     if (!file.is_open()) 
     {
@@ -1510,14 +1513,10 @@ public:
         return;
     }
 
-    bool found = false;
+    ConsoleTable table;
+    table.column("Subject", 15).column("Assignment", 30).column("Due Date", 12).rules(50);
     string line;
 
-    cout << "--------------------------------------------------\n";
-    cout << left << setw(15) << "Subject" << setw(30) << "Assignment" 
-         << setw(12) << "Due Date" << endl;
-    cout << "--------------------------------------------------\n";
-
     while (getline(file, line)) 
     {
         if (line.empty() || line[0] == '[') 
@@ -1527,29 +1526,28 @@ public:
         
         if (parts.size() >= 4 && Utils::toUpper(parts[1]) == Utils::toUpper(className)) 
         {
-            cout << setw(15) << left << parts[0] << setw(30) << left << parts[2] << setw(12) << left << parts[3] << endl;
-            found = true;
+            table.cell(parts[0]).cell(parts[2]).cell(parts[3]);
         }
     }
 
-    if (!found)
+    if (table.empty())
     {
         cout << "No assignments found for your class (" << className << ")" << endl;
+        return;
     }
-    cout << "--------------------------------------------------\n";
+    table.print();
 }
 
     void viewGrades()
     {
         cout << "\n=== View Grades ===" << endl;
-        ifstream file("grades.txt");
-
-        if (!file.is_open())
+        if (Storage::fileSize(Catalog::path("grades.txt")) < 0)
         {
             cout << "No grades recorded yet. Possible reasons:\n" << "1. Teachers haven't entered grades\n" << "2. grades.txt file doesn't exist\n";
             return;
         }
 
+        istringstream file(Storage::readCommitted(Catalog::path("grades.txt")));
         map<string, map<string, int>> grades;
         string currentSection;
         string line;
@@ -1565,18 +1563,14 @@ public:
                 continue;
             }
 
-            vector<string> parts;
-            size_t start = 0;
-            size_t end = line.find('|');
-            while (end != string::npos)
+            GradeLine grade;
+            if (!Schema::parseLine(line, grade))
             {
-                parts.push_back(line.substr(start, end - start));
-                start = end + 1;
-                end = line.find('|', start);
+                cout << "Warning: Invalid grade line in " << currentSection << endl;
+                continue;
             }
-            parts.push_back(line.substr(start));
 
-            if (parts.size() >= 2 && parts[0] == studentId) 
+            if (grade.studentId == studentId) 
             {
                 // Extract subject from section header
                 size_t subjectStart = currentSection.find("CLASS") + 6;
@@ -1588,12 +1582,7 @@ public:
                 size_t typeEnd = currentSection.find(" ", typeStart);
                 string type = currentSection.substr(typeStart, typeEnd - typeStart);
 
-                try {
-                    grades[subject][type] = stoi(parts[1]);
-                }
-                catch (...) {
-                    cout << "Warning: Invalid grade format for " << subject << endl;
-                }
+                grades[subject][type] = grade.score;
             }
         }
 
@@ -1604,61 +1593,62 @@ public:
         }
 
         // Display grades
-        cout << "\nGrade Report:\n";
-        cout << "--------------------------------------------------\n";
-        cout << left << setw(15) << "Subject" << setw(10) << "Quiz" << setw(10) << "Midterm" << setw(10) << "Final" << endl;
-        cout << "--------------------------------------------------\n";
-
+        ConsoleTable table;
+        table.column("Subject", 15).column("Quiz", 10).column("Midterm", 10).column("Final", 10).rules(50);
         for (const auto& subject : grades) {
-            cout << setw(15) << left << subject.first;
-            cout << setw(10) << (subject.second.count("quiz") ? to_string(subject.second.at("quiz")) : "-");
-            cout << setw(10) << (subject.second.count("midterm") ? to_string(subject.second.at("midterm")) : "-");
-            cout << setw(10) << (subject.second.count("final") ? to_string(subject.second.at("final")) : "-");
-            cout << endl;
+            table.cell(subject.first);
+            for (const char* type : { "quiz", "midterm", "final" }) {
+                auto score = subject.second.find(type);
+                if (score != subject.second.end())
+                    table.cell(score->second);
+                else
+                    table.cell("-");
+            }
         }
-        cout << "--------------------------------------------------\n";
+        cout << "\nGrade Report:\n";
+        table.print();
     }
 
     void viewAttendance() 
     {
         cout << "\n=== View Attendance ===" << endl;
-        ifstream file("attendance.txt");
+        DateRange range = DateRange::prompt();
 
-        if (!file.is_open())
-        {
-            cout << "No attendance records found. Possible reasons:\n" << "1. Attendance not taken yet\n" << "2. attendance.txt file doesn't exist\n";
-            return;
-        }
-
-        string line;
-        string currentDate;
         int presentDays = 0, totalDays = 0;
-        bool found = false;
-
-        while (getline(file, line)) {
-            if (line.empty())
-                continue;
-
-            if (line.find("[ATTENDANCE") != string::npos) {
-                currentDate = line.substr(11, 10);
-                totalDays++;
-                continue;
-            }
+        ConsoleTable table;
+        table.column("Date", 12).column("Status", 10);
 
-            if (line.find(studentId) != string::npos) {
-                string status = line.substr(line.find(":") + 2);
-                cout << "Date: " << currentDate << " - " << status << endl;
-                found = true;
-                if (status == "Present") presentDays++;
-            }
+        for (const auto& entry : AttendanceStore::instance().forStudent(studentId, range)) {
+            table.cell(entry.date).cell(entry.present ? "Present" : "Absent");
+            totalDays++;
+            if (entry.present) presentDays++;
         }
 
-        if (!found) {
+        if (table.empty()) {
             cout << "No attendance records found for you." << endl;
         }
         else {
             float percentage = (float)presentDays / totalDays * 100;
-            cout << "\nSummary: " << presentDays << "/" << totalDays << " days present (" << fixed << setprecision(1) << percentage << "%)" << endl;
+            string out;
+            table.render(out);
+            out += "\nSummary: " + to_string(presentDays) + "/" + to_string(totalDays) + " days present (";
+            ConsoleTable::appendFixed(out, percentage, 1);
+            out += "%)\n";
+            cout << out;
+        }
+    }
+
+    void viewPastTerm()
+    {
+        cout << "\n=== View Past Term ===" << endl;
+        string termName;
+        cout << "Enter term (e.g., Fall-2023): ";
+        getline(cin, termName);
+
+        TermArchive archive(termName);
+        if (!archive.load() || !archive.printStudent(studentId))
+        {
+            cout << "No archived records found for " << termName << "." << endl;
         }
     }
 
@@ -1666,7 +1656,7 @@ public:
         int choice;
         do {
             cout << "\n=== STUDENT MENU ===" << endl;
-            cout << "1. View Timetable\n2. View Assignments\n3. View Grades\n" << "4. View Attendance\n0. Logout\nEnter choice: ";
+            cout << "1. View Timetable\n2. View Assignments\n3. View Grades\n" << "4. View Attendance\n5. View Past Term\n0. Logout\nEnter choice: ";
             cin >> choice;
             Utils::clearInputBuffer();
 
@@ -1675,6 +1665,7 @@ public:
             case 2: viewAssignments(); break;
             case 3: viewGrades(); break;
             case 4: viewAttendance(); break;
+            case 5: viewPastTerm(); break;
             case 0: cout << "Logging out...\n"; break;
             default: cout << "Invalid choice!" << endl;
             }
@@ -1688,111 +1679,8 @@ private:
     string parentId;
     vector<string> childrenIds;
 
-    StudentRecord getChildRecord(const string& childId) {
-        ifstream file("students.txt");
-        string line;
-
-        while (getline(file, line)) {
-            if (line.empty() || line[0] == '[')
-                continue;
-
-            vector<string> parts = Utils::parseRecord(line);
-            if (parts.size() >= 6 && parts[0] == childId) {
-                return StudentRecord(parts[0], parts[1], parts[2], parts[3], parts[4], parts[5]);
-            }
-        }
-        return StudentRecord("", "", "", "", "", "");
-    }
-
-    map<string, map<string, int>> getChildGrades(const string& childId) {
-        map<string, map<string, int>> gradesBySubject;
-        ifstream gradeFile("grades.txt");
-        string line;
-        string currentSection;
-
-        while (getline(gradeFile, line)) {
-            if (line.empty()) 
-                continue;
-
-            if (line[0] == '[') {
-                currentSection = line;
-                continue;
-            }
-
-            vector<string> parts = Utils::parseRecord(line);
-            if (parts.size() >= 2 && parts[0] == childId) {
-                size_t subjectPos = currentSection.find("CLASS") + 6;
-                size_t subjectEnd = currentSection.find(" ", subjectPos);
-                string subject = currentSection.substr(subjectPos, subjectEnd - subjectPos);
-
-                size_t typePos = currentSection.find("GRADES") + 7;
-                size_t typeEnd = currentSection.find(" ", typePos);
-                string type = currentSection.substr(typePos, typeEnd - typePos);
-
-                gradesBySubject[subject][type] = stoi(parts[1]);
-            }
-        }
-        return gradesBySubject;
-    }
-
-    pair<int, int> getChildAttendance(const string& childId) {
-        int present = 0, total = 0;
-        ifstream attFile("attendance.txt");
-        string line;
-
-        while (getline(attFile, line)) {
-            if (line.empty()) 
-                continue;
-
-            if (line.find("[ATTENDANCE") != string::npos) {
-                total++;
-                continue;
-            }
-
-            if (line.find(childId) != string::npos && line.find("Present") != string::npos) {
-                present++;
-            }
-        }
-        return make_pair(present, total);
-    }
-
-    float calculateOverallAverage(const map<string, map<string, int>>& gradesBySubject) {
-        float total = 0.0f;
-        int count = 0;
-
-        for (const auto& subject : gradesBySubject) {
-            float weightedAvg = 0.0f;
-            if (subject.second.count("quiz"))
-                weightedAvg += subject.second.at("quiz") * 0.3f;
-            if (subject.second.count("midterm")) 
-                weightedAvg += subject.second.at("midterm") * 0.4f;
-            if (subject.second.count("final"))
-                weightedAvg += subject.second.at("final") * 0.3f;
-
-            total += weightedAvg;
-            count++;
-        }
-
-        return count > 0 ? total / count : 0.0f;
-    }
-
 public:
-    Parent(const string& uname, const string& pwd) : User(uname, pwd)
-    {
-        // Load parent data from file
-        ifstream file("students.txt");
-        string line;
-
-        while (getline(file, line)) {
-            if (line.empty() || line[0] == '[')
-                continue;
-
-            vector<string> parts = Utils::parseRecord(line);
-            if (parts.size() >= 5 && parts[4] == username) {
-                childrenIds.push_back(parts[0]);
-            }
-        }
-    }
+    Parent(const string& uname, const string& pwd) : User(uname, pwd), childrenIds(ParentIndex().childrenOf(uname)) {}
 
     void viewChildProgress() {
         cout << "\n=== Child Progress Report ===" << endl;
@@ -1802,80 +1690,95 @@ public:
             return;
         }
 
+        // Everything below is released together when the arena goes out of scope
+        OperationArena arena;
+        pmr::string studentText = Storage::readAll(Catalog::path("students.txt"), arena.get());
+        pmr::unordered_map<string_view, StudentView> children(arena.get());
+
+        // Names and classes from the roster; grades and attendance are kept summarized
+        Schema::forEach<StudentView>(studentText, [&](const StudentView& s) {
+            if (find(childrenIds.begin(), childrenIds.end(), s.id) != childrenIds.end()) {
+                children[s.id] = s;
+            }
+            }, arena.get());
+
+        RankingEngine& rankings = RankingEngine::instance();
         for (const string& childId : childrenIds) {
-            StudentRecord child = getChildRecord(childId);
-            if (child.id.empty()) {
+            auto found = children.find(childId);
+            if (found == children.end()) {
                 cout << "Could not find records for child ID: " << childId << endl;
                 continue;
             }
-
-            cout << "\nChild: " << child.name << " (" << childId << ")";
-            cout << "\nClass: " << child.className;
-            cout << "\n--------------------------------------------------\n";
-
-            map<string, map<string, int>> gradesBySubject = getChildGrades(childId);
-            pair<int, int> attendance = getChildAttendance(childId);
-            float attendancePercent = (attendance.first * 100.0f) / max(1, attendance.second);
-
-            if (!gradesBySubject.empty()) {
-                cout << "Academic Performance:\n";
-                cout << left << setw(15) << "Subject" << setw(10) << "Quiz" << setw(10) << "Midterm" << setw(10) << "Final" << setw(15) << "Average" << endl;
-                cout << "--------------------------------------------------\n";
-
-                for (const auto& subject : gradesBySubject) {
-                    float weightedAvg = 0.0f;
-                    if (subject.second.count("quiz")) 
-                        weightedAvg += subject.second.at("quiz") * 0.3f;
-                    if (subject.second.count("midterm")) 
-                        weightedAvg += subject.second.at("midterm") * 0.4f;
-                    if (subject.second.count("final")) 
-                        weightedAvg += subject.second.at("final") * 0.3f;
-
-                    cout << left << setw(15) << subject.first << setw(10) << (subject.second.count("quiz") ? to_string(subject.second.at("quiz")) : "-") << setw(10) << (subject.second.count("midterm") ? to_string(subject.second.at("midterm")) : "-") << setw(10) << (subject.second.count("final") ? to_string(subject.second.at("final")) : "-") << setw(15) << fixed << setprecision(1) << weightedAvg << endl;
+            const StudentView& child = found->second;
+
+            string out;
+            out += "\nChild: ";
+            out.append(child.name.data(), child.name.size());
+            out += " (" + childId + ")\nClass: ";
+            out.append(child.className.data(), child.className.size());
+            out += "\n--------------------------------------------------\n";
+
+            StudentSummary summary = SummaryStore::instance().get(childId);
+            pair<int, int> attendance = summary.attendance(DateRange::all());
+            float attendancePercent = summary.attendancePercent(DateRange::all());
+
+            if (!summary.subjects.empty()) {
+                ConsoleTable table;
+                table.column("Subject", 15).column("Quiz", 10).column("Midterm", 10).column("Final", 10).column("Average", 15).underlined(1);
+
+                for (const auto& subject : summary.subjects) {
+                    table.cell(subject.first);
+                    for (const char* type : { "quiz", "midterm", "final" }) {
+                        auto score = subject.second.find(type);
+                        if (score != subject.second.end())
+                            table.cell(score->second);
+                        else
+                            table.cell("-");
+                    }
+                    table.cell(StudentSummary::weighted(subject.second), 1);
                 }
+                out += "Academic Performance:\n";
+                table.render(out);
             }
             else {
-                cout << "No grade records available.\n";
+                out += "No grade records available.\n";
             }
 
-            cout << "\nAttendance: " << attendance.first << "/" << attendance.second  << " (" << attendancePercent << "%)\n";
+            out += "\nAttendance: " + to_string(attendance.first) + "/" + to_string(attendance.second) + " (";
+            ConsoleTable::appendFixed(out, attendancePercent, 1);
+            out += "%)\n";
 
-            cout << "\nOverall Progress: ";
-            if (attendancePercent < 75) {
-                cout << "Needs improvement (Low attendance)";
-            }
-            else if (!gradesBySubject.empty()) {
-                float overallAvg = calculateOverallAverage(gradesBySubject);
-                if (overallAvg >= 85) 
-                    cout << "Excellent";
-                else if (overallAvg >= 70)
-                    cout << "Good";
-                else 
-                    cout << "Needs improvement";
-            }
-            cout << "\n--------------------------------------------------\n";
+            string level(child.className.substr(0, child.className.find('-')));
+            out += "Class Rank: " + RankingEngine::describe(rankings.standing(childId, false));
+            out += " | Grade " + level + " Rank: " + RankingEngine::describe(rankings.standing(childId, true)) + "\n";
+
+            out += "\nOverall Progress: " + summary.progress();
+            out += "\n--------------------------------------------------\n";
+            cout << out;
         }
     }
 
     void viewFeeStatus() {
         cout << "\n=== View Fee Status ===" << endl;
-        ifstream file("fees_ledger.txt");
-        string line;
+        FeeLedger& ledger = FeeLedger::instance();
         bool found = false;
 
+        // Each child's own ledger lines only
         for (const auto& childId : childrenIds) {
-            cout << "\nFee status for child ID " << childId << ":\n";
-            while (getline(file, line)) {
-                if (line.empty() || line[0] == '[')
-                    continue;
+            vector<FeeEntry> entries = ledger.statement(childId);
+            if (entries.empty())
+                continue;
+            found = true;
 
-                vector<string> parts = Utils::parseRecord(line);
-                if (parts.size() >= 2 && parts[0] == childId) {
-                    cout << "Month: " << parts[1] << " | Amount: " << parts[2] << " | Status: " << parts[3] << endl;
-                    found = true;
-                }
+            ConsoleTable table;
+            table.column("Date", 12).column("Entry", 10).column("Month", 10).column("Amount", 12, ConsoleTable::Right).column("Balance", 12, ConsoleTable::Right).underlined();
+            for (const auto& entry : entries) {
+                table.cell(entry.date).cell(entry.kind).cell(entry.month).cell(entry.amount).cell(entry.balance);
             }
-            file.seekg(0);
+            string out = "\nFee status for child ID " + childId + ":\n";
+            table.render(out);
+            out += "Outstanding balance: " + Money::format(ledger.balance(childId)) + "\n";
+            cout << out;
         }
 
         if (!found) {
@@ -1904,45 +1807,72 @@ public:
         cout << "Enter additional note: ";
         getline(cin, note);
 
-        ofstream file("parent_requests.txt", ios::app);
-        file << childId << "|" << username << "|" << requestType << "|" << note << "|Pending\n";
+        ParentRequestQueue queue;
+        queue.load();
+        const ParentRequest& request = queue.submit(childId, username, requestType, note);
 
-        cout << "Request submitted successfully!" << endl;
+        cout << "Request #" << request.requestId << " submitted successfully!" << endl;
     }
 
     void viewChildAttendance() {
         cout << "\n=== View Child Attendance ===" << endl;
-        ifstream file("attendance.txt");
-        string line;
-        string date;
+        DateRange range = DateRange::prompt();
         bool found = false;
 
+        // One pass over the overlapping partitions for all children
+        map<string, vector<AttendanceEntry>> byChild;
         for (const auto& childId : childrenIds) {
-            cout << "\nAttendance records for child ID " << childId << ":\n";
-            while (getline(file, line)) {
-                if (line.find("[ATTENDANCE") != string::npos) {
-                    date = line.substr(11, 10);
-                    continue;
-                }
+            byChild[childId];
+        }
+        AttendanceStore::instance().scan(range, [&byChild](const AttendanceEntry& entry) {
+            auto it = byChild.find(entry.studentId);
+            if (it != byChild.end())
+                it->second.push_back(entry);
+            });
 
-                if (line.find(childId) != string::npos) {
-                    cout << "Date: " << date << " | Status: " << line.substr(line.find(":") + 2) << endl;
-                    found = true;
-                }
+        string out;
+        for (const auto& childId : childrenIds) {
+            ConsoleTable table;
+            table.column("Date", 12).column("Status", 10);
+            for (const auto& entry : byChild[childId]) {
+                table.cell(entry.date).cell(entry.present ? "Present" : "Absent");
+                found = true;
             }
-            file.seekg(0);
+            out += "\nAttendance records for child ID " + childId + ":\n";
+            if (!table.empty())
+                table.render(out);
         }
+        cout << out;
 
         if (!found) {
             cout << "No attendance records found for your children!" << endl;
         }
     }
 
+    void viewPastTerm() {
+        cout << "\n=== View Past Term ===" << endl;
+        string termName;
+        cout << "Enter term (e.g., Fall-2023): ";
+        getline(cin, termName);
+
+        TermArchive archive(termName);
+        bool found = false;
+        if (archive.load()) {
+            for (const auto& childId : childrenIds) {
+                if (archive.printStudent(childId))
+                    found = true;
+            }
+        }
+        if (!found) {
+            cout << "No archived records found for " << termName << "." << endl;
+        }
+    }
+
     void displayMenu() override {
         int choice;
         do {
             cout << "\n=== PARENT MENU ===" << endl;
-            cout << "1. View Child Progress\n2. View Fee Status\n" << "3. Submit Request\n4. View Child Attendance\n0. Logout\nEnter choice: ";
+            cout << "1. View Child Progress\n2. View Fee Status\n" << "3. Submit Request\n4. View Child Attendance\n5. View Past Term\n0. Logout\nEnter choice: ";
             cin >> choice;
             Utils::clearInputBuffer();
 
@@ -1951,6 +1881,7 @@ public:
             case 2: viewFeeStatus(); break;
             case 3: submitRequest(); break;
             case 4: viewChildAttendance(); break;
+            case 5: viewPastTerm(); break;
             case 0: cout << "Logging out...\n"; break;
             default: cout << "Invalid choice!" << endl;
             }
@@ -1965,28 +1896,22 @@ public:
 
     void handleRequests() {
         cout << "\n=== Handle Requests ===" << endl;
-        ifstream file("parent_requests.txt");
-        string line;
-        vector<string> pendingRequests;
-
-        while (getline(file, line)) {
-            if (line.empty())
-                continue;
-            vector<string> parts = Utils::parseRecord(line);
-            if (parts.size() >= 5 && parts[4] == "Pending") {
-                pendingRequests.push_back(line);
-            }
-        }
+        ParentRequestQueue queue;
+        queue.load();
 
-        if (pendingRequests.empty()) {
+        if (queue.empty()) {
             cout << "No pending requests." << endl;
             return;
         }
 
-        cout << "\nPending Requests:\n";
+        // Only the head of the queue is listed; older requests age towards the top
+        const size_t pageSize = 20;
+        vector<ParentRequest> pendingRequests = queue.peek(pageSize);
+
+        cout << "\nPending Requests (" << queue.pendingCount() << " total, highest priority first):\n";
         for (size_t i = 0; i < pendingRequests.size(); ++i) {
-            vector<string> parts = Utils::parseRecord(pendingRequests[i]);
-            cout << i + 1 << ". " << parts[2] << " for " << parts[0] << ": " << parts[3] << endl;
+            const ParentRequest& req = pendingRequests[i];
+            cout << i + 1 << ". #" << req.requestId << " " << req.type << " for " << req.childId << ": " << req.note << " (waiting " << queue.ageInDays(req) << " days)" << endl;
         }
 
         cout << "\nEnter request number to process (0 to cancel): ";
@@ -2001,44 +1926,19 @@ public:
             Utils::clearInputBuffer();
 
             string status = (action == 1) ? "Approved" : "Rejected";
-            vector<string> parts = Utils::parseRecord(pendingRequests[requestNum - 1]);
-            parts[4] = status;
-
-            ofstream outFile("parent_requests.txt", ios::app);
-            outFile << Utils::joinString(parts, "|") << "\n";
+            queue.updateStatus(pendingRequests[requestNum - 1].requestId, status);
             cout << "Request " << status << " successfully!" << endl;
         }
+
+        if (queue.needsCompaction()) {
+            queue.compact();
+        }
     }
 
     void manageSalaries() {
         cout << "\n=== Manage Salaries ===" << endl;
-        vector<TeacherRecord> teachers;
-        vector<StaffRecord> staff;
-        ifstream teacherFile("teachers.txt");
-        ifstream staffFile("staff.txt");
-        string line;
-
-        // Load teachers
-        while (getline(teacherFile, line)) {
-            if (line.empty() || line[0] == '[') 
-                continue;
-            vector<string> parts = Utils::parseRecord(line);
-            if (parts.size() >= 7) {
-                vector<string> subjects = Utils::splitString(parts[2], ',');
-                vector<string> classes = Utils::splitString(parts[5], ',');
-                teachers.emplace_back(parts[0], parts[1], subjects, parts[3], parts[4], classes, stoi(parts[6]));
-            }
-        }
-
-        // Load staff
-        while (getline(staffFile, line)) {
-            if (line.empty() || line[0] == '[') 
-                continue;
-            vector<string> parts = Utils::parseRecord(line);
-            if (parts.size() >= 6) {
-                staff.emplace_back(parts[0], parts[1], parts[2], parts[3], parts[4], stoi(parts[5]));
-            }
-        }
+        vector<TeacherRecord> teachers = Schema::loadFile<TeacherRecord>(Catalog::path("teachers.txt"));
+        vector<StaffRecord> staff = Schema::loadFile<StaffRecord>(Catalog::path("staff.txt"));
 
         int choice;
         do {
@@ -2048,18 +1948,23 @@ public:
 
             switch (choice) {
             case 1: {
-                cout << "\nTeacher Salaries:\n";
+                ConsoleTable table;
+                table.column("ID", 10).column("Name", 25).column("Salary", 12, ConsoleTable::Right);
                 for (const auto& teacher : teachers) {
-                    float salary = teacher.periodsPerWeek * 2000 * 4;
-                    cout << teacher.name << " (" << teacher.id << "): " << salary << endl;
+                    table.cell(teacher.id).cell(teacher.name).cell(Money::format(PayrollEngine::teacherBase(teacher.periodsPerWeek)));
                 }
+                cout << "\nTeacher Salaries:\n";
+                table.print();
                 break;
             }
             case 2: {
-                cout << "\nStaff Salaries:\n";
+                ConsoleTable table;
+                table.column("ID", 10).column("Name", 25).column("Salary", 12, ConsoleTable::Right);
                 for (const auto& member : staff) {
-                    cout << member.name << " (" << member.id << "): " << member.salary << endl;
+                    table.cell(member.id).cell(member.name).cell(member.salary);
                 }
+                cout << "\nStaff Salaries:\n";
+                table.print();
                 break;
             }
             case 3: {
@@ -2106,85 +2011,92 @@ public:
             }
         } while (choice != 0);
 
-        // Save changes
-        ofstream teacherOut("teachers.txt");
-        teacherOut << "[TEACHER RECORD]\n";
-        for (const auto& teacher : teachers) 
-        {
-            teacherOut << teacher.id << "|" << teacher.name << "|" << Utils::joinString(teacher.subjects, ",") << "|" << teacher.qualification << "|" << teacher.contact << "|" << Utils::joinString(teacher.assignedClasses, ",") << "|" << teacher.periodsPerWeek << "\n";
-        }
-
-        ofstream staffOut("staff.txt");
-        staffOut << "[STAFF RECORD]\n";
-        for (const auto& member : staff) 
-        {
-            staffOut << member.id << "|" << member.name << "|" << member.role << "|" << member.contact << "|" << member.salary << "|" << member.leavesTaken << "\n";
-        }
+        // Save changes with the same layouts the loaders use
+        Schema::saveFile(Catalog::path("teachers.txt"), "[TEACHER RECORD]", teachers);
+        Schema::saveFile(Catalog::path("staff.txt"), "[STAFF RECORD]", staff);
     }
 
     void viewSchoolReports()
     {
         cout << "\n=== View School Reports ===" << endl;
-        ifstream file("termReports.txt");
-        string line;
-        bool found = false;
+        ReportCatalog catalog;
+        catalog.refresh();
+        vector<ReportEntry> reports = catalog.list();
+
+        if (reports.empty()) 
+        {
+            cout << "No reports available!" << endl;
+            return;
+        }
 
         cout << "Available Term Reports:\n";
-        while (getline(file, line))
+        for (size_t i = 0; i < reports.size(); ++i)
         {
-            if (line.find("[TERM REPORTS") != string::npos) 
+            cout << i + 1 << ". TERM REPORTS " << reports[i].term << " CLASS " << reports[i].className << " (" << reports[i].students.size() << " students)" << endl;
+        }
+
+        cout << "\nEnter report number to view (0 for all reports): ";
+        int reportNum;
+        if (!(cin >> reportNum))
+            reportNum = -1;
+        Utils::clearInputBuffer();
+
+        if (reportNum == 0)
+        {
+            for (const auto& report : reports)
             {
-                cout << line.substr(1, line.length() - 2) << endl;
-                found = true;
+                cout << catalog.readReport(report);
             }
+            return;
         }
-
-        if (!found) 
+        if (reportNum < 0 || reportNum > static_cast<int>(reports.size()))
         {
-            cout << "No reports available!" << endl;
+            cout << "Invalid report number!" << endl;
             return;
         }
 
-        cout << "\nEnter report name to view (or 'all' for all reports): ";
-        string reportName;
-        getline(cin, reportName);
+        const ReportEntry& report = reports[reportNum - 1];
+        cout << "Enter student ID (leave empty for the whole class): ";
+        string studentId;
+        getline(cin, studentId);
 
-        file.clear();
-        file.seekg(0);
-        bool specificReport = (reportName != "all");
-        bool reportFound = false;
-
-        while (getline(file, line)) 
+        if (studentId.empty())
         {
-            if (line.empty()) 
-                continue;
+            cout << catalog.readReport(report);
+            return;
+        }
 
-            if (line[0] == '[')
-            {
-                if (specificReport && line.find(reportName) != string::npos) 
-                {
-                    reportFound = true;
-                }
-                continue;
-            }
+        string studentReport = catalog.readStudent(report, studentId);
+        if (studentReport.empty())
+        {
+            cout << "No report for " << studentId << " in this class." << endl;
+            return;
+        }
+        cout << studentReport;
+    }
 
-            if (!specificReport || reportFound) 
-            {
-                cout << line << endl;
-            }
+    void runQueries()
+    {
+        cout << "\n=== Analytics Queries ===" << endl;
+        QueryEngine engine;
+        engine.load();
+        engine.printTables();
 
-            if (reportFound && line.find("----------------------------------------") != string::npos) 
-            {
-                reportFound = false;
-                if (specificReport) break;
-            }
+        while (true)
+        {
+            cout << "\nQuery (empty line to return): ";
+            string query;
+            getline(cin, query);
+            if (query.empty())
+                break;
+            QueryEngine::printResult(engine.run(query));
         }
     }
 
     void approveLeaveRequests()
     {
         cout << "\n=== Approve Leave Requests ===" << endl;
-        ifstream file("leave_requests.txt");
+        ifstream file(Catalog::path("leave_requests.txt"));
         string line;
         vector<string> pendingRequests;
 
@@ -2228,18 +2140,40 @@ public:
             vector<string> parts = Utils::parseRecord(pendingRequests[requestNum - 1]);
             parts[5] = status;
 
-            ofstream outFile("leave_requests.txt", ios::app);
-            outFile << Utils::joinString(parts, "|") << "\n";
+            Storage::appendText(Catalog::path("leave_requests.txt"), Utils::joinString(parts, "|") + "\n");
             cout << "Request " << status << " successfully!" << endl;
         }
     }
 
+    void viewRankings()
+    {
+        cout << "\n=== Class Rankings ===" << endl;
+        string name;
+        cout << "Enter a class (e.g., 10-A) or a grade level (e.g., 10): ";
+        getline(cin, name);
+
+        string input;
+        size_t count = 10;
+        cout << "Students to list at each end [10]: ";
+        getline(cin, input);
+        if (!input.empty() && all_of(input.begin(), input.end(), ::isdigit) && stoul(input) > 0)
+            count = stoul(input);
+
+        RankingEngine& rankings = RankingEngine::instance();
+        if (rankings.hasClass(name))
+            rankings.printBoard(name, false, count);
+        else if (rankings.hasLevel(name))
+            rankings.printBoard(name, true, count);
+        else
+            cout << "No class or grade level named " << name << "." << endl;
+    }
+
     void displayMenu() override
     {
         int choice;
         do {
             cout << "\n=== PRINCIPAL MENU ===" << endl;
-            cout << "1. Handle Requests\n2. Manage Salaries\n3. View School Reports\n" << "4. Approve Leave Requests\n0. Logout\nEnter choice: ";
+            cout << "1. Handle Requests\n2. Manage Salaries\n3. View School Reports\n" << "4. Approve Leave Requests\n5. Analytics Queries\n6. Class Rankings\n0. Logout\nEnter choice: ";
             cin >> choice;
             Utils::clearInputBuffer();
 
@@ -2257,6 +2191,12 @@ public:
             case 4: 
                 approveLeaveRequests();
                 break;
+            case 5:
+                runQueries();
+                break;
+            case 6:
+                viewRankings();
+                break;
             case 0: 
                 cout << "Logging out...\n";
                 break;
@@ -0,0 +1,61 @@
+#ifndef MONEY_H
+#define MONEY_H
+
+#include <string>
+#include <string_view>
+#include <cctype>
+#include <cstdint>
+
+#include "schema.h"
+
+using namespace std;
+
+// Amounts in paisa (1/100 rupee), so sums and deductions are exact
+typedef int64_t Paisa;
+
+namespace Money
+{
+    // "25000", "25000.5" or "25000.50"; false for anything else
+    bool parse(string_view text, Paisa& out)
+    {
+        text = Schema::trim(text);
+        size_t dot = text.find('.');
+        string_view whole = text.substr(0, dot);
+        string_view fraction = dot == string_view::npos ? string_view() : text.substr(dot + 1);
+        if (whole.empty() || whole.size() > 15 || fraction.size() > 2)
+            return false;
+        if (dot != string_view::npos && fraction.empty())
+            return false;
+
+        Paisa value = 0;
+        for (char c : whole)
+        {
+            if (!isdigit(static_cast<unsigned char>(c)))
+                return false;
+            value = value * 10 + (c - '0');
+        }
+        Paisa cents = 0;
+        for (size_t i = 0; i < 2; ++i)
+        {
+            char c = i < fraction.size() ? fraction[i] : '0';
+            if (!isdigit(static_cast<unsigned char>(c)))
+                return false;
+            cents = cents * 10 + (c - '0');
+        }
+        out = value * 100 + cents;
+        return true;
+    }
+
+    // 1920000 -> "19200.00"
+    string format(Paisa amount)
+    {
+        string out = amount < 0 ? "-" : "";
+        Paisa magnitude = amount < 0 ? -amount : amount;
+        out += to_string(magnitude / 100) + ".";
+        out += static_cast<char>('0' + magnitude % 100 / 10);
+        out += static_cast<char>('0' + magnitude % 10);
+        return out;
+    }
+}
+
+#endif
@@ -0,0 +1,498 @@
+#ifndef NAME_SEARCH_H
+#define NAME_SEARCH_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include <set>
+#include <queue>
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+
+#include "utils.h"
+#include "storage.h"
+#include "schema.h"
+#include "catalog.h"
+
+using namespace std;
+
+enum class NameKind { Student, Teacher, Staff };
+
+struct NameMatch
+{
+    NameKind kind;
+    string id;
+    string name;
+    float score; // 1 for prefix matches, trigram similarity otherwise
+};
+
+// Name lookup over the student, teacher and staff rosters. Every word-start
+// suffix of a normalized name ("ali raza khan", "raza khan", "khan") goes into
+// a compressed trie, so a prefix of any word finds the name by walking the
+// query once and then visiting only the first k entries below it. Typos are
+// handled through the vocabulary: rosters reuse the same few thousand words,
+// so a trigram index over distinct words finds the close spellings of each
+// query word cheaply, and names are then gathered from those words' posting
+// lists, best combination first, until k are found.
+// Records are added and removed one at a time as the rosters are edited.
+class NameIndex
+{
+private:
+    struct Entry
+    {
+        NameKind kind;
+        string id;
+        string name;
+        string normalized;
+        vector<uint32_t> words;
+        bool alive = true;
+    };
+
+    struct Word
+    {
+        string text;
+        uint32_t trigrams; // distinct
+        vector<uint32_t> entries; // sorted
+    };
+
+    struct Node
+    {
+        string label;
+        vector<uint32_t> children; // sorted by first label character
+        vector<uint32_t> entries;  // names whose suffix ends here
+    };
+
+    vector<Entry> entries;
+    unordered_map<string, uint32_t> byKey; // kind + id -> live entry
+    vector<Node> nodes = vector<Node>(1);
+    vector<Word> words;
+    unordered_map<string, uint32_t> wordIds;
+    unordered_map<uint32_t, vector<uint32_t>> wordsByTrigram;
+    size_t live = 0;
+
+    static string keyOf(NameKind kind, const string& id)
+    {
+        return string(1, static_cast<char>('0' + static_cast<int>(kind))) + id;
+    }
+
+    static vector<uint32_t> trigramsOf(const string& normalized)
+    {
+        string padded = "  " + normalized + " ";
+        vector<uint32_t> grams;
+        for (size_t i = 0; i + 3 <= padded.size(); ++i)
+        {
+            grams.push_back((uint32_t(uint8_t(padded[i])) << 16) | (uint32_t(uint8_t(padded[i + 1])) << 8) | uint32_t(uint8_t(padded[i + 2])));
+        }
+        sort(grams.begin(), grams.end());
+        grams.erase(unique(grams.begin(), grams.end()), grams.end());
+        return grams;
+    }
+
+    static size_t commonPrefix(const string& a, size_t aStart, const string& b)
+    {
+        size_t n = 0;
+        while (aStart + n < a.size() && n < b.size() && a[aStart + n] == b[n])
+            ++n;
+        return n;
+    }
+
+    // Child of node whose label starts with c, or 0
+    uint32_t childStarting(uint32_t node, char c) const
+    {
+        const vector<uint32_t>& children = nodes[node].children;
+        auto it = lower_bound(children.begin(), children.end(), c, [this](uint32_t child, char value)
+            {
+            return nodes[child].label[0] < value;
+            });
+        return it != children.end() && nodes[*it].label[0] == c ? *it : 0;
+    }
+
+    void addChild(uint32_t node, uint32_t child)
+    {
+        vector<uint32_t>& children = nodes[node].children;
+        char c = nodes[child].label[0];
+        auto it = lower_bound(children.begin(), children.end(), c, [this](uint32_t other, char value)
+            {
+            return nodes[other].label[0] < value;
+            });
+        children.insert(it, child);
+    }
+
+    void insertKey(const string& key, uint32_t entry)
+    {
+        uint32_t node = 0;
+        size_t pos = 0;
+        while (pos < key.size())
+        {
+            uint32_t child = childStarting(node, key[pos]);
+            if (!child)
+            {
+                nodes.push_back(Node{ key.substr(pos), {}, {} });
+                addChild(node, static_cast<uint32_t>(nodes.size() - 1));
+                node = static_cast<uint32_t>(nodes.size() - 1);
+                pos = key.size();
+                break;
+            }
+
+            size_t shared = commonPrefix(key, pos, nodes[child].label);
+            if (shared < nodes[child].label.size())
+            {
+                // Split child at the point where key leaves its label
+                Node middle{ nodes[child].label.substr(0, shared), {}, {} };
+                nodes[child].label.erase(0, shared);
+                nodes.push_back(middle);
+                uint32_t split = static_cast<uint32_t>(nodes.size() - 1);
+                nodes[split].children.push_back(child);
+                vector<uint32_t>& siblings = nodes[node].children;
+                *find(siblings.begin(), siblings.end(), child) = split;
+                child = split;
+            }
+            node = child;
+            pos += shared;
+        }
+        nodes[node].entries.push_back(entry);
+    }
+
+    // Removed names leave their trie nodes behind; only the entry goes
+    void eraseKey(const string& key, uint32_t entry)
+    {
+        uint32_t node = 0;
+        size_t pos = 0;
+        while (pos < key.size())
+        {
+            uint32_t child = childStarting(node, key[pos]);
+            if (!child || key.compare(pos, nodes[child].label.size(), nodes[child].label) != 0)
+                return;
+            pos += nodes[child].label.size();
+            node = child;
+        }
+        vector<uint32_t>& list = nodes[node].entries;
+        list.erase(std::remove(list.begin(), list.end(), entry), list.end());
+    }
+
+    template <class Visit>
+    void forEachSuffix(const string& normalized, Visit visit) const
+    {
+        for (size_t i = 0; i < normalized.size(); ++i)
+        {
+            if (i == 0 || normalized[i - 1] == ' ')
+                visit(normalized.substr(i));
+        }
+    }
+
+    // Entries below node in key order until k distinct ones are found
+    void collect(uint32_t node, size_t k, vector<uint32_t>& found, unordered_set<uint32_t>& seen) const
+    {
+        for (uint32_t entry : nodes[node].entries)
+        {
+            if (found.size() >= k)
+                return;
+            if (seen.insert(entry).second)
+                found.push_back(entry);
+        }
+        for (uint32_t child : nodes[node].children)
+        {
+            if (found.size() >= k)
+                return;
+            collect(child, k, found, seen);
+        }
+    }
+
+    uint32_t wordId(const string& text)
+    {
+        auto it = wordIds.find(text);
+        if (it != wordIds.end())
+            return it->second;
+        uint32_t id = static_cast<uint32_t>(words.size());
+        vector<uint32_t> grams = trigramsOf(text);
+        words.push_back(Word{ text, static_cast<uint32_t>(grams.size()), {} });
+        wordIds[text] = id;
+        for (uint32_t gram : grams)
+            wordsByTrigram[gram].push_back(id);
+        return id;
+    }
+
+    // Words in use spelled closest to token, best first, at most limit
+    vector<pair<float, uint32_t>> closeWords(const string& token, float minimum, size_t limit) const
+    {
+        vector<uint32_t> grams = trigramsOf(token);
+        unordered_map<uint32_t, uint32_t> shared;
+        for (uint32_t gram : grams)
+        {
+            auto it = wordsByTrigram.find(gram);
+            if (it == wordsByTrigram.end())
+                continue;
+            for (uint32_t word : it->second)
+                ++shared[word];
+        }
+
+        vector<pair<float, uint32_t>> close;
+        for (const auto& item : shared)
+        {
+            float score = 2.0f * item.second / (grams.size() + words[item.first].trigrams);
+            if (score >= minimum && !words[item.first].entries.empty())
+                close.push_back(make_pair(score, item.first));
+        }
+        size_t count = min(limit, close.size());
+        partial_sort(close.begin(), close.begin() + count, close.end(), [](const pair<float, uint32_t>& a, const pair<float, uint32_t>& b)
+            {
+            return a.first != b.first ? a.first > b.first : a.second < b.second;
+            });
+        close.resize(count);
+        return close;
+    }
+
+    NameMatch matchOf(uint32_t entry, float score) const
+    {
+        const Entry& e = entries[entry];
+        return NameMatch{ e.kind, e.id, e.name, score };
+    }
+
+public:
+    // Lower case, with runs of anything but letters and digits as one space
+    static string normalize(const string& name)
+    {
+        string out;
+        for (char c : name)
+        {
+            if (isalnum(static_cast<unsigned char>(c)))
+                out += static_cast<char>(tolower(static_cast<unsigned char>(c)));
+            else if (!out.empty() && out.back() != ' ')
+                out += ' ';
+        }
+        if (!out.empty() && out.back() == ' ')
+            out.pop_back();
+        return out;
+    }
+
+    // Add a record, replacing any earlier name it had
+    void add(NameKind kind, const string& id, const string& name)
+    {
+        remove(kind, id);
+        string normalized = normalize(name);
+        if (normalized.empty())
+            return;
+
+        uint32_t index = static_cast<uint32_t>(entries.size());
+        vector<uint32_t> ids;
+        for (const auto& text : Utils::splitString(normalized, ' '))
+        {
+            uint32_t word = wordId(text);
+            if (find(ids.begin(), ids.end(), word) == ids.end())
+                ids.push_back(word);
+        }
+        entries.push_back(Entry{ kind, id, name, normalized, ids, true });
+        byKey[keyOf(kind, id)] = index;
+        ++live;
+
+        forEachSuffix(normalized, [&](const string& suffix)
+            {
+            insertKey(suffix, index);
+            });
+        // New entries have the highest index, so postings stay sorted
+        for (uint32_t word : ids)
+            words[word].entries.push_back(index);
+    }
+
+    void remove(NameKind kind, const string& id)
+    {
+        auto it = byKey.find(keyOf(kind, id));
+        if (it == byKey.end())
+            return;
+        uint32_t index = it->second;
+        byKey.erase(it);
+        Entry& entry = entries[index];
+        entry.alive = false;
+        --live;
+
+        forEachSuffix(entry.normalized, [&](const string& suffix)
+            {
+            eraseKey(suffix, index);
+            });
+        for (uint32_t word : entry.words)
+        {
+            vector<uint32_t>& list = words[word].entries;
+            auto found = lower_bound(list.begin(), list.end(), index);
+            if (found != list.end() && *found == index)
+                list.erase(found);
+        }
+        entry.words.clear();
+        entry.name.clear();
+        entry.normalized.clear();
+    }
+
+    size_t size() const
+    {
+        return live;
+    }
+
+    // Up to k names with a word starting with query, alphabetically by that word
+    vector<NameMatch> prefix(const string& query, size_t k) const
+    {
+        vector<NameMatch> matches;
+        string key = normalize(query);
+        if (key.empty() || k == 0)
+            return matches;
+
+        uint32_t node = 0;
+        size_t pos = 0;
+        while (pos < key.size())
+        {
+            uint32_t child = childStarting(node, key[pos]);
+            if (!child)
+                return matches;
+            size_t shared = commonPrefix(key, pos, nodes[child].label);
+            if (shared < nodes[child].label.size() && pos + shared < key.size())
+                return matches;
+            pos += shared;
+            node = child;
+        }
+
+        vector<uint32_t> found;
+        unordered_set<uint32_t> seen;
+        collect(node, k, found, seen);
+        for (uint32_t entry : found)
+            matches.push_back(matchOf(entry, 1.0f));
+        return matches;
+    }
+
+    // Up to k names whose words are close spellings of the query words. A
+    // name scores the mean, over query words, of the trigram similarity (Dice
+    // coefficient) of its closest word; names below minimum are left out.
+    vector<NameMatch> similar(const string& query, size_t k, float minimum = 0.4f) const
+    {
+        const size_t maxTokens = 4;
+        const size_t wordsPerToken = 16;
+        const uint32_t noWord = UINT32_MAX;
+
+        vector<NameMatch> matches;
+        vector<string> tokens = Utils::splitString(normalize(query), ' ');
+        if (tokens.empty() || k == 0)
+            return matches;
+        if (tokens.size() > maxTokens)
+            tokens.resize(maxTokens);
+
+        // Per query word, its close spellings and then "no word", best first
+        vector<vector<pair<float, uint32_t>>> options;
+        for (const auto& token : tokens)
+        {
+            options.push_back(closeWords(token, minimum, wordsPerToken));
+            options.back().push_back(make_pair(0.0f, noWord));
+        }
+
+        auto scoreOf = [&](const vector<uint8_t>& pick)
+            {
+            float total = 0.0f;
+            for (size_t i = 0; i < pick.size(); ++i)
+                total += options[i][pick[i]].first;
+            return total / pick.size();
+            };
+
+        // Word combinations from the highest score down. A name is first met
+        // under the combination of its own closest words, which is its score.
+        priority_queue<pair<float, vector<uint8_t>>> queue;
+        set<vector<uint8_t>> queued;
+        vector<uint8_t> start(tokens.size(), 0);
+        queue.push(make_pair(scoreOf(start), start));
+        queued.insert(start);
+        unordered_set<uint32_t> seen;
+
+        while (!queue.empty() && matches.size() < k)
+        {
+            float score = queue.top().first;
+            vector<uint8_t> pick = queue.top().second;
+            queue.pop();
+            if (score < minimum)
+                break;
+
+            for (size_t i = 0; i < pick.size(); ++i)
+            {
+                if (pick[i] + 1u < options[i].size())
+                {
+                    vector<uint8_t> next = pick;
+                    ++next[i];
+                    if (queued.insert(next).second)
+                        queue.push(make_pair(scoreOf(next), next));
+                }
+            }
+
+            vector<const vector<uint32_t>*> lists;
+            for (size_t i = 0; i < pick.size(); ++i)
+            {
+                if (options[i][pick[i]].second != noWord)
+                    lists.push_back(&words[options[i][pick[i]].second].entries);
+            }
+            if (lists.empty())
+                continue;
+            sort(lists.begin(), lists.end(), [](const vector<uint32_t>* a, const vector<uint32_t>* b)
+                {
+                return a->size() < b->size();
+                });
+
+            // Names holding every picked word
+            for (uint32_t entry : *lists[0])
+            {
+                bool all = true;
+                for (size_t j = 1; j < lists.size() && all; ++j)
+                    all = binary_search(lists[j]->begin(), lists[j]->end(), entry);
+                if (all && seen.insert(entry).second)
+                {
+                    matches.push_back(matchOf(entry, score));
+                    if (matches.size() >= k)
+                        break;
+                }
+            }
+        }
+        return matches;
+    }
+
+    // Prefix matches first, then close spellings to make up k
+    vector<NameMatch> search(const string& query, size_t k) const
+    {
+        vector<NameMatch> matches = prefix(query, k);
+        if (matches.size() >= k)
+            return matches;
+        for (auto& match : similar(query, k))
+        {
+            bool listed = any_of(matches.begin(), matches.end(), [&match](const NameMatch& m)
+                {
+                return m.kind == match.kind && m.id == match.id;
+                });
+            if (!listed && matches.size() < k)
+                matches.push_back(match);
+        }
+        return matches;
+    }
+
+    // Index everyone in the three roster files
+    void load()
+    {
+        Schema::forEach<StudentRecord>(Storage::readAll(Catalog::path("students.txt")), [this](const StudentRecord& s)
+            {
+            add(NameKind::Student, s.id, s.name);
+            });
+        Schema::forEach<TeacherRecord>(Storage::readAll(Catalog::path("teachers.txt")), [this](const TeacherRecord& t)
+            {
+            add(NameKind::Teacher, t.id, t.name);
+            });
+        Schema::forEach<StaffRecord>(Storage::readAll(Catalog::path("staff.txt")), [this](const StaffRecord& s)
+            {
+            add(NameKind::Staff, s.id, s.name);
+            });
+    }
+
+    static const char* kindName(NameKind kind)
+    {
+        switch (kind)
+        {
+        case NameKind::Student: return "Student";
+        case NameKind::Teacher: return "Teacher";
+        default: return "Staff";
+        }
+    }
+};
+
+#endif
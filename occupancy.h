@@ -0,0 +1,292 @@
+#ifndef OCCUPANCY_H
+#define OCCUPANCY_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+
+#include "utils.h"
+#include "storage.h"
+#include "catalog.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+using namespace std;
+
+// One bit per (day, period) of the week, day-major: slot = day * periods + period
+typedef uint64_t SlotMask;
+
+enum class SlotOwner { Teacher, Class, Room };
+
+// Booked slots of every teacher, class and room as one mask each, so "is X
+// free at slot S" is a bit test and the slots free to several owners at once
+// are an AND of their masks. Owners are numbered in the order they are first
+// seen; the timetable generator numbers them itself and sizes the grid up front.
+class OccupancyGrid
+{
+private:
+    int dayCount;
+    int periodCount;
+    SlotMask all;
+    vector<SlotMask> busy[3];
+    vector<string> names[3];
+    unordered_map<string, uint32_t> index[3];
+
+    static int kind(SlotOwner owner)
+    {
+        return static_cast<int>(owner);
+    }
+
+public:
+    // days * periods must not exceed 64
+    OccupancyGrid(int days = 5, int periods = 8) : dayCount(days), periodCount(periods)
+    {
+        int slots = days * periods;
+        all = slots >= 64 ? ~SlotMask(0) : (SlotMask(1) << slots) - 1;
+    }
+
+    static int count(SlotMask mask)
+    {
+#ifdef _MSC_VER
+        return static_cast<int>(__popcnt64(mask));
+#else
+        return __builtin_popcountll(mask);
+#endif
+    }
+
+    static int lowest(SlotMask mask)
+    {
+#ifdef _MSC_VER
+        unsigned long bit;
+        _BitScanForward64(&bit, mask);
+        return static_cast<int>(bit);
+#else
+        return __builtin_ctzll(mask);
+#endif
+    }
+
+    int days() const { return dayCount; }
+    int periods() const { return periodCount; }
+    SlotMask week() const { return all; }
+
+    SlotMask day(int d) const
+    {
+        SlotMask first = periodCount >= 64 ? ~SlotMask(0) : (SlotMask(1) << periodCount) - 1;
+        return first << (d * periodCount);
+    }
+
+    int slot(int d, int period) const
+    {
+        return d * periodCount + period;
+    }
+
+    // Owners numbered 0..n-1 without names, all free
+    void reset(SlotOwner owner, size_t n)
+    {
+        busy[kind(owner)].assign(n, 0);
+        names[kind(owner)].clear();
+        index[kind(owner)].clear();
+    }
+
+    uint32_t add(SlotOwner owner, const string& name)
+    {
+        int k = kind(owner);
+        auto inserted = index[k].insert(make_pair(name, static_cast<uint32_t>(busy[k].size())));
+        if (inserted.second)
+        {
+            busy[k].push_back(0);
+            names[k].resize(busy[k].size());
+            names[k].back() = name;
+        }
+        return inserted.first->second;
+    }
+
+    // -1 if the grid has not seen the owner
+    int find(SlotOwner owner, const string& name) const
+    {
+        auto found = index[kind(owner)].find(name);
+        return found == index[kind(owner)].end() ? -1 : static_cast<int>(found->second);
+    }
+
+    const string& name(SlotOwner owner, uint32_t i) const
+    {
+        return names[kind(owner)][i];
+    }
+
+    size_t size(SlotOwner owner) const
+    {
+        return busy[kind(owner)].size();
+    }
+
+    SlotMask booked(SlotOwner owner, uint32_t i) const
+    {
+        return busy[kind(owner)][i];
+    }
+
+    SlotMask open(SlotOwner owner, uint32_t i) const
+    {
+        return all & ~busy[kind(owner)][i];
+    }
+
+    bool isFree(SlotOwner owner, uint32_t i, int s) const
+    {
+        return !(busy[kind(owner)][i] >> s & 1);
+    }
+
+    bool isFree(SlotOwner owner, const string& name, int s) const
+    {
+        int i = find(owner, name);
+        return i < 0 || isFree(owner, static_cast<uint32_t>(i), s);
+    }
+
+    void book(SlotOwner owner, uint32_t i, int s)
+    {
+        busy[kind(owner)][i] |= SlotMask(1) << s;
+    }
+
+    void release(SlotOwner owner, uint32_t i, int s)
+    {
+        busy[kind(owner)][i] &= ~(SlotMask(1) << s);
+    }
+};
+
+struct TimetableEntry
+{
+    string day;
+    string period;
+    string teacherId;
+    string className;
+    string room;
+    int slot = -1;          // -1 if day or period could not be read
+    bool clash = false;
+};
+
+// Two entries booking the same teacher, class or room at one slot
+struct Clash
+{
+    SlotOwner owner;
+    string name;
+    int slot;
+    size_t first;           // entry indexes
+    size_t second;
+};
+
+// timetable.txt loaded into an OccupancyGrid, with every double booking
+// found while booking the entries in file order. Days are weekday names
+// (Monday or Mon) and periods numbers from 1.
+class TimetableCheck
+{
+private:
+    vector<TimetableEntry> rows;
+    vector<Clash> found;
+    size_t unreadable = 0;
+    OccupancyGrid occupancy;
+
+    static int dayNumber(const string& day)
+    {
+        static const char* names[] = { "mon", "tue", "wed", "thu", "fri", "sat", "sun" };
+        string prefix = Utils::toLower(day.substr(0, 3));
+        for (int d = 0; d < 7; ++d)
+        {
+            if (prefix == names[d])
+                return d;
+        }
+        return -1;
+    }
+
+    static int periodNumber(const string& period)
+    {
+        if (period.empty() || period.size() > 2 || !all_of(period.begin(), period.end(), ::isdigit))
+            return -1;
+        return stoi(period) - 1;
+    }
+
+public:
+    static const char* ownerName(SlotOwner owner)
+    {
+        switch (owner)
+        {
+        case SlotOwner::Teacher: return "Teacher";
+        case SlotOwner::Class: return "Class";
+        default: return "Room";
+        }
+    }
+
+    void load(const string& text)
+    {
+        rows.clear();
+        found.clear();
+        unreadable = 0;
+
+        int days = 5;
+        int periods = 1;
+        vector<pair<int, int>> slots;
+        for (const auto& line : Utils::splitString(text, '\n'))
+        {
+            if (line.empty() || line[0] == '[')
+                continue;
+            vector<string> parts = Utils::parseRecord(line);
+            if (parts.size() < 5)
+                continue;
+            rows.push_back(TimetableEntry{ parts[0], parts[1], parts[2], parts[3], parts[4] });
+            slots.push_back(make_pair(dayNumber(parts[0]), periodNumber(parts[1])));
+            days = max(days, slots.back().first + 1);
+            periods = max(periods, slots.back().second + 1);
+        }
+        periods = min(periods, 64 / days);
+        occupancy = OccupancyGrid(days, periods);
+
+        // Owner of each booked (owner, slot), to name both sides of a clash
+        unordered_map<uint64_t, size_t> owners[3];
+        auto claim = [&](SlotOwner owner, const string& name, size_t row)
+            {
+            int s = rows[row].slot;
+            uint32_t i = occupancy.add(owner, name);
+            auto& claimed = owners[static_cast<int>(owner)];
+            if (occupancy.isFree(owner, i, s))
+            {
+                occupancy.book(owner, i, s);
+                claimed[static_cast<uint64_t>(i) << 6 | s] = row;
+                return;
+            }
+            size_t first = claimed[static_cast<uint64_t>(i) << 6 | s];
+            // A class in its own room clashes once, not again as a room
+            if (owner == SlotOwner::Room && rows[first].className == rows[row].className)
+                return;
+            found.push_back(Clash{ owner, name, s, first, row });
+            rows[first].clash = true;
+            rows[row].clash = true;
+            };
+
+        for (size_t row = 0; row < rows.size(); ++row)
+        {
+            if (slots[row].first < 0 || slots[row].second < 0 || slots[row].second >= periods)
+            {
+                unreadable++;
+                continue;
+            }
+            rows[row].slot = occupancy.slot(slots[row].first, slots[row].second);
+            claim(SlotOwner::Teacher, rows[row].teacherId, row);
+            claim(SlotOwner::Class, rows[row].className, row);
+            if (!rows[row].room.empty())
+                claim(SlotOwner::Room, rows[row].room, row);
+        }
+    }
+
+    void load()
+    {
+        load(Storage::readAll(Catalog::path("timetable.txt")));
+    }
+
+    const vector<TimetableEntry>& entries() const { return rows; }
+    const vector<Clash>& clashes() const { return found; }
+    size_t unreadableEntries() const { return unreadable; }
+    const OccupancyGrid& grid() const { return occupancy; }
+};
+
+#endif
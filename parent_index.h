@@ -0,0 +1,153 @@
+#ifndef PARENT_INDEX_H
+#define PARENT_INDEX_H
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <cstdio>
+
+#include "utils.h"
+#include "storage.h"
+#include "catalog.h"
+#include "schema.h"
+
+using namespace std;
+
+// Children of each parent contact, stored in parents.idx:
+//   [PARENT INDEX] <students.txt size> <students.txt mtime>
+//   contact|childId|childId...
+// Lines are sorted by contact, so a lookup is a binary search over byte
+// offsets that reads a handful of lines. The index is rewritten whenever the
+// roster is saved; if students.txt was changed some other way its size or
+// mtime no longer match the header and the index is rebuilt first.
+class ParentIndex
+{
+private:
+    string studentsPath;
+    string indexName;
+    string indexPath;
+
+    static string header(const string& studentsPath)
+    {
+        long long size = -1;
+        long long modified = 0;
+        Storage::fileStamp(studentsPath, size, modified);
+        return "[PARENT INDEX] " + to_string(size) + " " + to_string(modified);
+    }
+
+    static string contactOf(const string& line)
+    {
+        return line.substr(0, line.find('|'));
+    }
+
+    bool current()
+    {
+        if (!Catalog::verify(indexName))
+            return false;
+        ifstream file(indexPath, ios::binary);
+        string line;
+        if (!getline(file, line))
+            return false;
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+        return line == header(studentsPath);
+    }
+
+    // Line starting at or after offset, and where the one after it begins
+    static bool lineAt(ifstream& file, long long offset, string& line, long long& start)
+    {
+        file.clear();
+        file.seekg(offset - 1);
+        string skipped;
+        if (!getline(file, skipped))
+            return false;
+        start = offset + static_cast<long long>(skipped.size());
+        if (!getline(file, line))
+            return false;
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+        return true;
+    }
+
+public:
+    explicit ParentIndex(const string& students = "students.txt") : studentsPath(Catalog::path(students)), indexName("parents.idx"), indexPath(Catalog::path(indexName)) {}
+
+    // Rewrite the index for the roster just saved to students.txt
+    void rebuild(const vector<StudentRecord>& students)
+    {
+        map<string, vector<string>> children;
+        for (const auto& student : students)
+        {
+            if (!student.parentContact.empty())
+                children[student.parentContact].push_back(student.id);
+        }
+
+        string content = header(studentsPath) + "\n";
+        for (const auto& item : children)
+        {
+            content += item.first;
+            for (const auto& id : item.second)
+                content += "|" + id;
+            content += "\n";
+        }
+        if (Storage::writeAtomic(indexPath, content))
+            Catalog::record(indexName, content);
+    }
+
+    void rebuild()
+    {
+        rebuild(Schema::loadFile<StudentRecord>(studentsPath));
+    }
+
+    // Child IDs registered under a parent contact, in roster order
+    vector<string> childrenOf(const string& contact)
+    {
+        vector<string> children;
+        if (contact.empty())
+            return children;
+        if (!current())
+            rebuild();
+
+        ifstream file(indexPath, ios::binary);
+        string line;
+        if (!getline(file, line))
+            return children;
+        long long low = static_cast<long long>(file.tellg());
+        long long high = Storage::fileSize(indexPath);
+
+        // low starts a line sorting before contact (or the first line); high
+        // starts one sorting at or after it (or is the end of the file)
+        while (high - low > 256)
+        {
+            long long start = 0;
+            if (!lineAt(file, (low + high) / 2, line, start) || start >= high)
+                break;
+            if (contactOf(line) < contact)
+                low = start;
+            else
+                high = start;
+        }
+
+        file.clear();
+        file.seekg(low);
+        while (getline(file, line))
+        {
+            if (!line.empty() && line.back() == '\r')
+                line.pop_back();
+            string key = contactOf(line);
+            if (key > contact)
+                break;
+            if (key == contact)
+            {
+                vector<string> parts = Utils::parseRecord(line);
+                children.assign(parts.begin() + 1, parts.end());
+                break;
+            }
+        }
+        return children;
+    }
+};
+
+#endif
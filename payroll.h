@@ -0,0 +1,177 @@
+#ifndef PAYROLL_H
+#define PAYROLL_H
+
+#include <string>
+#include <vector>
+#include <unordered_set>
+#include <algorithm>
+#include <cstdint>
+
+#include "utils.h"
+#include "storage.h"
+#include "catalog.h"
+#include "schema.h"
+#include "records.h"
+#include "table.h"
+#include "money.h"
+
+using namespace std;
+
+// One payroll run, one array per column so the pay calculation is a
+// straight pass over plain integers
+struct PayrollBatch
+{
+    vector<string> ids;
+    vector<string> names;
+    vector<Paisa> base;
+    vector<Paisa> perLeave;         // fixed deduction per excess leave
+    vector<int32_t> percentPerLeave;// deduction per excess leave as a percentage of base
+    vector<int32_t> excessLeaves;
+    vector<Paisa> deduction;
+    vector<Paisa> net;
+    vector<string> alreadyPaid;     // names skipped because they were paid this month
+    vector<string> invalid;         // names skipped because their salary could not be read
+
+    size_t size() const
+    {
+        return ids.size();
+    }
+
+    Paisa total() const
+    {
+        Paisa sum = 0;
+        for (Paisa amount : net)
+            sum += amount;
+        return sum;
+    }
+};
+
+// Monthly salaries for teachers (paid per period taught) and staff (fixed
+// salary). Two leaves a month are allowed; each one beyond that costs a
+// teacher Rs. 500 and a staff member 1% of their salary.
+class PayrollEngine
+{
+private:
+    static const Paisa perPeriod = 2000 * 100;
+    static const int weeksPerMonth = 4;
+    static const int allowedLeaves = 2;
+    static const Paisa teacherLeaveDeduction = 500 * 100;
+    static const int staffLeavePercent = 1;
+
+    static void add(PayrollBatch& batch, const string& id, const string& name, Paisa base, Paisa perLeave, int percentPerLeave, int leavesTaken)
+    {
+        batch.ids.push_back(id);
+        batch.names.push_back(name);
+        batch.base.push_back(base);
+        batch.perLeave.push_back(perLeave);
+        batch.percentPerLeave.push_back(percentPerLeave);
+        batch.excessLeaves.push_back(max(0, leavesTaken - allowedLeaves));
+    }
+
+    // Deductions and net pay for the whole batch; percentages round half up to the paisa
+    static void compute(PayrollBatch& batch)
+    {
+        size_t n = batch.size();
+        batch.deduction.resize(n);
+        batch.net.resize(n);
+        const Paisa* base = batch.base.data();
+        const Paisa* perLeave = batch.perLeave.data();
+        const int32_t* percent = batch.percentPerLeave.data();
+        const int32_t* excess = batch.excessLeaves.data();
+        Paisa* deduction = batch.deduction.data();
+        Paisa* net = batch.net.data();
+        for (size_t i = 0; i < n; ++i)
+        {
+            Paisa d = perLeave[i] * excess[i] + (base[i] * percent[i] * excess[i] + 50) / 100;
+            Paisa pay = base[i] - d;
+            deduction[i] = d;
+            net[i] = pay > 0 ? pay : 0;
+        }
+    }
+
+public:
+    static Paisa teacherBase(int periodsPerWeek)
+    {
+        return static_cast<Paisa>(max(0, periodsPerWeek)) * perPeriod * weeksPerMonth;
+    }
+
+    // IDs already paid in a month ("YYYY-MM"), from one read of salary_payments.txt
+    static unordered_set<string> paidIn(const string& monthYear)
+    {
+        unordered_set<string> paid;
+        Schema::forEach<PaymentLine>(Storage::readAll(Catalog::path("salary_payments.txt")), [&](const PaymentLine& p)
+            {
+            if (p.date.compare(0, 7, monthYear) == 0)
+                paid.insert(p.id);
+            });
+        return paid;
+    }
+
+    static PayrollBatch teachers(const vector<TeacherRecord>& records, const unordered_set<string>& paid)
+    {
+        PayrollBatch batch;
+        for (const auto& t : records)
+        {
+            if (paid.count(t.id))
+                batch.alreadyPaid.push_back(t.name);
+            else
+                add(batch, t.id, t.name, teacherBase(t.periodsPerWeek), teacherLeaveDeduction, 0, t.leavesTaken);
+        }
+        compute(batch);
+        return batch;
+    }
+
+    static PayrollBatch staff(const vector<StaffRecord>& records, const unordered_set<string>& paid)
+    {
+        PayrollBatch batch;
+        for (const auto& s : records)
+        {
+            Paisa salary = 0;
+            if (paid.count(s.id))
+                batch.alreadyPaid.push_back(s.name);
+            else if (!Money::parse(s.salary, salary))
+                batch.invalid.push_back(s.name);
+            else
+                add(batch, s.id, s.name, salary, 0, staffLeavePercent, s.leavesTaken);
+        }
+        compute(batch);
+        return batch;
+    }
+
+    // The whole batch as one committed section of salary_payments.txt
+    static bool commit(const PayrollBatch& batch, const string& title, const string& date)
+    {
+        if (batch.size() == 0)
+            return true;
+        string section = "\n[" + title + " " + date + "]\n";
+        for (size_t i = 0; i < batch.size(); ++i)
+        {
+            Schema::appendLine(section, PaymentLine{ batch.ids[i], batch.names[i], Money::format(batch.net[i]), date });
+        }
+        return Storage::commitSection(Catalog::path("salary_payments.txt"), section, date);
+    }
+
+    static void printBatch(const PayrollBatch& batch)
+    {
+        string out;
+        for (const auto& name : batch.alreadyPaid)
+            out += "Salary already processed for " + name + "\n";
+        for (const auto& name : batch.invalid)
+            out += "Salary not readable for " + name + ", skipped\n";
+
+        if (batch.size() > 0)
+        {
+            ConsoleTable table;
+            table.column("ID", 10).column("Name", 22).column("Base", 14, ConsoleTable::Right).column("Deduction", 12, ConsoleTable::Right).column("Net", 14, ConsoleTable::Right).underlined();
+            for (size_t i = 0; i < batch.size(); ++i)
+            {
+                table.cell(batch.ids[i]).cell(batch.names[i]).cell(Money::format(batch.base[i])).cell(Money::format(batch.deduction[i])).cell(Money::format(batch.net[i]));
+            }
+            table.render(out);
+        }
+        out += to_string(batch.size()) + " payment(s), total " + Money::format(batch.total()) + "\n";
+        cout << out;
+    }
+};
+
+#endif
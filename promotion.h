@@ -0,0 +1,181 @@
+#ifndef PROMOTION_H
+#define PROMOTION_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <iomanip>
+#include <limits>
+#include <cctype>
+
+#include "utils.h"
+#include "records.h"
+#include "table.h"
+
+using namespace std;
+
+struct PromotionPlan
+{
+    vector<StudentRecord> students;
+    map<string, size_t> before;     // class -> head count before
+    map<string, size_t> after;      // class -> head count after
+    size_t promoted = 0;
+    size_t sectionChanges = 0;      // students placed in a different section letter
+    size_t rollChanges = 0;
+    size_t unchanged = 0;           // classes without a numeric grade are left alone
+};
+
+// Yearly allocation in one pass over the roster: every student moves up a
+// grade (12th grade stays), each grade is then split into as few sections
+// as the capacity allows with sizes differing by at most one, and roll
+// numbers are reassigned 1..n per section in a deterministic order.
+class PromotionEngine
+{
+private:
+    static const int maxGrade = 12;
+
+    struct Placement
+    {
+        size_t index;       // into the roster
+        string oldSection;
+        long rollNo;
+    };
+
+    // "10-A" -> (10, "A"); grade 0 if the class has no numeric prefix
+    static int parseClass(const string& className, string& section)
+    {
+        size_t dash = className.find('-');
+        string grade = className.substr(0, dash);
+        section = dash == string::npos ? "" : className.substr(dash + 1);
+        if (grade.empty() || grade.size() > 2 || !all_of(grade.begin(), grade.end(), ::isdigit))
+            return 0;
+        return stoi(grade);
+    }
+
+    // 0 -> A, 25 -> Z, 26 -> AA, ...
+    static string sectionName(size_t n)
+    {
+        string name;
+        n++;
+        while (n > 0)
+        {
+            n--;
+            name.insert(name.begin(), static_cast<char>('A' + n % 26));
+            n /= 26;
+        }
+        return name;
+    }
+
+    static long rollNumber(const string& rollNo)
+    {
+        try {
+            return stol(rollNo);
+        }
+        catch (...) {
+            return numeric_limits<long>::max();
+        }
+    }
+
+public:
+    static PromotionPlan plan(const vector<StudentRecord>& roster, size_t capacity)
+    {
+        PromotionPlan plan;
+        plan.students = roster;
+        capacity = max<size_t>(1, capacity);
+
+        // Bucket by new grade (counting sort on a small key range)
+        vector<vector<Placement>> grades(maxGrade + 1);
+        for (size_t i = 0; i < roster.size(); ++i)
+        {
+            plan.before[roster[i].className]++;
+
+            string section;
+            int grade = parseClass(roster[i].className, section);
+            if (grade <= 0 || grade > maxGrade)
+            {
+                plan.unchanged++;
+                plan.after[roster[i].className]++;
+                continue;
+            }
+            if (grade < maxGrade)
+            {
+                grade++;
+                plan.promoted++;
+            }
+            grades[grade].push_back(Placement{ i, section, rollNumber(roster[i].rollNo) });
+        }
+
+        for (int grade = 1; grade <= maxGrade; ++grade)
+        {
+            vector<Placement>& cohort = grades[grade];
+            if (cohort.empty())
+                continue;
+
+            // Keep former classmates together and in their old roll order
+            sort(cohort.begin(), cohort.end(), [&roster](const Placement& a, const Placement& b)
+                {
+                if (a.oldSection != b.oldSection)
+                    return a.oldSection < b.oldSection;
+                if (a.rollNo != b.rollNo)
+                    return a.rollNo < b.rollNo;
+                return roster[a.index].id < roster[b.index].id;
+                });
+
+            size_t sections = (cohort.size() + capacity - 1) / capacity;
+            size_t baseSize = cohort.size() / sections;
+            size_t larger = cohort.size() % sections;
+            size_t next = 0;
+
+            for (size_t s = 0; s < sections; ++s)
+            {
+                string section = sectionName(s);
+                string className = to_string(grade) + "-" + section;
+                size_t size = baseSize + (s < larger ? 1 : 0);
+
+                for (size_t roll = 1; roll <= size; ++roll, ++next)
+                {
+                    const Placement& p = cohort[next];
+                    StudentRecord& student = plan.students[p.index];
+                    if (p.oldSection != section)
+                        plan.sectionChanges++;
+                    if (student.rollNo != to_string(roll))
+                        plan.rollChanges++;
+
+                    student.className = className;
+                    student.rollNo = to_string(roll);
+                }
+                plan.after[className] += size;
+            }
+        }
+        return plan;
+    }
+
+    static void printSummary(const PromotionPlan& plan)
+    {
+        map<string, pair<size_t, size_t>> sizes;
+        for (const auto& c : plan.before)
+            sizes[c.first].first = c.second;
+        for (const auto& c : plan.after)
+            sizes[c.first].second = c.second;
+
+        ConsoleTable table;
+        table.column("Class", 10).column("Before", 8, ConsoleTable::Right).column("After", 8, ConsoleTable::Right).underlined();
+        for (const auto& c : sizes)
+        {
+            table.cell(c.first).cell(c.second.first).cell(c.second.second);
+        }
+
+        string out = "\nClass sizes:\n";
+        table.render(out);
+        out += "Students promoted: " + to_string(plan.promoted) + "\n";
+        out += "Section changes: " + to_string(plan.sectionChanges) + "\n";
+        out += "Roll number changes: " + to_string(plan.rollChanges) + "\n";
+        if (plan.unchanged > 0)
+            out += "Left unchanged (no numeric grade): " + to_string(plan.unchanged) + "\n";
+        cout << out;
+    }
+};
+
+#endif
@@ -0,0 +1,408 @@
+#ifndef RANKING_H
+#define RANKING_H
+
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <unordered_set>
+#include <algorithm>
+#include <mutex>
+#include <cstdint>
+
+#include "storage.h"
+#include "schema.h"
+#include "catalog.h"
+#include "table.h"
+#include "summary.h"
+
+using namespace std;
+
+// Where a student stands in a class or grade level; rank 0 if ungraded
+struct Standing
+{
+    size_t rank = 0;
+    size_t of = 0;
+    float percentile = 0.0f; // share of ranked peers scoring lower, ties counted half
+    float score = 0.0f;
+};
+
+struct RankEntry
+{
+    string id;
+    string name;
+    string className;
+    float score;
+    size_t rank;
+};
+
+// Weighted scores (quiz 30%, midterm 40%, final 30%, averaged over subjects)
+// for every student on the roster, grouped by class and by grade level ("10"
+// for "10-A"). Each group keeps its scores in one dense array: a student's
+// rank is a count over that array, top and bottom lists a partial sort, and
+// medians an nth_element. grades.txt is followed like a log: only sections
+// appended since the last refresh are parsed, and only the groups of the
+// students they touch are rebuilt. A rewritten file (compaction, term
+// closing) is detected by fingerprint and read again from the start.
+class RankingEngine
+{
+private:
+    struct Scores
+    {
+        int quiz = -1;
+        int midterm = -1;
+        int final = -1;
+    };
+
+    struct Member
+    {
+        string id;
+        string name;
+        string className;
+        string level;
+        float score = 0.0f;
+        bool graded = false;
+    };
+
+    struct Group
+    {
+        vector<uint32_t> members; // roster order
+        vector<uint32_t> ranked;  // graded members ...
+        vector<float> scores;     // ... and their scores, side by side
+        bool dirty = true;
+    };
+
+    mutex lock;
+    const string studentsPath = Catalog::path("students.txt");
+    const string gradesPath = Catalog::path("grades.txt");
+    long long studentsSize = -1;
+    long long studentsModified = 0;
+    long long gradesBytes = 0;
+    uint32_t gradesFingerprint = 0;
+
+    unordered_map<string, map<string, Scores>> grades; // student -> subject -> scores
+    vector<Member> members;
+    unordered_map<string, uint32_t> byId;
+    map<string, Group> classes;
+    map<string, Group> levels;
+
+    static string levelOf(const string& className)
+    {
+        return className.substr(0, className.find('-'));
+    }
+
+    uint32_t fingerprintAt(long long end) const
+    {
+        long long start = max(0LL, end - 64);
+        string tail = Storage::readRange(gradesPath, start, end - start);
+        return Storage::crc32(tail.data(), tail.size());
+    }
+
+    void score(Member& member)
+    {
+        auto found = grades.find(member.id);
+        member.graded = found != grades.end() && !found->second.empty();
+        member.score = 0.0f;
+        if (!member.graded)
+            return;
+        for (const auto& subject : found->second)
+        {
+            const Scores& s = subject.second;
+            float weighted = 0.0f;
+            if (s.quiz >= 0)
+                weighted += s.quiz * 0.3f;
+            if (s.midterm >= 0)
+                weighted += s.midterm * 0.4f;
+            if (s.final >= 0)
+                weighted += s.final * 0.3f;
+            member.score += weighted;
+        }
+        member.score /= found->second.size();
+    }
+
+    void loadRoster()
+    {
+        members.clear();
+        byId.clear();
+        classes.clear();
+        levels.clear();
+        Schema::forEach<StudentRecord>(Storage::readAll(studentsPath), [this](const StudentRecord& s)
+            {
+            if (byId.count(s.id))
+                return;
+            uint32_t index = static_cast<uint32_t>(members.size());
+            members.push_back(Member{ s.id, s.name, s.className, levelOf(s.className) });
+            byId[s.id] = index;
+            score(members.back());
+            classes[s.className].members.push_back(index);
+            levels[members.back().level].members.push_back(index);
+            });
+    }
+
+    // Parse grade sections; returns the students whose scores changed
+    unordered_set<string> readGrades(string_view text)
+    {
+        unordered_set<string> touched;
+        SummaryStore::forEachGrade(text, [this, &touched](string_view studentId, string_view subject, string_view type, int score)
+            {
+            string id(studentId);
+            Scores& scores = grades[id][string(subject)];
+            if (type == "quiz")
+                scores.quiz = score;
+            else if (type == "midterm")
+                scores.midterm = score;
+            else if (type == "final")
+                scores.final = score;
+            touched.insert(id);
+            });
+        return touched;
+    }
+
+    // Caller holds the lock
+    void refreshLocked()
+    {
+        bool reloadRoster = false;
+        long long size = -1;
+        long long modified = 0;
+        Storage::fileStamp(studentsPath, size, modified);
+        if (size != studentsSize || modified != studentsModified)
+        {
+            studentsSize = size;
+            studentsModified = modified;
+            reloadRoster = true;
+        }
+
+        long long gradesSize = Storage::fileSize(gradesPath);
+        unordered_set<string> touched;
+        bool rewritten = gradesSize < gradesBytes || (gradesBytes > 0 && fingerprintAt(gradesBytes) != gradesFingerprint);
+        if (rewritten)
+        {
+            grades.clear();
+            gradesBytes = 0;
+            reloadRoster = true;
+        }
+        if (gradesSize > gradesBytes)
+        {
+            // Appends are whole sections; stop at the last complete line
+            string text = Storage::readRange(gradesPath, gradesBytes, gradesSize - gradesBytes);
+            size_t complete = text.rfind('\n');
+            if (complete != string::npos)
+            {
+                text.resize(complete + 1);
+                touched = readGrades(text);
+                gradesBytes += static_cast<long long>(text.size());
+                gradesFingerprint = fingerprintAt(gradesBytes);
+            }
+        }
+
+        if (reloadRoster)
+        {
+            loadRoster();
+            return;
+        }
+        for (const auto& id : touched)
+        {
+            auto found = byId.find(id);
+            if (found == byId.end())
+                continue;
+            Member& member = members[found->second];
+            score(member);
+            classes[member.className].dirty = true;
+            levels[member.level].dirty = true;
+        }
+    }
+
+    Group* group(const string& name, bool byLevel)
+    {
+        map<string, Group>& groups = byLevel ? levels : classes;
+        auto found = groups.find(name);
+        if (found == groups.end())
+            return nullptr;
+
+        Group& g = found->second;
+        if (g.dirty)
+        {
+            g.ranked.clear();
+            g.scores.clear();
+            for (uint32_t index : g.members)
+            {
+                if (!members[index].graded)
+                    continue;
+                g.ranked.push_back(index);
+                g.scores.push_back(members[index].score);
+            }
+            g.dirty = false;
+        }
+        return &g;
+    }
+
+    // Best or worst n of a group, ranked by score with ties sharing a rank
+    vector<RankEntry> extremes(const string& name, bool byLevel, size_t n, bool best)
+    {
+        lock_guard<mutex> guard(lock);
+        refreshLocked();
+        vector<RankEntry> entries;
+        Group* g = group(name, byLevel);
+        if (!g)
+            return entries;
+
+        vector<pair<float, uint32_t>> order;
+        order.reserve(g->scores.size());
+        for (size_t i = 0; i < g->scores.size(); ++i)
+            order.push_back(make_pair(g->scores[i], g->ranked[i]));
+        auto higher = [this](const pair<float, uint32_t>& a, const pair<float, uint32_t>& b)
+            {
+            if (a.first != b.first)
+                return a.first > b.first;
+            return members[a.second].id < members[b.second].id;
+            };
+        auto lower = [&higher](const pair<float, uint32_t>& a, const pair<float, uint32_t>& b)
+            {
+            return higher(b, a);
+            };
+
+        size_t count = min(n, order.size());
+        if (best)
+            partial_sort(order.begin(), order.begin() + count, order.end(), higher);
+        else
+            partial_sort(order.begin(), order.begin() + count, order.end(), lower);
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            const Member& m = members[order[i].second];
+            size_t above = count_if(g->scores.begin(), g->scores.end(), [&m](float s)
+                {
+                return s > m.score;
+                });
+            entries.push_back(RankEntry{ m.id, m.name, m.className, m.score, above + 1 });
+        }
+        return entries;
+    }
+
+public:
+    static RankingEngine& instance()
+    {
+        static RankingEngine engine;
+        return engine;
+    }
+
+    // Pick up roster and grade changes; also done by every query
+    void refresh()
+    {
+        lock_guard<mutex> guard(lock);
+        refreshLocked();
+    }
+
+    Standing standing(const string& studentId, bool byLevel)
+    {
+        lock_guard<mutex> guard(lock);
+        refreshLocked();
+        Standing result;
+        auto found = byId.find(studentId);
+        if (found == byId.end() || !members[found->second].graded)
+            return result;
+
+        const Member& m = members[found->second];
+        Group* g = group(byLevel ? m.level : m.className, byLevel);
+        size_t above = 0;
+        size_t below = 0;
+        for (float s : g->scores)
+        {
+            above += s > m.score;
+            below += s < m.score;
+        }
+        size_t tied = g->scores.size() - above - below;
+        result.rank = above + 1;
+        result.of = g->scores.size();
+        result.percentile = result.of > 1 ? 100.0f * (below + 0.5f * (tied - 1)) / (result.of - 1) : 100.0f;
+        result.score = m.score;
+        return result;
+    }
+
+    vector<RankEntry> top(const string& name, bool byLevel, size_t n)
+    {
+        return extremes(name, byLevel, n, true);
+    }
+
+    vector<RankEntry> bottom(const string& name, bool byLevel, size_t n)
+    {
+        return extremes(name, byLevel, n, false);
+    }
+
+    // Score at the given percentile (0-100) of a group; false if none are graded
+    bool scoreAt(const string& name, bool byLevel, float percentile, float& score)
+    {
+        lock_guard<mutex> guard(lock);
+        refreshLocked();
+        Group* g = group(name, byLevel);
+        if (!g || g->scores.empty())
+            return false;
+        vector<float> scores = g->scores;
+        size_t k = static_cast<size_t>(percentile / 100.0f * (scores.size() - 1) + 0.5f);
+        nth_element(scores.begin(), scores.begin() + k, scores.end());
+        score = scores[k];
+        return true;
+    }
+
+    bool hasClass(const string& name)
+    {
+        lock_guard<mutex> guard(lock);
+        refreshLocked();
+        return classes.count(name) > 0;
+    }
+
+    bool hasLevel(const string& name)
+    {
+        lock_guard<mutex> guard(lock);
+        refreshLocked();
+        return levels.count(name) > 0;
+    }
+
+    // "3/40 (P85)", or "-" when the student has no grades yet
+    static string describe(const Standing& s)
+    {
+        if (s.rank == 0)
+            return "-";
+        string out = to_string(s.rank) + "/" + to_string(s.of) + " (P";
+        out += to_string(static_cast<int>(s.percentile + 0.5f)) + ")";
+        return out;
+    }
+
+    // Top and bottom n of a class or grade level, with its median and 90th percentile
+    void printBoard(const string& name, bool byLevel, size_t n)
+    {
+        vector<RankEntry> best = top(name, byLevel, n);
+        if (best.empty())
+        {
+            cout << "No graded students in " << (byLevel ? "grade " : "class ") << name << "." << endl;
+            return;
+        }
+
+        float median = 0.0f;
+        float p90 = 0.0f;
+        scoreAt(name, byLevel, 50.0f, median);
+        scoreAt(name, byLevel, 90.0f, p90);
+        string out = "\n" + string(byLevel ? "Grade " : "Class ") + name + " | Median: ";
+        ConsoleTable::appendFixed(out, median, 1);
+        out += " | 90th percentile: ";
+        ConsoleTable::appendFixed(out, p90, 1);
+        out += "\n";
+
+        auto board = [&](const char* title, const vector<RankEntry>& entries)
+            {
+            out += string("\n") + title + "\n";
+            ConsoleTable table;
+            table.column("Rank", 6).column("ID", 10).column("Name", 20).column("Class", 8).column("Score", 8, ConsoleTable::Right).rules(52);
+            for (const auto& e : entries)
+                table.cell(e.rank).cell(e.id).cell(e.name).cell(e.className).cell(e.score, 1);
+            table.render(out);
+            };
+        board("Top students", best);
+        board("Bottom students", bottom(name, byLevel, n));
+        cout << out;
+    }
+};
+
+#endif
@@ -0,0 +1,75 @@
+#ifndef RECORDS_H
+#define RECORDS_H
+
+#include <string>
+#include <vector>
+
+#include "utils.h"
+
+using namespace std;
+
+// Record Structures
+struct StaffRecord 
+{
+    string id;
+    string name;
+    string role;
+    string contact;
+    string salary;
+    int leavesTaken;
+
+    StaffRecord() : leavesTaken(0) {}
+
+    StaffRecord(const string& id, const string& name, const string& role, const string& contact, const string& salary, int leaves) : id(id), name(name), role(role), contact(contact), salary(salary), leavesTaken(leaves) {}
+
+    string toString() const 
+    {
+        return "ID: " + id + " | Name: " + name + " | Role: " + role + " | Contact: " + contact + " | Salary: " + salary + " | Leaves Taken: " + to_string(leavesTaken);
+    }
+};
+
+class StudentRecord 
+{
+public:
+    string id;
+    string name;
+    string className;
+    string rollNo;
+    string parentContact;
+    string feeStatus;
+
+    StudentRecord() {}
+
+    StudentRecord(const string& id, const string& name, const string& className, const string& rollNo, const string& parentContact, const string& feeStatus) : id(id), name(name), className(className), rollNo(rollNo), parentContact(parentContact), feeStatus(feeStatus) {}
+
+    string toString() const
+    {
+        return "ID: " + id + " | Name: " + name + " | Class: " + className + " | Roll No: " + rollNo + " | Parent Contact: " + parentContact + " | Fee Status: " + feeStatus;
+    }
+};
+
+class TeacherRecord 
+{
+public:
+    string id;
+    string name;
+    vector<string> subjects;
+    string qualification;
+    string contact;
+	int leavesTaken = 0; // Default to 0 leaves taken
+    vector<string> assignedClasses;
+    int periodsPerWeek;
+
+    TeacherRecord() : periodsPerWeek(0) {}
+
+    TeacherRecord(const string& id, const string& name, const vector<string>& subjects, const string& qualification, const string& contact, const vector<string>& assignedClasses, int periodsPerWeek) : id(id), name(name), subjects(subjects), qualification(qualification), contact(contact), assignedClasses(assignedClasses), periodsPerWeek(periodsPerWeek) {}
+
+    string toString() const 
+    {
+        string subjs = Utils::joinString(subjects, ", ");
+        string classes = Utils::joinString(assignedClasses, ", ");
+        return "ID: " + id + " | Name: " + name + " | Subjects: " + subjs + " | Qualification: " + qualification + " | Contact: " + contact + " | Classes: " + classes + " | Periods/Week: " + to_string(periodsPerWeek);
+    }
+};
+
+#endif
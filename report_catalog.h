@@ -0,0 +1,298 @@
+#ifndef REPORT_CATALOG_H
+#define REPORT_CATALOG_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <map>
+#include <sstream>
+#include <cstdio>
+#include <cstdint>
+
+#include "utils.h"
+#include "storage.h"
+#include "catalog.h"
+
+using namespace std;
+
+struct ReportLocation
+{
+    long long offset = 0;
+    long long length = 0;
+};
+
+// Byte range of the latest [TERM REPORTS <term> CLASS <class>] section,
+// plus the range of each STUDENT block inside it
+struct ReportEntry
+{
+    string term;
+    string className;
+    ReportLocation section;
+    map<string, ReportLocation> students;
+};
+
+// Catalog over termReports.txt, stored in termReports.idx:
+//   [REPORT CATALOG] <indexed bytes> <crc32 of the 64 bytes before that>
+//   R|term|class|offset|length
+//   S|studentId|offset|length        (belongs to the preceding R line)
+// Only bytes past the indexed size are scanned on refresh. If the data file
+// was rewritten (e.g. by compaction) the fingerprint no longer matches and
+// the catalog is rebuilt from the start.
+class ReportCatalog
+{
+private:
+    string dataPath;
+    string indexName;
+    string indexPath;
+    long long indexedBytes = 0;
+    uint32_t fingerprint = 0;
+    map<pair<string, string>, ReportEntry> entries;
+
+    uint32_t fingerprintAt(long long end) const
+    {
+        long long start = max(0LL, end - 64);
+        string tail = Storage::readRange(dataPath, start, end - start);
+        return Storage::crc32(tail.data(), tail.size());
+    }
+
+    static bool parseHeader(const string& header, string& term, string& className)
+    {
+        // [TERM REPORTS <term> CLASS <class>]
+        if (header.compare(0, 14, "[TERM REPORTS ") != 0)
+            return false;
+        size_t classPos = header.find(" CLASS ", 14);
+        if (classPos == string::npos)
+            return false;
+        term = header.substr(14, classPos - 14);
+        className = header.substr(classPos + 7);
+        if (!className.empty() && className.back() == ']')
+            className.pop_back();
+        return true;
+    }
+
+    // Index one report section occupying text[start, end), at file offset base + start
+    void indexSection(const string& text, size_t start, size_t end, long long base)
+    {
+        size_t lineEnd = text.find('\n', start);
+        string header = text.substr(start, min(lineEnd, end) - start);
+        if (!header.empty() && header.back() == '\r')
+            header.pop_back();
+
+        ReportEntry entry;
+        if (!parseHeader(header, entry.term, entry.className))
+            return;
+        entry.section = ReportLocation{ base + static_cast<long long>(start), static_cast<long long>(end - start) };
+
+        string currentStudent;
+        size_t studentStart = 0;
+        size_t pos = lineEnd == string::npos ? end : lineEnd + 1;
+        while (pos < end)
+        {
+            size_t next = text.find('\n', pos);
+            next = next == string::npos || next >= end ? end : next + 1;
+
+            if (text.compare(pos, 9, "STUDENT: ") == 0)
+            {
+                size_t open = text.rfind('(', next - 1);
+                size_t close = text.find(')', open == string::npos ? pos : open);
+                if (open != string::npos && open > pos && close != string::npos && close < next)
+                {
+                    currentStudent = text.substr(open + 1, close - open - 1);
+                    studentStart = pos;
+                }
+            }
+            else if (!currentStudent.empty() && text.compare(pos, 10, "----------") == 0)
+            {
+                entry.students[currentStudent] = ReportLocation{ base + static_cast<long long>(studentStart), static_cast<long long>(next - studentStart) };
+                currentStudent.clear();
+            }
+            pos = next;
+        }
+
+        entries[make_pair(entry.term, entry.className)] = entry;
+    }
+
+    // Scan text read from file offset base; returns how many bytes were fully indexed
+    size_t scan(const string& text, long long base)
+    {
+        size_t pos = 0;
+        size_t sectionStart = string::npos;
+        size_t indexedEnd = 0;
+
+        auto closeSection = [&](size_t end)
+            {
+            if (sectionStart != string::npos)
+                indexSection(text, sectionStart, end, base);
+            sectionStart = string::npos;
+            };
+
+        while (pos < text.size())
+        {
+            size_t lineEnd = text.find('\n', pos);
+            if (lineEnd == string::npos)
+                break; // incomplete line, picked up on the next refresh
+            size_t next = lineEnd + 1;
+
+            if (text.compare(pos, 7, "[FRAME ") == 0)
+            {
+                closeSection(pos);
+                indexedEnd = pos;
+                size_t length = 0;
+                unsigned int crc = 0;
+                string line = text.substr(pos, lineEnd - pos);
+                bool parsed = sscanf(line.c_str(), "[FRAME %zu %x", &length, &crc) == 2;
+
+                if (parsed && next + length <= text.size() && Storage::crc32(text.data() + next, length) == crc)
+                {
+                    indexSection(text, next, next + length, base);
+                    pos = next + length;
+                    indexedEnd = pos;
+                    continue;
+                }
+
+                size_t resume = text.find("\n[FRAME ", next);
+                if (resume == string::npos)
+                {
+                    // Possibly still being written; if it is torn, later frames skip past it
+                    if (parsed && next + length > text.size())
+                        return indexedEnd;
+                    pos = text.size();
+                    indexedEnd = pos;
+                    break;
+                }
+                pos = resume + 1;
+                indexedEnd = pos;
+                continue;
+            }
+
+            if (text[pos] == '[')
+            {
+                closeSection(pos);
+                if (text.compare(pos, 14, "[TERM REPORTS ") == 0)
+                    sectionStart = pos;
+            }
+            pos = next;
+            if (sectionStart == string::npos)
+                indexedEnd = pos;
+        }
+
+        closeSection(pos);
+        return max(indexedEnd, pos);
+    }
+
+    bool loadIndex()
+    {
+        ifstream file(indexPath);
+        string line;
+        if (!getline(file, line))
+            return false;
+
+        unsigned int crc = 0;
+        long long bytes = 0;
+        if (sscanf(line.c_str(), "[REPORT CATALOG] %lld %x", &bytes, &crc) != 2)
+            return false;
+
+        ReportEntry* current = nullptr;
+        while (getline(file, line))
+        {
+            vector<string> parts = Utils::parseRecord(line);
+            if (parts.size() == 5 && parts[0] == "R")
+            {
+                ReportEntry& entry = entries[make_pair(parts[1], parts[2])];
+                entry.term = parts[1];
+                entry.className = parts[2];
+                entry.section = ReportLocation{ stoll(parts[3]), stoll(parts[4]) };
+                current = &entry;
+            }
+            else if (parts.size() == 4 && parts[0] == "S" && current)
+            {
+                current->students[parts[1]] = ReportLocation{ stoll(parts[2]), stoll(parts[3]) };
+            }
+        }
+
+        indexedBytes = bytes;
+        fingerprint = crc;
+        return true;
+    }
+
+    void saveIndex() const
+    {
+        ostringstream out;
+        char header[64];
+        snprintf(header, sizeof(header), "[REPORT CATALOG] %lld %08x\n", indexedBytes, fingerprint);
+        out << header;
+        for (const auto& item : entries)
+        {
+            const ReportEntry& e = item.second;
+            out << "R|" << e.term << "|" << e.className << "|" << e.section.offset << "|" << e.section.length << "\n";
+            for (const auto& student : e.students)
+            {
+                out << "S|" << student.first << "|" << student.second.offset << "|" << student.second.length << "\n";
+            }
+        }
+        string content = out.str();
+        if (Storage::writeAtomic(indexPath, content))
+            Catalog::record(indexName, content);
+    }
+
+public:
+    explicit ReportCatalog(const string& data = "termReports.txt") : dataPath(Catalog::path(data)), indexName(data.substr(0, data.rfind('.')) + ".idx"), indexPath(Catalog::path(indexName)) {}
+
+    // Bring the catalog up to date with the data file
+    void refresh()
+    {
+        long long size = Storage::fileSize(dataPath);
+        if (size < 0)
+        {
+            entries.clear();
+            return;
+        }
+
+        // An index that no longer matches its catalog checksum is rebuilt
+        bool valid = Catalog::verify(indexName) && loadIndex() && indexedBytes <= size && fingerprintAt(indexedBytes) == fingerprint;
+        if (!valid)
+        {
+            entries.clear();
+            indexedBytes = 0;
+        }
+        if (valid && indexedBytes == size)
+            return;
+
+        string tail = Storage::readRange(dataPath, indexedBytes, size - indexedBytes);
+        indexedBytes += static_cast<long long>(scan(tail, indexedBytes));
+        fingerprint = fingerprintAt(indexedBytes);
+        saveIndex();
+    }
+
+    vector<ReportEntry> list() const
+    {
+        vector<ReportEntry> result;
+        for (const auto& item : entries)
+        {
+            result.push_back(item.second);
+        }
+        return result;
+    }
+
+    string read(const ReportLocation& location) const
+    {
+        return Storage::readRange(dataPath, location.offset, location.length);
+    }
+
+    // Report text for one class, without the section header
+    string readReport(const ReportEntry& entry) const
+    {
+        string text = read(entry.section);
+        size_t body = text.find('\n');
+        return body == string::npos ? string() : text.substr(body + 1);
+    }
+
+    // Report text for one student, empty if the student is not in the report
+    string readStudent(const ReportEntry& entry, const string& studentId) const
+    {
+        auto it = entry.students.find(studentId);
+        return it == entry.students.end() ? string() : read(it->second);
+    }
+};
+
+#endif
@@ -0,0 +1,336 @@
+#ifndef REQUEST_QUEUE_H
+#define REQUEST_QUEUE_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <unordered_map>
+#include <algorithm>
+#include <functional>
+#include <queue>
+
+#include "utils.h"
+#include "storage.h"
+#include "catalog.h"
+#include "schema.h"
+
+using namespace std;
+
+// One parent request as stored in parent_requests.txt
+// childId|parentContact|type|note|status|requestId|submitted
+struct ParentRequest
+{
+    long requestId = 0;
+    string childId;
+    string parentContact;
+    string type;
+    string note;
+    string status;
+    string submitted;
+
+    string toLine() const
+    {
+        return Schema::toLine(*this);
+    }
+};
+
+// The request id and submit date were added later; older lines have 5 fields
+template <>
+struct Schema::Layout<ParentRequest>
+{
+    static constexpr auto fields = make_tuple(
+        Schema::field(&ParentRequest::childId, "childId"),
+        Schema::field(&ParentRequest::parentContact, "parentContact"),
+        Schema::field(&ParentRequest::type, "type"),
+        Schema::field(&ParentRequest::note, "note"),
+        Schema::field(&ParentRequest::status, "status"),
+        Schema::field(&ParentRequest::requestId, "requestId"),
+        Schema::field(&ParentRequest::submitted, "submitted"));
+    static constexpr size_t width = 7;
+    static constexpr size_t required = 5;
+    static constexpr char delimiter = '|';
+    static constexpr const char* separator = "|";
+};
+
+// Persistent priority queue of parent requests.
+// Priority is (days waited + type boost), so a request gains one point per day
+// it sits in the inbox. Since every pending request ages at the same rate, the
+// ordering only depends on (submittedDay - boost), which lets the heap keys
+// stay fixed while older requests still rise past newer high-priority ones.
+class ParentRequestQueue
+{
+private:
+    string fileName;
+    vector<ParentRequest> requests;
+    unordered_map<long, size_t> indexById;
+
+    // Indexed binary heap over pending requests (values are indexes into requests)
+    vector<size_t> heap;
+    vector<long> heapPos; // position in heap per request index, -1 if not queued
+
+    long nextId = 1;
+    size_t staleLines = 0; // superseded lines in the file since last compaction
+    bool datesAssigned = false; // undated lines were given a submit date on load
+
+    static int typeBoost(const string& type)
+    {
+        string t = Utils::toLower(type);
+        if (t.find("urgent") != string::npos || t.find("medical") != string::npos || t.find("safety") != string::npos)
+            return 14;
+        if (t.find("fee") != string::npos)
+            return 7;
+        if (t.find("section") != string::npos || t.find("transfer") != string::npos)
+            return 3;
+        return 0;
+    }
+
+    long keyOf(size_t idx) const
+    {
+        return Utils::dateToDays(requests[idx].submitted) - typeBoost(requests[idx].type);
+    }
+
+    bool before(size_t a, size_t b) const
+    {
+        long ka = keyOf(a), kb = keyOf(b);
+        if (ka != kb)
+            return ka < kb;
+        return requests[a].requestId < requests[b].requestId;
+    }
+
+    void place(size_t pos, size_t idx)
+    {
+        heap[pos] = idx;
+        heapPos[idx] = static_cast<long>(pos);
+    }
+
+    void siftUp(size_t pos)
+    {
+        size_t idx = heap[pos];
+        while (pos > 0)
+        {
+            size_t parent = (pos - 1) / 2;
+            if (!before(idx, heap[parent]))
+                break;
+            place(pos, heap[parent]);
+            pos = parent;
+        }
+        place(pos, idx);
+    }
+
+    void siftDown(size_t pos)
+    {
+        size_t idx = heap[pos];
+        size_t n = heap.size();
+        while (true)
+        {
+            size_t child = 2 * pos + 1;
+            if (child >= n)
+                break;
+            if (child + 1 < n && before(heap[child + 1], heap[child]))
+                child++;
+            if (!before(heap[child], idx))
+                break;
+            place(pos, heap[child]);
+            pos = child;
+        }
+        place(pos, idx);
+    }
+
+    void heapPush(size_t idx)
+    {
+        heap.push_back(idx);
+        siftUp(heap.size() - 1);
+    }
+
+    void heapErase(size_t idx)
+    {
+        long pos = heapPos[idx];
+        if (pos < 0)
+            return;
+
+        size_t last = heap.back();
+        heap.pop_back();
+        heapPos[idx] = -1;
+        if (static_cast<size_t>(pos) < heap.size())
+        {
+            place(pos, last);
+            siftDown(pos);
+            siftUp(heapPos[last]);
+        }
+    }
+
+    // Insert or replace a request in memory, keeping the heap in sync
+    void upsert(const ParentRequest& req)
+    {
+        auto it = indexById.find(req.requestId);
+        if (it == indexById.end())
+        {
+            indexById[req.requestId] = requests.size();
+            requests.push_back(req);
+            heapPos.push_back(-1);
+            if (req.status == "Pending")
+                heapPush(requests.size() - 1);
+        }
+        else
+        {
+            size_t idx = it->second;
+            heapErase(idx);
+            requests[idx] = req;
+            if (req.status == "Pending")
+                heapPush(idx);
+            staleLines++;
+        }
+        nextId = max(nextId, req.requestId + 1);
+    }
+
+    void appendLine(const ParentRequest& req)
+    {
+        Storage::appendText(fileName, req.toLine() + "\n");
+    }
+
+public:
+    explicit ParentRequestQueue(const string& file = "parent_requests.txt") : fileName(Catalog::path(file)) {}
+
+    // Reads the request log. Lines carrying a request id supersede earlier lines
+    // with the same id; legacy lines without one are matched on child, parent,
+    // type and note so that their appended "Approved" copies replace them.
+    // Lines without a submit date take the log's modification date, which the
+    // next compaction writes out so their age stays fixed from then on.
+    void load()
+    {
+        requests.clear();
+        indexById.clear();
+        heap.clear();
+        heapPos.clear();
+        nextId = 1;
+        staleLines = 0;
+        datesAssigned = false;
+
+        long long size = -1;
+        long long modified = 0;
+        string undated = Storage::fileStamp(fileName, size, modified) ? Utils::daysToDate(static_cast<long>(modified / 86400)) : Utils::getCurrentDate();
+
+        unordered_map<string, long> legacyIds;
+
+        Schema::forEach<ParentRequest>(Storage::readAll(fileName), [&](ParentRequest& req)
+            {
+            if (req.requestId == 0)
+            {
+                string legacyKey = req.childId + "|" + req.parentContact + "|" + req.type + "|" + req.note;
+                auto found = legacyIds.find(legacyKey);
+                if (found != legacyIds.end())
+                {
+                    req.requestId = found->second;
+                    req.submitted = requests[indexById[req.requestId]].submitted;
+                }
+                else
+                {
+                    req.requestId = nextId;
+                    legacyIds[legacyKey] = nextId;
+                    staleLines++; // legacy lines are rewritten with ids on compaction
+                }
+            }
+            if (Utils::dateToDays(req.submitted) == 0)
+            {
+                req.submitted = undated;
+                datesAssigned = true;
+            }
+            upsert(req);
+            });
+    }
+
+    const ParentRequest& submit(const string& childId, const string& parentContact, const string& type, const string& note)
+    {
+        ParentRequest req{ nextId, childId, parentContact, type, note, "Pending", Utils::getCurrentDate() };
+        upsert(req);
+        appendLine(req);
+        return requests[indexById[req.requestId]];
+    }
+
+    bool updateStatus(long requestId, const string& status)
+    {
+        auto it = indexById.find(requestId);
+        if (it == indexById.end())
+            return false;
+
+        ParentRequest req = requests[it->second];
+        req.status = status;
+        upsert(req);
+        appendLine(req);
+        return true;
+    }
+
+    size_t pendingCount() const
+    {
+        return heap.size();
+    }
+
+    bool empty() const
+    {
+        return heap.empty();
+    }
+
+    const ParentRequest& top() const
+    {
+        return requests[heap.front()];
+    }
+
+    ParentRequest pop()
+    {
+        ParentRequest req = requests[heap.front()];
+        heapErase(heap.front());
+        return req;
+    }
+
+    // Top k pending requests in priority order without disturbing the heap
+    vector<ParentRequest> peek(size_t k) const
+    {
+        vector<ParentRequest> result;
+        auto cmp = [this](size_t a, size_t b) { return before(heap[b], heap[a]); };
+        priority_queue<size_t, vector<size_t>, decltype(cmp)> frontier(cmp);
+        if (!heap.empty())
+            frontier.push(0);
+
+        while (!frontier.empty() && result.size() < k)
+        {
+            size_t pos = frontier.top();
+            frontier.pop();
+            result.push_back(requests[heap[pos]]);
+            if (2 * pos + 1 < heap.size())
+                frontier.push(2 * pos + 1);
+            if (2 * pos + 2 < heap.size())
+                frontier.push(2 * pos + 2);
+        }
+        return result;
+    }
+
+    int ageInDays(const ParentRequest& req) const
+    {
+        if (req.submitted.empty())
+            return 0;
+        return static_cast<int>(Utils::dateToDays(Utils::getCurrentDate()) - Utils::dateToDays(req.submitted));
+    }
+
+    bool needsCompaction() const
+    {
+        return datesAssigned || (staleLines > 0 && staleLines >= requests.size() / 2);
+    }
+
+    // Rewrite the log with exactly one line per request
+    void compact()
+    {
+        string content = "[PARENT REQUESTS]\n";
+        for (const auto& req : requests)
+        {
+            content += req.toLine() + "\n";
+        }
+        if (Storage::writeAtomic(fileName, content))
+        {
+            staleLines = 0;
+            datesAssigned = false;
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,350 @@
+#ifndef ROSTER_H
+#define ROSTER_H
+
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <algorithm>
+#include <fstream>
+#include <cstdio>
+#include <cstdint>
+#include <cctype>
+
+#include "scan.h"
+#include "storage.h"
+#include "schema.h"
+#include "table.h"
+
+using namespace std;
+
+// Keep records whose field equals value; for list fields such as a teacher's
+// classes, any item of the list may match. Case is ignored.
+struct RosterFilter
+{
+    string field;
+    string value;
+};
+
+// Paged listing over a roster file. Opening the cursor makes one streaming
+// pass over the file and keeps only the byte offset and sort key of each
+// matching line; the records of a page are read back from those offsets when
+// the page is shown, so at most one page is ever materialized.
+template <class Record>
+class RosterCursor
+{
+private:
+    struct Entry
+    {
+        uint64_t offset;
+        uint32_t length;
+        uint32_t keyStart; // into keys
+        uint32_t keyLength;
+    };
+
+    struct Condition
+    {
+        size_t field;
+        string value;
+    };
+
+    string path;
+    vector<Condition> conditions;
+    size_t sortField; // the layout's width keeps file order
+    size_t pageLength;
+    vector<Entry> entries;
+    string keys;
+    long long indexedSize = -1;
+    long long indexedTime = 0;
+
+    static bool sameText(string_view a, string_view b)
+    {
+        if (a.size() != b.size())
+            return false;
+        for (size_t i = 0; i < a.size(); ++i)
+        {
+            if (tolower(static_cast<unsigned char>(a[i])) != tolower(static_cast<unsigned char>(b[i])))
+                return false;
+        }
+        return true;
+    }
+
+    static bool matches(string_view field, const string& value)
+    {
+        if (sameText(field, value))
+            return true;
+        while (!field.empty())
+        {
+            size_t comma = field.find(',');
+            if (comma == string_view::npos)
+                return false;
+            if (sameText(Schema::trim(field.substr(0, comma)), value))
+                return true;
+            field = Schema::trim(field.substr(comma + 1));
+            if (sameText(field, value))
+                return true;
+        }
+        return false;
+    }
+
+    static bool isNumber(string_view text)
+    {
+        return !text.empty() && all_of(text.begin(), text.end(), [](char c) { return c >= '0' && c <= '9'; });
+    }
+
+    // Numbers such as roll numbers and salaries compare by value
+    static bool keyLess(string_view a, string_view b)
+    {
+        if (isNumber(a) && isNumber(b))
+        {
+            while (a.size() > 1 && a[0] == '0')
+                a.remove_prefix(1);
+            while (b.size() > 1 && b[0] == '0')
+                b.remove_prefix(1);
+            if (a.size() != b.size())
+                return a.size() < b.size();
+        }
+        return a < b;
+    }
+
+    string_view keyOf(const Entry& entry) const
+    {
+        return string_view(keys).substr(entry.keyStart, entry.keyLength);
+    }
+
+    void indexLine(string_view line, uint64_t offset, vector<Scan::Span>& spans)
+    {
+        if (!line.empty() && line.back() == '\r')
+            line.remove_suffix(1);
+        if (line.empty() || line[0] == '[')
+            return;
+
+        spans.clear();
+        Scan::split(line.data(), line.size(), Schema::Layout<Record>::delimiter, spans);
+        if (spans.size() < Schema::Layout<Record>::required)
+            return;
+
+        auto fieldText = [&](size_t index)
+            {
+            if (index >= spans.size())
+                return string_view();
+            return line.substr(spans[index].begin, spans[index].end - spans[index].begin);
+            };
+
+        for (const auto& condition : conditions)
+        {
+            if (!matches(fieldText(condition.field), condition.value))
+                return;
+        }
+
+        Entry entry{ offset, static_cast<uint32_t>(line.size()), static_cast<uint32_t>(keys.size()), 0 };
+        if (sortField < Schema::Layout<Record>::width)
+        {
+            string_view key = fieldText(sortField);
+            keys.append(key.data(), key.size());
+            entry.keyLength = static_cast<uint32_t>(key.size());
+        }
+        entries.push_back(entry);
+    }
+
+    // One pass over the file in fixed-size chunks
+    void build()
+    {
+        entries.clear();
+        keys.clear();
+        indexedSize = -1;
+        if (!Storage::fileStamp(path, indexedSize, indexedTime))
+            return;
+
+        FILE* file = fopen(path.c_str(), "rb");
+        if (!file)
+            return;
+
+        const size_t chunkSize = 1 << 20;
+        string buffer;
+        uint64_t bufferOffset = 0; // file offset of buffer[0]
+        Scan::Offsets newlines;
+        vector<Scan::Span> spans;
+        vector<char> chunk(chunkSize);
+
+        size_t got;
+        while ((got = fread(chunk.data(), 1, chunk.size(), file)) > 0)
+        {
+            size_t scanFrom = buffer.size();
+            buffer.append(chunk.data(), got);
+
+            newlines.clear();
+            Scan::find(buffer.data() + scanFrom, buffer.size() - scanFrom, '\n', '\n', newlines);
+
+            size_t start = 0;
+            for (size_t p : newlines)
+            {
+                size_t end = scanFrom + p;
+                indexLine(string_view(buffer).substr(start, end - start), bufferOffset + start, spans);
+                start = end + 1;
+            }
+            buffer.erase(0, start);
+            bufferOffset += start;
+        }
+        if (!buffer.empty())
+            indexLine(buffer, bufferOffset, spans);
+        fclose(file);
+
+        if (sortField < Schema::Layout<Record>::width)
+        {
+            stable_sort(entries.begin(), entries.end(), [this](const Entry& a, const Entry& b)
+                {
+                return keyLess(keyOf(a), keyOf(b));
+                });
+        }
+    }
+
+public:
+    RosterCursor(const string& path, const vector<RosterFilter>& filters, const string& sortBy, size_t pageLength = 20)
+        : path(path), sortField(Schema::fieldIndex<Record>(sortBy)), pageLength(max<size_t>(pageLength, 1))
+    {
+        for (const auto& filter : filters)
+        {
+            size_t field = Schema::fieldIndex<Record>(filter.field);
+            if (field < Schema::Layout<Record>::width && !filter.value.empty())
+                conditions.push_back(Condition{ field, filter.value });
+        }
+        build();
+    }
+
+    size_t count() const
+    {
+        return entries.size();
+    }
+
+    size_t pageCount() const
+    {
+        return (entries.size() + pageLength - 1) / pageLength;
+    }
+
+    // Records of one page, re-indexing first if the file changed since the
+    // cursor was opened
+    vector<Record> page(size_t number)
+    {
+        long long size = -1;
+        long long time = 0;
+        if (!Storage::fileStamp(path, size, time) || size != indexedSize || time != indexedTime)
+            build();
+
+        vector<Record> records;
+        size_t first = number * pageLength;
+        if (first >= entries.size())
+            return records;
+        size_t last = min(entries.size(), first + pageLength);
+
+        ifstream file(path, ios::binary);
+        if (!file.is_open())
+            return records;
+
+        string line;
+        records.reserve(last - first);
+        for (size_t i = first; i < last; ++i)
+        {
+            line.resize(entries[i].length);
+            file.seekg(static_cast<streamoff>(entries[i].offset));
+            if (!file.read(&line[0], line.size()))
+            {
+                file.clear();
+                continue;
+            }
+            Record record;
+            if (Schema::parseLine(line, record))
+                records.push_back(move(record));
+        }
+        return records;
+    }
+};
+
+namespace Roster
+{
+    // Show the cursor one page at a time until the user quits
+    template <class Record>
+    void browse(RosterCursor<Record>& cursor, const vector<string>& titles, const string& emptyMessage)
+    {
+        if (cursor.count() == 0)
+        {
+            cout << emptyMessage << '\n';
+            return;
+        }
+
+        size_t page = 0;
+        string input;
+        while (true)
+        {
+            vector<Record> records = cursor.page(page);
+            size_t pages = max<size_t>(cursor.pageCount(), 1);
+
+            ConsoleTable table;
+            table.underlined();
+            for (const auto& title : titles)
+            {
+                table.column(title);
+            }
+            vector<string> texts;
+            for (const auto& record : records)
+            {
+                texts.clear();
+                Schema::appendTexts(texts, record);
+                for (size_t i = 0; i < titles.size() && i < texts.size(); ++i)
+                {
+                    table.cell(texts[i]);
+                }
+            }
+
+            string out = "\n--- Page " + to_string(page + 1) + " of " + to_string(pages) + " (" + to_string(cursor.count()) + " records) ---\n";
+            table.render(out);
+            out += "[n]ext, [p]revious, page number, [q]uit: ";
+            cout << out;
+
+            if (!getline(cin, input) || input == "q" || input == "Q")
+                break;
+            if (input.empty() && page + 1 >= pages)
+                break;
+            if ((input == "n" || input == "N" || input.empty()) && page + 1 < pages)
+                page++;
+            else if ((input == "p" || input == "P") && page > 0)
+                page--;
+            else if (!input.empty() && all_of(input.begin(), input.end(), ::isdigit) && input.size() < 9)
+                page = min(pages, max<size_t>(stoul(input), 1)) - 1;
+        }
+    }
+
+    // Ask for a value per filter field and a sort field, then browse the file
+    template <class Record>
+    void list(const string& path, const vector<string>& titles, const vector<pair<string, string>>& filterFields, const vector<pair<string, string>>& sortFields, const string& emptyMessage)
+    {
+        vector<RosterFilter> filters;
+        string input;
+        for (const auto& field : filterFields)
+        {
+            cout << "Filter by " << field.second << " (leave empty for all): ";
+            getline(cin, input);
+            filters.push_back(RosterFilter{ field.first, input });
+        }
+
+        cout << "Sort by: 0. File order";
+        for (size_t i = 0; i < sortFields.size(); ++i)
+        {
+            cout << "  " << i + 1 << ". " << sortFields[i].second;
+        }
+        cout << "\nEnter choice: ";
+        getline(cin, input);
+        string sortBy;
+        if (!input.empty() && all_of(input.begin(), input.end(), ::isdigit) && input.size() < 9)
+        {
+            size_t choice = stoul(input);
+            if (choice >= 1 && choice <= sortFields.size())
+                sortBy = sortFields[choice - 1].first;
+        }
+
+        RosterCursor<Record> cursor(path, filters, sortBy);
+        browse(cursor, titles, emptyMessage);
+    }
+}
+
+#endif
@@ -0,0 +1,277 @@
+#ifndef SCAN_H
+#define SCAN_H
+
+#include <string>
+#include <vector>
+#include <memory_resource>
+#include <cstddef>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define SCAN_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// AVX2 code is compiled per function so the rest of the program keeps the
+// baseline instruction set; the kernel is only called if the CPU has AVX2
+#if defined(SCAN_X86) && defined(__GNUC__)
+#define SCAN_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define SCAN_TARGET_AVX2
+#endif
+
+using namespace std;
+
+// Byte scanning for the pipe-delimited data files. A kernel reports the
+// offset of every byte equal to one of two characters (a delimiter and
+// '\n'), testing 16 or 32 bytes per step; the fastest kernel the CPU
+// supports is picked once at startup.
+namespace Scan
+{
+    // Offsets can live in a caller's arena
+    typedef pmr::vector<size_t> Offsets;
+
+    typedef void (*Kernel)(const char* data, size_t size, char a, char b, Offsets& out);
+
+    struct Span
+    {
+        size_t begin;
+        size_t end;
+    };
+
+    void scalarKernel(const char* data, size_t size, char a, char b, Offsets& out)
+    {
+        for (size_t i = 0; i < size; ++i)
+        {
+            if (data[i] == a || data[i] == b)
+                out.push_back(i);
+        }
+    }
+
+#ifdef SCAN_X86
+    int lowestBit(unsigned int mask)
+    {
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanForward(&index, mask);
+        return static_cast<int>(index);
+#else
+        return __builtin_ctz(mask);
+#endif
+    }
+
+    // SSE2 is part of x86-64, so this kernel needs no runtime check
+    void sse2Kernel(const char* data, size_t size, char a, char b, Offsets& out)
+    {
+        const __m128i va = _mm_set1_epi8(a);
+        const __m128i vb = _mm_set1_epi8(b);
+        size_t i = 0;
+        for (; i + 16 <= size; i += 16)
+        {
+            __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+            unsigned int mask = static_cast<unsigned int>(_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(block, va), _mm_cmpeq_epi8(block, vb))));
+            while (mask)
+            {
+                out.push_back(i + lowestBit(mask));
+                mask &= mask - 1;
+            }
+        }
+        for (; i < size; ++i)
+        {
+            if (data[i] == a || data[i] == b)
+                out.push_back(i);
+        }
+    }
+
+    SCAN_TARGET_AVX2 void avx2Kernel(const char* data, size_t size, char a, char b, Offsets& out)
+    {
+        const __m256i va = _mm256_set1_epi8(a);
+        const __m256i vb = _mm256_set1_epi8(b);
+        size_t i = 0;
+        for (; i + 32 <= size; i += 32)
+        {
+            __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+            unsigned int mask = static_cast<unsigned int>(_mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(block, va), _mm256_cmpeq_epi8(block, vb))));
+            while (mask)
+            {
+                out.push_back(i + lowestBit(mask));
+                mask &= mask - 1;
+            }
+        }
+        for (; i < size; ++i)
+        {
+            if (data[i] == a || data[i] == b)
+                out.push_back(i);
+        }
+    }
+
+    bool cpuHasAvx2()
+    {
+#ifdef _MSC_VER
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7)
+            return false;
+        // The OS must also save the YMM registers on context switches
+        __cpuid(info, 1);
+        if (!(info[2] & (1 << 27)) || (_xgetbv(0) & 6) != 6)
+            return false;
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+#else
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+#endif
+    }
+#endif
+
+    Kernel kernel()
+    {
+#ifdef SCAN_X86
+        static const Kernel chosen = cpuHasAvx2() ? avx2Kernel : sse2Kernel;
+        return chosen;
+#else
+        return scalarKernel;
+#endif
+    }
+
+    const char* kernelName()
+    {
+#ifdef SCAN_X86
+        return kernel() == avx2Kernel ? "avx2" : "sse2";
+#else
+        return "scalar";
+#endif
+    }
+
+    // Append the offsets of every byte equal to a or b
+    void find(const char* data, size_t size, char a, char b, Offsets& out)
+    {
+        kernel()(data, size, a, b, out);
+    }
+
+    bool isSpace(char c)
+    {
+        return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v';
+    }
+
+    // Only the bytes next to a boundary are looked at, so trimming stays scalar
+    Span trim(const char* data, size_t begin, size_t end)
+    {
+        while (begin < end && isSpace(data[begin]))
+            begin++;
+        while (end > begin && isSpace(data[end - 1]))
+            end--;
+        return Span{ begin, end };
+    }
+
+    // Trimmed fields of one record
+    void split(const char* data, size_t size, char delimiter, vector<Span>& fields)
+    {
+        thread_local Offsets positions;
+        positions.clear();
+        find(data, size, delimiter, delimiter, positions);
+
+        size_t start = 0;
+        for (size_t p : positions)
+        {
+            fields.push_back(trim(data, start, p));
+            start = p + 1;
+        }
+        fields.push_back(trim(data, start, size));
+    }
+
+    // Line and field offsets of a whole buffer, found in a single pass over
+    // the delimiters and newlines. The index refers into the text it was
+    // built from, which must outlive it.
+    class FieldIndex
+    {
+    private:
+        const string* text;
+        vector<Span> lineSpans;   // without the newline or a trailing '\r'
+        vector<size_t> firstField; // per line, plus one past the last line
+        vector<Span> fields;       // trimmed
+
+    public:
+        FieldIndex(const string& source, char delimiter) : text(&source)
+        {
+            Offsets positions;
+            positions.reserve(source.size() / 8);
+            find(source.data(), source.size(), delimiter, '\n', positions);
+
+            const char* data = source.data();
+            size_t lineStart = 0;
+            size_t fieldStart = 0;
+            auto endLine = [&](size_t end)
+                {
+                fields.push_back(trim(data, fieldStart, end));
+                size_t lineEnd = end > lineStart && data[end - 1] == '\r' ? end - 1 : end;
+                lineSpans.push_back(Span{ lineStart, lineEnd });
+                firstField.push_back(fields.size());
+                };
+
+            firstField.push_back(0);
+            for (size_t p : positions)
+            {
+                if (data[p] == '\n')
+                {
+                    endLine(p);
+                    lineStart = p + 1;
+                }
+                else
+                {
+                    fields.push_back(trim(data, fieldStart, p));
+                }
+                fieldStart = p + 1;
+            }
+            if (lineStart < source.size())
+                endLine(source.size());
+        }
+
+        size_t lineCount() const
+        {
+            return lineSpans.size();
+        }
+
+        size_t fieldCount(size_t line) const
+        {
+            return firstField[line + 1] - firstField[line];
+        }
+
+        string line(size_t line) const
+        {
+            return text->substr(lineSpans[line].begin, lineSpans[line].end - lineSpans[line].begin);
+        }
+
+        bool lineEmpty(size_t line) const
+        {
+            return lineSpans[line].begin == lineSpans[line].end;
+        }
+
+        char firstChar(size_t line) const
+        {
+            return lineEmpty(line) ? '\0' : (*text)[lineSpans[line].begin];
+        }
+
+        string field(size_t line, size_t index) const
+        {
+            const Span& span = fields[firstField[line] + index];
+            return text->substr(span.begin, span.end - span.begin);
+        }
+
+        // All fields of a line, as Utils::parseRecord would return them
+        vector<string> record(size_t line) const
+        {
+            vector<string> parts;
+            for (size_t i = firstField[line]; i < firstField[line + 1]; ++i)
+            {
+                parts.push_back(text->substr(fields[i].begin, fields[i].end - fields[i].begin));
+            }
+            return parts;
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,486 @@
+#ifndef SCHEMA_H
+#define SCHEMA_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <tuple>
+#include <utility>
+#include <charconv>
+#include <type_traits>
+
+#include "utils.h"
+#include "scan.h"
+#include "storage.h"
+#include "records.h"
+
+using namespace std;
+
+// Lines inside the sectioned data files
+struct GradeLine
+{
+    string studentId;
+    int score = 0;
+};
+
+// Roster and grade lines as views into the file text, for reads that
+// never outlive the buffer they parsed
+struct StudentView
+{
+    string_view id;
+    string_view name;
+    string_view className;
+    string_view rollNo;
+    string_view parentContact;
+    string_view feeStatus;
+};
+
+struct GradeView
+{
+    string_view studentId;
+    int score = 0;
+};
+
+struct AttendanceLine
+{
+    string studentId;
+    string status;
+};
+
+struct PaymentLine
+{
+    string id;
+    string name;
+    string amount;
+    string date;
+};
+
+struct FeeEntry
+{
+    string studentId;
+    string date;
+    string kind;        // Challan or Payment
+    string month;
+    string amount;
+    string balance;     // what the student owes after this entry
+};
+
+// Record layouts described once as member pointers. Parsing walks the line
+// field by field straight into the members and serializing writes them back
+// in the same order, so a loader and its save can no longer disagree.
+namespace Schema
+{
+    template <class Record, class Type>
+    struct Field
+    {
+        Type Record::* member;
+        const char* name;
+    };
+
+    template <class Record, class Type>
+    constexpr Field<Record, Type> field(Type Record::* member, const char* name)
+    {
+        return Field<Record, Type>{ member, name };
+    }
+
+    // Specialized for each record type:
+    //   fields     Field descriptors in file order
+    //   width      number of fields (checked against fields at compile time)
+    //   required   leading fields a line must have; the rest keep their defaults
+    //   delimiter  separator when reading, separator when writing
+    template <class Record>
+    struct Layout;
+
+    template <class Record>
+    constexpr size_t fieldCount()
+    {
+        return tuple_size<decay_t<decltype(Layout<Record>::fields)>>::value;
+    }
+
+    // Position of the field called name, or the layout's width if none is
+    template <class Record>
+    size_t fieldIndex(const string& name)
+    {
+        size_t index = Layout<Record>::width;
+        size_t position = 0;
+        apply([&](const auto&... descriptor)
+            {
+            ((index = (index == Layout<Record>::width && name == descriptor.name) ? position : index, position++), ...);
+            }, Layout<Record>::fields);
+        return index;
+    }
+
+    template <class Record>
+    constexpr bool checkLayout()
+    {
+        static_assert(Layout<Record>::width == fieldCount<Record>(), "layout width does not match its field list");
+        static_assert(Layout<Record>::required >= 1 && Layout<Record>::required <= Layout<Record>::width, "required field count out of range");
+        return true;
+    }
+
+    string_view trim(string_view text)
+    {
+        while (!text.empty() && Scan::isSpace(text.front()))
+            text.remove_prefix(1);
+        while (!text.empty() && Scan::isSpace(text.back()))
+            text.remove_suffix(1);
+        return text;
+    }
+
+    bool decode(string_view text, string& out)
+    {
+        out.assign(text.data(), text.size());
+        return true;
+    }
+
+    // Views point into the text being parsed, which must outlive the record
+    bool decode(string_view text, string_view& out)
+    {
+        out = text;
+        return true;
+    }
+
+    template <class Integer>
+    bool decodeInteger(string_view text, Integer& out)
+    {
+        const char* end = text.data() + text.size();
+        from_chars_result result = from_chars(text.data(), end, out);
+        return result.ec == errc() && result.ptr == end;
+    }
+
+    bool decode(string_view text, int& out)
+    {
+        return decodeInteger(text, out);
+    }
+
+    bool decode(string_view text, long& out)
+    {
+        return decodeInteger(text, out);
+    }
+
+    // Comma separated lists such as a teacher's subjects or classes
+    bool decode(string_view text, vector<string>& out)
+    {
+        out.clear();
+        while (!text.empty())
+        {
+            size_t comma = text.find(',');
+            string_view item = trim(text.substr(0, comma));
+            if (!item.empty())
+                out.emplace_back(item.data(), item.size());
+            text.remove_prefix(comma == string_view::npos ? text.size() : comma + 1);
+        }
+        return true;
+    }
+
+    void encode(string& out, const string& value)
+    {
+        out += value;
+    }
+
+    void encode(string& out, string_view value)
+    {
+        out.append(value.data(), value.size());
+    }
+
+    void encode(string& out, int value)
+    {
+        out += to_string(value);
+    }
+
+    void encode(string& out, long value)
+    {
+        out += to_string(value);
+    }
+
+    void encode(string& out, const vector<string>& value)
+    {
+        for (size_t i = 0; i < value.size(); ++i)
+        {
+            if (i > 0)
+                out += ',';
+            out += value[i];
+        }
+    }
+
+    template <class Record, size_t... I>
+    bool parseFields(string_view line, Record& record, index_sequence<I...>)
+    {
+        typedef Layout<Record> L;
+        size_t pos = 0;
+        bool more = true;
+        bool ok = true;
+
+        auto parseField = [&](auto descriptor, size_t index)
+            {
+            if (!ok)
+                return;
+            if (!more)
+            {
+                ok = index >= L::required;
+                return;
+            }
+            size_t end = line.find(L::delimiter, pos);
+            string_view value = trim(line.substr(pos, end == string_view::npos ? string_view::npos : end - pos));
+            more = end != string_view::npos;
+            pos = more ? end + 1 : line.size();
+
+            if (value.empty() && index >= L::required)
+                return;
+            ok = decode(value, record.*(descriptor.member));
+            };
+
+        (parseField(get<I>(L::fields), I), ...);
+        return ok;
+    }
+
+    template <class Record, size_t... I>
+    void writeFields(string& out, const Record& record, index_sequence<I...>)
+    {
+        typedef Layout<Record> L;
+        auto writeField = [&](auto descriptor, size_t index)
+            {
+            if (index > 0)
+                out += L::separator;
+            encode(out, record.*(descriptor.member));
+            };
+        (writeField(get<I>(L::fields), I), ...);
+    }
+
+    // Fill record from one line; false if a required field is missing or malformed.
+    // Fields past the layout's width are ignored.
+    template <class Record>
+    bool parseLine(string_view line, Record& record)
+    {
+        static_assert(checkLayout<Record>(), "");
+        return parseFields(line, record, make_index_sequence<fieldCount<Record>()>());
+    }
+
+    template <class Record>
+    void appendLine(string& out, const Record& record)
+    {
+        static_assert(checkLayout<Record>(), "");
+        writeFields(out, record, make_index_sequence<fieldCount<Record>()>());
+        out += '\n';
+    }
+
+    // Each field as it is written to the file, for display
+    template <class Record>
+    void appendTexts(vector<string>& out, const Record& record)
+    {
+        apply([&](const auto&... descriptor)
+            {
+            auto appendText = [&](const auto& value)
+                {
+                out.emplace_back();
+                encode(out.back(), value);
+                };
+            (appendText(record.*(descriptor.member)), ...);
+            }, Layout<Record>::fields);
+    }
+
+    template <class Record>
+    string toLine(const Record& record)
+    {
+        string out;
+        appendLine(out, record);
+        out.pop_back();
+        return out;
+    }
+
+    // Visit every record in text, skipping blank lines and "[...]" banners.
+    // The newline index is taken from resource.
+    template <class Record, class Visit>
+    void forEach(string_view text, Visit visit, pmr::memory_resource* resource = pmr::get_default_resource())
+    {
+        Scan::Offsets newlines(resource);
+        Scan::find(text.data(), text.size(), '\n', '\n', newlines);
+        newlines.push_back(text.size());
+
+        size_t start = 0;
+        for (size_t end : newlines)
+        {
+            if (start >= text.size())
+                break;
+            string_view line = text.substr(start, end - start);
+            start = end + 1;
+            if (!line.empty() && line.back() == '\r')
+                line.remove_suffix(1);
+            if (line.empty() || line[0] == '[')
+                continue;
+
+            Record record;
+            if (parseLine(line, record))
+                visit(record);
+        }
+    }
+
+    template <class Record, class Keep>
+    vector<Record> loadFile(const string& path, Keep keep)
+    {
+        vector<Record> records;
+        forEach<Record>(Storage::readAll(path), [&](Record& record)
+            {
+            if (keep(record))
+                records.push_back(move(record));
+            });
+        return records;
+    }
+
+    template <class Record>
+    vector<Record> loadFile(const string& path)
+    {
+        return loadFile<Record>(path, [](const Record&) { return true; });
+    }
+
+    // Rewrite a roster file as banner + one line per record, atomically
+    template <class Record>
+    bool saveFile(const string& path, const string& banner, const vector<Record>& records)
+    {
+        string out = banner + "\n";
+        for (const auto& record : records)
+        {
+            appendLine(out, record);
+        }
+        return Storage::writeAtomic(path, out);
+    }
+
+    template <>
+    struct Layout<StudentRecord>
+    {
+        static constexpr auto fields = make_tuple(
+            field(&StudentRecord::id, "id"),
+            field(&StudentRecord::name, "name"),
+            field(&StudentRecord::className, "class"),
+            field(&StudentRecord::rollNo, "rollNo"),
+            field(&StudentRecord::parentContact, "parentContact"),
+            field(&StudentRecord::feeStatus, "feeStatus"));
+        static constexpr size_t width = 6;
+        static constexpr size_t required = 6;
+        static constexpr char delimiter = '|';
+        static constexpr const char* separator = "|";
+    };
+
+    template <>
+    struct Layout<StudentView>
+    {
+        static constexpr auto fields = make_tuple(
+            field(&StudentView::id, "id"),
+            field(&StudentView::name, "name"),
+            field(&StudentView::className, "class"),
+            field(&StudentView::rollNo, "rollNo"),
+            field(&StudentView::parentContact, "parentContact"),
+            field(&StudentView::feeStatus, "feeStatus"));
+        static constexpr size_t width = 6;
+        static constexpr size_t required = 6;
+        static constexpr char delimiter = '|';
+        static constexpr const char* separator = "|";
+    };
+
+    // leavesTaken was added later; older files have 7 fields
+    template <>
+    struct Layout<TeacherRecord>
+    {
+        static constexpr auto fields = make_tuple(
+            field(&TeacherRecord::id, "id"),
+            field(&TeacherRecord::name, "name"),
+            field(&TeacherRecord::subjects, "subjects"),
+            field(&TeacherRecord::qualification, "qualification"),
+            field(&TeacherRecord::contact, "contact"),
+            field(&TeacherRecord::assignedClasses, "classes"),
+            field(&TeacherRecord::periodsPerWeek, "periodsPerWeek"),
+            field(&TeacherRecord::leavesTaken, "leavesTaken"));
+        static constexpr size_t width = 8;
+        static constexpr size_t required = 7;
+        static constexpr char delimiter = '|';
+        static constexpr const char* separator = "|";
+    };
+
+    template <>
+    struct Layout<StaffRecord>
+    {
+        static constexpr auto fields = make_tuple(
+            field(&StaffRecord::id, "id"),
+            field(&StaffRecord::name, "name"),
+            field(&StaffRecord::role, "role"),
+            field(&StaffRecord::contact, "contact"),
+            field(&StaffRecord::salary, "salary"),
+            field(&StaffRecord::leavesTaken, "leavesTaken"));
+        static constexpr size_t width = 6;
+        static constexpr size_t required = 6;
+        static constexpr char delimiter = '|';
+        static constexpr const char* separator = "|";
+    };
+
+    template <>
+    struct Layout<GradeView>
+    {
+        static constexpr auto fields = make_tuple(
+            field(&GradeView::studentId, "studentId"),
+            field(&GradeView::score, "score"));
+        static constexpr size_t width = 2;
+        static constexpr size_t required = 2;
+        static constexpr char delimiter = '|';
+        static constexpr const char* separator = "|";
+    };
+
+    // studentId|score inside a [GRADES ...] section
+    template <>
+    struct Layout<GradeLine>
+    {
+        static constexpr auto fields = make_tuple(
+            field(&GradeLine::studentId, "studentId"),
+            field(&GradeLine::score, "score"));
+        static constexpr size_t width = 2;
+        static constexpr size_t required = 2;
+        static constexpr char delimiter = '|';
+        static constexpr const char* separator = "|";
+    };
+
+    // studentId: Present|Absent inside an [ATTENDANCE ...] section
+    template <>
+    struct Layout<AttendanceLine>
+    {
+        static constexpr auto fields = make_tuple(
+            field(&AttendanceLine::studentId, "studentId"),
+            field(&AttendanceLine::status, "status"));
+        static constexpr size_t width = 2;
+        static constexpr size_t required = 2;
+        static constexpr char delimiter = ':';
+        static constexpr const char* separator = ": ";
+    };
+
+    // id|name|amount|date in salary_payments.txt
+    template <>
+    struct Layout<PaymentLine>
+    {
+        static constexpr auto fields = make_tuple(
+            field(&PaymentLine::id, "id"),
+            field(&PaymentLine::name, "name"),
+            field(&PaymentLine::amount, "amount"),
+            field(&PaymentLine::date, "date"));
+        static constexpr size_t width = 4;
+        static constexpr size_t required = 4;
+        static constexpr char delimiter = '|';
+        static constexpr const char* separator = "|";
+    };
+
+    // studentId|date|kind|month|amount|balance in fees_ledger.txt
+    template <>
+    struct Layout<FeeEntry>
+    {
+        static constexpr auto fields = make_tuple(
+            field(&FeeEntry::studentId, "studentId"),
+            field(&FeeEntry::date, "date"),
+            field(&FeeEntry::kind, "kind"),
+            field(&FeeEntry::month, "month"),
+            field(&FeeEntry::amount, "amount"),
+            field(&FeeEntry::balance, "balance"));
+        static constexpr size_t width = 6;
+        static constexpr size_t required = 6;
+        static constexpr char delimiter = '|';
+        static constexpr const char* separator = "|";
+    };
+}
+
+#endif
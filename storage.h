@@ -0,0 +1,506 @@
+#ifndef STORAGE_H
+#define STORAGE_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <string_view>
+#include <memory_resource>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <future>
+#include <deque>
+#include <cstdint>
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <io.h>
+#include <direct.h>
+#else
+#include <unistd.h>
+#include <dirent.h>
+#endif
+
+#include "scan.h"
+
+using namespace std;
+
+// File-level helpers shared by every writer of the .txt data files.
+// Appends and file swaps for the same path are serialized through one lock,
+// so a background compaction can replace a file without losing an append.
+namespace Storage
+{
+    struct Section
+    {
+        string header; // "[...]" line, empty for lines before the first header
+        vector<string> lines;
+        string committed; // date from the section's frame, empty if unframed
+    };
+
+    mutex& fileLock(const string& path)
+    {
+        static mutex registryLock;
+        static map<string, unique_ptr<mutex>> locks;
+
+        lock_guard<mutex> guard(registryLock);
+        unique_ptr<mutex>& entry = locks[path];
+        if (!entry)
+            entry.reset(new mutex());
+        return *entry;
+    }
+
+    uint32_t crc32(const char* data, size_t length)
+    {
+        static uint32_t table[256];
+        static once_flag tableInit;
+        call_once(tableInit, []()
+            {
+            for (uint32_t i = 0; i < 256; ++i)
+            {
+                uint32_t c = i;
+                for (int k = 0; k < 8; ++k)
+                    c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                table[i] = c;
+            }
+            });
+
+        uint32_t crc = 0xFFFFFFFFu;
+        for (size_t i = 0; i < length; ++i)
+        {
+            crc = table[(crc ^ static_cast<unsigned char>(data[i])) & 0xFF] ^ (crc >> 8);
+        }
+        return crc ^ 0xFFFFFFFFu;
+    }
+
+    // Append bytes with one write and flush them to disk before returning
+    bool durableAppend(const string& path, const string& data)
+    {
+#ifdef _WIN32
+        int fd = _open(path.c_str(), _O_WRONLY | _O_APPEND | _O_CREAT | _O_BINARY, 0644);
+        if (fd < 0)
+            return false;
+        bool ok = _write(fd, data.data(), static_cast<unsigned>(data.size())) == static_cast<int>(data.size());
+        ok = ok && _commit(fd) == 0;
+        _close(fd);
+#else
+        int fd = open(path.c_str(), O_WRONLY | O_APPEND | O_CREAT, 0644);
+        if (fd < 0)
+            return false;
+        size_t written = 0;
+        while (written < data.size())
+        {
+            ssize_t n = write(fd, data.data() + written, data.size() - written);
+            if (n <= 0)
+                break;
+            written += static_cast<size_t>(n);
+        }
+        bool ok = written == data.size();
+#ifdef __APPLE__
+        ok = ok && fsync(fd) == 0;
+#else
+        ok = ok && fdatasync(fd) == 0;
+#endif
+        close(fd);
+#endif
+        return ok;
+    }
+
+    // Group commit: callers hand over complete byte blocks and wait; a single
+    // writer thread drains everything queued so far and issues one write and
+    // one sync per file for the whole batch.
+    class GroupCommitter
+    {
+    private:
+        struct Entry
+        {
+            string path;
+            string data;
+            promise<bool> done;
+        };
+
+        mutex queueLock;
+        condition_variable wake;
+        deque<Entry*> queue;
+        bool stopping = false;
+        thread worker;
+
+        void run()
+        {
+            while (true)
+            {
+                deque<Entry*> batch;
+                {
+                    unique_lock<mutex> guard(queueLock);
+                    wake.wait(guard, [this]() { return stopping || !queue.empty(); });
+                    if (queue.empty() && stopping)
+                        return;
+                    batch.swap(queue);
+                }
+
+                // Coalesce per file, keeping commit order within each file
+                map<string, string> buffers;
+                for (Entry* entry : batch)
+                {
+                    buffers[entry->path] += entry->data;
+                }
+
+                map<string, bool> results;
+                for (const auto& buffer : buffers)
+                {
+                    lock_guard<mutex> guard(fileLock(buffer.first));
+                    results[buffer.first] = durableAppend(buffer.first, buffer.second);
+                }
+
+                for (Entry* entry : batch)
+                {
+                    entry->done.set_value(results[entry->path]);
+                }
+            }
+        }
+
+    public:
+        GroupCommitter()
+        {
+            worker = thread(&GroupCommitter::run, this);
+        }
+
+        ~GroupCommitter()
+        {
+            {
+                lock_guard<mutex> guard(queueLock);
+                stopping = true;
+            }
+            wake.notify_one();
+            worker.join();
+        }
+
+        bool commit(const string& path, const string& data)
+        {
+            Entry entry{ path, data, promise<bool>() };
+            future<bool> result = entry.done.get_future();
+            {
+                lock_guard<mutex> guard(queueLock);
+                queue.push_back(&entry);
+            }
+            wake.notify_one();
+            return result.get();
+        }
+
+        static GroupCommitter& instance()
+        {
+            static GroupCommitter committer;
+            return committer;
+        }
+    };
+
+    // Append a block of text durably through the group committer
+    bool appendText(const string& path, const string& text)
+    {
+        return GroupCommitter::instance().commit(path, text);
+    }
+
+    // Frame a section so torn writes can be recognised on read:
+    //   [FRAME <payload bytes> <crc32> <date>]
+    //   <payload: the section header and its lines>
+    // Existing line readers see the frame line as an empty section and skip it.
+    string frameSection(const string& section, const string& date)
+    {
+        size_t start = section.find_first_not_of('\n');
+        string payload = start == string::npos ? string() : section.substr(start);
+        if (!payload.empty() && payload.back() != '\n')
+            payload += '\n';
+
+        char header[64];
+        snprintf(header, sizeof(header), "[FRAME %zu %08x %s]\n", payload.size(), crc32(payload.data(), payload.size()), date.c_str());
+        return "\n" + string(header) + payload;
+    }
+
+    bool commitSection(const string& path, const string& section, const string& date)
+    {
+        return appendText(path, frameSection(section, date));
+    }
+
+    bool makeDirectory(const string& path)
+    {
+#ifdef _WIN32
+        return _mkdir(path.c_str()) == 0 || errno == EEXIST;
+#else
+        return mkdir(path.c_str(), 0755) == 0 || errno == EEXIST;
+#endif
+    }
+
+    // Names of the files in a directory, sorted; empty if it cannot be read
+    vector<string> listFiles(const string& directory)
+    {
+        vector<string> names;
+#ifdef _WIN32
+        WIN32_FIND_DATAA found;
+        HANDLE search = FindFirstFileA((directory + "\\*").c_str(), &found);
+        if (search == INVALID_HANDLE_VALUE)
+            return names;
+        do
+        {
+            if (!(found.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+                names.push_back(found.cFileName);
+        } while (FindNextFileA(search, &found));
+        FindClose(search);
+#else
+        DIR* dir = opendir(directory.c_str());
+        if (!dir)
+            return names;
+        while (dirent* entry = readdir(dir))
+        {
+            if (entry->d_name[0] != '.')
+                names.push_back(entry->d_name);
+        }
+        closedir(dir);
+#endif
+        sort(names.begin(), names.end());
+        return names;
+    }
+
+    // Whole file into memory from resource; stdio is unbuffered so the only
+    // allocation is the string itself
+    pmr::string readAll(const string& path, pmr::memory_resource* resource)
+    {
+        pmr::string content(resource);
+        FILE* file = fopen(path.c_str(), "rb");
+        if (!file)
+            return content;
+        setvbuf(file, nullptr, _IONBF, 0);
+        if (fseek(file, 0, SEEK_END) == 0)
+        {
+            long size = ftell(file);
+            if (size > 0 && fseek(file, 0, SEEK_SET) == 0)
+            {
+                content.resize(static_cast<size_t>(size));
+                content.resize(fread(&content[0], 1, content.size(), file));
+            }
+        }
+        fclose(file);
+        return content;
+    }
+
+    string readAll(const string& path)
+    {
+        ifstream file(path, ios::binary);
+        if (!file.is_open())
+            return string();
+        ostringstream buffer;
+        buffer << file.rdbuf();
+        return buffer.str();
+    }
+
+    long long fileSize(const string& path)
+    {
+        ifstream file(path, ios::binary | ios::ate);
+        if (!file.is_open())
+            return -1;
+        return static_cast<long long>(file.tellg());
+    }
+
+    // Size and modification time; false if the file does not exist
+    bool fileStamp(const string& path, long long& size, long long& modified)
+    {
+        struct stat info;
+        if (stat(path.c_str(), &info) != 0)
+            return false;
+        size = static_cast<long long>(info.st_size);
+        modified = static_cast<long long>(info.st_mtime);
+        return true;
+    }
+
+    string readRange(const string& path, long long offset, long long length)
+    {
+        string data;
+        ifstream file(path, ios::binary);
+        if (!file.is_open() || length <= 0)
+            return data;
+
+        file.seekg(offset);
+        data.resize(static_cast<size_t>(length));
+        file.read(&data[0], length);
+        data.resize(static_cast<size_t>(file.gcount()));
+        return data;
+    }
+
+    // Rename tmpPath over path; readers holding the old file keep a consistent view
+    bool replaceFile(const string& tmpPath, const string& path)
+    {
+#ifdef _WIN32
+        return MoveFileExA(tmpPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+        return rename(tmpPath.c_str(), path.c_str()) == 0;
+#endif
+    }
+
+    // Write a whole file through a temporary and swap it in. Caller holds the lock.
+    bool writeAtomicLocked(const string& path, const string& content)
+    {
+        string tmpPath = path + ".tmp";
+        {
+            ofstream out(tmpPath, ios::binary | ios::trunc);
+            out.write(content.data(), content.size());
+            if (!out)
+                return false;
+        }
+        return replaceFile(tmpPath, path);
+    }
+
+    bool writeAtomic(const string& path, const string& content)
+    {
+        lock_guard<mutex> guard(fileLock(path));
+        return writeAtomicLocked(path, content);
+    }
+
+    // Walk text[begin, limit) without copying it: visitor.section(header,
+    // committed) starts each section and visitor.line(line) reports its lines.
+    // newlines holds the offset of every '\n' in text, so a frame body is
+    // split without rescanning it.
+    template <class Visitor>
+    void walkSectionRange(string_view text, size_t begin, size_t limit, const Scan::Offsets& newlines, string_view committed, Visitor& visitor, size_t* tornFrames)
+    {
+        bool started = false;
+        size_t pos = begin;
+        size_t k = lower_bound(newlines.begin(), newlines.end(), begin) - newlines.begin();
+
+        while (pos < limit)
+        {
+            while (k < newlines.size() && newlines[k] < pos)
+                k++;
+            size_t end = k < newlines.size() ? min(newlines[k], limit) : limit;
+            string_view line = text.substr(pos, end - pos);
+            size_t next = end + 1;
+
+            if (!line.empty() && line.back() == '\r')
+                line.remove_suffix(1);
+
+            if (line.compare(0, 7, "[FRAME ") == 0)
+            {
+                // sscanf needs a terminated copy; frame headers are short
+                char header[64] = "";
+                line.copy(header, min(line.size(), sizeof(header) - 1));
+                size_t length = 0;
+                unsigned int crc = 0;
+                bool valid = sscanf(header, "[FRAME %zu %x", &length, &crc) == 2 && next + length <= limit && crc32(text.data() + next, length) == crc;
+                if (valid)
+                {
+                    char date[16] = "";
+                    sscanf(header, "[FRAME %*u %*x %10[0-9-]", date);
+                    walkSectionRange(text, next, next + length, newlines, string_view(date), visitor, nullptr);
+                    pos = next + length;
+                }
+                else
+                {
+                    if (tornFrames)
+                        (*tornFrames)++;
+                    // Resynchronise on the next frame written after the torn one
+                    size_t resume = text.find("\n[FRAME ", min(next, limit));
+                    pos = resume == string_view::npos || resume >= limit ? limit : resume + 1;
+                }
+                continue;
+            }
+            pos = next;
+
+            if (line.empty())
+                continue;
+
+            if (line[0] == '[')
+            {
+                visitor.section(line, committed);
+                started = true;
+                continue;
+            }
+            if (!started)
+            {
+                visitor.section(string_view(), committed);
+                started = true;
+            }
+            visitor.line(line);
+        }
+    }
+
+    // Walk every section of text, with the newline index taken from resource
+    template <class Visitor>
+    void walkSections(string_view text, Visitor& visitor, pmr::memory_resource* resource = pmr::get_default_resource(), size_t* tornFrames = nullptr)
+    {
+        Scan::Offsets newlines(resource);
+        newlines.reserve(text.size() / 16);
+        Scan::find(text.data(), text.size(), '\n', '\n', newlines);
+        walkSectionRange(text, 0, text.size(), newlines, string_view(), visitor, tornFrames);
+    }
+
+    // Split text into "[...]"-headed sections, skipping blank lines.
+    // Framed sections are checked against their length and checksum; torn or
+    // corrupt frames are dropped and counted in tornFrames.
+    vector<Section> parseSections(const string& text, size_t* tornFrames = nullptr)
+    {
+        struct Collector
+        {
+            vector<Section> sections;
+
+            void section(string_view header, string_view committed)
+            {
+                sections.push_back(Section{ string(header), {}, string(committed) });
+            }
+
+            void line(string_view line)
+            {
+                sections.back().lines.emplace_back(line);
+            }
+        } collector;
+
+        walkSections(text, collector, pmr::get_default_resource(), tornFrames);
+        return collector.sections;
+    }
+
+    // Serialise sections; with keepFrames, committed sections are re-framed
+    string formatSections(const vector<Section>& sections, bool keepFrames = false)
+    {
+        string out;
+        for (size_t i = 0; i < sections.size(); ++i)
+        {
+            if (keepFrames && !sections[i].committed.empty())
+            {
+                string body = sections[i].header + "\n";
+                for (const auto& line : sections[i].lines)
+                {
+                    body += line + "\n";
+                }
+                out += frameSection(body, sections[i].committed);
+                continue;
+            }
+
+            // Dated sections are separated by a blank line, as the writers do
+            if (i > 0 && !sections[i].header.empty() && !sections[i].lines.empty())
+                out += "\n";
+            if (!sections[i].header.empty())
+                out += sections[i].header + "\n";
+            for (const auto& line : sections[i].lines)
+            {
+                out += line + "\n";
+            }
+        }
+        return out;
+    }
+
+    // File contents with only committed sections, for line-by-line readers
+    string readCommitted(const string& path)
+    {
+        return formatSections(parseSections(readAll(path)));
+    }
+}
+
+#endif
@@ -0,0 +1,433 @@
+#ifndef SUMMARY_H
+#define SUMMARY_H
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <set>
+#include <unordered_map>
+#include <algorithm>
+#include <mutex>
+#include <cstdio>
+#include <cstdint>
+#include <limits>
+
+#include "utils.h"
+#include "storage.h"
+#include "schema.h"
+#include "catalog.h"
+#include "attendance_store.h"
+
+using namespace std;
+
+// Scores by assessment type for one subject (the CLASS token of a grades section)
+typedef map<string, int> TypeScores;
+
+// What the progress views and reports print for one student
+struct StudentSummary
+{
+    map<string, TypeScores> subjects;
+    map<string, pair<int, int>> months; // "YYYY-MM" -> (present, recorded)
+
+    // Quiz 30%, midterm 40%, final 30%; missing types count as zero
+    static float weighted(const TypeScores& scores)
+    {
+        const pair<const char*, float> weights[] = { { "quiz", 0.3f }, { "midterm", 0.4f }, { "final", 0.3f } };
+        float total = 0.0f;
+        for (const auto& weight : weights)
+        {
+            auto score = scores.find(weight.first);
+            if (score != scores.end())
+                total += score->second * weight.second;
+        }
+        return total;
+    }
+
+    float average() const
+    {
+        float total = 0.0f;
+        for (const auto& subject : subjects)
+            total += weighted(subject.second);
+        return subjects.empty() ? 0.0f : total / subjects.size();
+    }
+
+    // Present and recorded days in the months lying wholly inside range,
+    // which covers all() and term ranges exactly
+    pair<int, int> attendance(const DateRange& range) const
+    {
+        pair<int, int> total(0, 0);
+        for (const auto& month : months)
+        {
+            DateRange days = DateRange::month(month.first);
+            if (range.contains(days.from) && range.contains(days.to))
+            {
+                total.first += month.second.first;
+                total.second += month.second.second;
+            }
+        }
+        return total;
+    }
+
+    float attendancePercent(const DateRange& range) const
+    {
+        pair<int, int> days = attendance(range);
+        return (days.first * 100.0f) / max(1, days.second);
+    }
+
+    // Overall progress label; empty when there is nothing to judge by
+    string progress() const
+    {
+        if (attendancePercent(DateRange::all()) < 75)
+            return "Needs improvement (Low attendance)";
+        if (subjects.empty())
+            return "";
+        float overall = average();
+        if (overall >= 85)
+            return "Excellent";
+        if (overall >= 70)
+            return "Good";
+        return "Needs improvement";
+    }
+};
+
+// One class's marks for one date
+struct AttendanceSheet
+{
+    string date;
+    string className;
+    vector<AttendanceLine> marks;
+};
+
+// Materialized per-student summaries. Grades and attendance are committed
+// through this store, which updates the students written in the same step, so
+// reading a summary never touches the raw files. The summaries live in
+// summary.txt with the changes since then appended to summary.log:
+//   W|<grades.txt bytes>|<its mtime>|<crc of its last 64 bytes>|<attendance bytes>
+//   G|studentId|subject|type|score
+//   M|studentId|YYYY-MM|present|recorded
+// Every line holds an absolute value, so replaying the log is idempotent. The
+// log is folded into summary.txt once it outgrows it. If the raw files no
+// longer match the last W line (compaction, a closed term, an edit by hand)
+// the summaries are rebuilt from them.
+class SummaryStore
+{
+private:
+    struct Watermark
+    {
+        long long gradeBytes = -1;
+        long long gradeModified = 0;
+        uint32_t gradeTail = 0;
+        long long attendanceBytes = -1;
+
+        bool operator==(const Watermark& other) const
+        {
+            return gradeBytes == other.gradeBytes && gradeModified == other.gradeModified && gradeTail == other.gradeTail && attendanceBytes == other.attendanceBytes;
+        }
+    };
+
+    mutex lock;
+    const string gradesPath = Catalog::path("grades.txt");
+    const string snapshotPath = Catalog::path("summary.txt");
+    const string logPath = Catalog::path("summary.log");
+    unordered_map<string, StudentSummary> students;
+    Watermark mark;
+    bool loaded = false;
+    long long snapshotBytes = 0;
+    long long logBytes = 0;
+
+    Watermark current() const
+    {
+        Watermark w;
+        w.gradeBytes = 0;
+        Storage::fileStamp(gradesPath, w.gradeBytes, w.gradeModified);
+        long long start = max(0LL, w.gradeBytes - 64);
+        string tail = Storage::readRange(gradesPath, start, w.gradeBytes - start);
+        w.gradeTail = Storage::crc32(tail.data(), tail.size());
+        w.attendanceBytes = AttendanceStore::instance().storedBytes();
+        return w;
+    }
+
+    static string markLine(const Watermark& w)
+    {
+        char tail[16];
+        snprintf(tail, sizeof(tail), "%08x", w.gradeTail);
+        return "W|" + to_string(w.gradeBytes) + "|" + to_string(w.gradeModified) + "|" + tail + "|" + to_string(w.attendanceBytes) + "\n";
+    }
+
+    static string gradeLine(const string& id, const string& subject, const string& type, int score)
+    {
+        return "G|" + id + "|" + subject + "|" + type + "|" + to_string(score) + "\n";
+    }
+
+    static string monthLine(const string& id, const string& month, const pair<int, int>& days)
+    {
+        return "M|" + id + "|" + month + "|" + to_string(days.first) + "|" + to_string(days.second) + "\n";
+    }
+
+    void replay(const string& text)
+    {
+        for (const auto& line : Utils::splitString(text, '\n'))
+        {
+            vector<string> parts = Utils::parseRecord(line);
+            if (parts.size() == 5 && parts[0] == "W")
+            {
+                mark.gradeBytes = atoll(parts[1].c_str());
+                mark.gradeModified = atoll(parts[2].c_str());
+                mark.gradeTail = static_cast<uint32_t>(strtoul(parts[3].c_str(), nullptr, 16));
+                mark.attendanceBytes = atoll(parts[4].c_str());
+            }
+            else if (parts.size() == 5 && parts[0] == "G")
+            {
+                students[parts[1]].subjects[parts[2]][parts[3]] = atoi(parts[4].c_str());
+            }
+            else if (parts.size() == 5 && parts[0] == "M")
+            {
+                students[parts[1]].months[parts[2]] = make_pair(atoi(parts[3].c_str()), atoi(parts[4].c_str()));
+            }
+        }
+    }
+
+    // Caller holds the lock
+    void writeSnapshotLocked()
+    {
+        string content = "[STUDENT SUMMARY]\n" + markLine(mark);
+        for (const auto& student : students)
+        {
+            for (const auto& subject : student.second.subjects)
+            {
+                for (const auto& score : subject.second)
+                    content += gradeLine(student.first, subject.first, score.first, score.second);
+            }
+            for (const auto& month : student.second.months)
+                content += monthLine(student.first, month.first, month.second);
+        }
+        if (Storage::writeAtomic(snapshotPath, content) && Storage::writeAtomic(logPath, ""))
+        {
+            snapshotBytes = static_cast<long long>(content.size());
+            logBytes = 0;
+        }
+    }
+
+    // Caller holds the lock
+    void rebuildLocked()
+    {
+        students.clear();
+        forEachGrade(Storage::readAll(gradesPath), [this](string_view id, string_view subject, string_view type, int score)
+            {
+            students[string(id)].subjects[string(subject)][string(type)] = score;
+            });
+        AttendanceStore::instance().scan(DateRange::all(), [this](const AttendanceEntry& e)
+            {
+            pair<int, int>& days = students[e.studentId].months[e.date.substr(0, 7)];
+            days.second++;
+            if (e.present)
+                days.first++;
+            });
+        mark = current();
+        writeSnapshotLocked();
+    }
+
+    // Caller holds the lock. Load once, and rebuild whenever the raw files
+    // changed behind the store's back.
+    void syncLocked()
+    {
+        if (!loaded)
+        {
+            string snapshot = Storage::readAll(snapshotPath);
+            string log = Storage::readAll(logPath);
+            snapshotBytes = static_cast<long long>(snapshot.size());
+            logBytes = static_cast<long long>(log.size());
+            replay(snapshot);
+            replay(log);
+            loaded = true;
+        }
+        if (!(mark == current()))
+            rebuildLocked();
+    }
+
+    // Caller holds the lock; lines are the new absolute values just applied
+    void journalLocked(string lines)
+    {
+        mark = current();
+        lines += markLine(mark);
+        Storage::appendText(logPath, lines);
+        logBytes += static_cast<long long>(lines.size());
+        if (logBytes > max(snapshotBytes, 64LL * 1024))
+            writeSnapshotLocked();
+    }
+
+public:
+    static SummaryStore& instance()
+    {
+        static SummaryStore store;
+        return store;
+    }
+
+    // Visit every score in grades text; later sections overwrite earlier
+    // scores of the same type, so visiting in order leaves the current ones
+    template <class Visit>
+    static void forEachGrade(string_view text, Visit visit)
+    {
+        struct Visitor
+        {
+            Visit& visit;
+            string_view subject;
+            string_view type;
+
+            void section(string_view header, string_view)
+            {
+                // [GRADES <type> CLASS <class> TEACHER <id>]
+                size_t typeStart = header.find("GRADES");
+                size_t classStart = header.find("CLASS");
+                subject = string_view();
+                type = string_view();
+                if (typeStart == string_view::npos || classStart == string_view::npos)
+                    return;
+                typeStart += 7;
+                classStart += 6;
+                type = header.substr(typeStart, header.find(' ', typeStart) - typeStart);
+                subject = header.substr(classStart, header.find(' ', classStart) - classStart);
+            }
+
+            void line(string_view line)
+            {
+                GradeView grade;
+                if (!type.empty() && Schema::parseLine(line, grade))
+                    visit(grade.studentId, subject, type, grade.score);
+            }
+        } visitor{ visit, string_view(), string_view() };
+
+        Storage::walkSections(text, visitor);
+    }
+
+    // Append one class's grades for an assessment and update those students
+    bool commitGrades(const string& subject, const string& type, const string& teacherId, const vector<GradeLine>& grades)
+    {
+        string section = "\n[GRADES " + type + " CLASS " + subject + " TEACHER " + teacherId + "]\n";
+        for (const auto& grade : grades)
+            section += Schema::toLine(grade) + "\n";
+
+        lock_guard<mutex> guard(lock);
+        syncLocked();
+        if (!Storage::commitSection(gradesPath, section, Utils::getCurrentDate()))
+            return false;
+
+        string lines;
+        for (const auto& grade : grades)
+        {
+            students[grade.studentId].subjects[subject][type] = grade.score;
+            lines += gradeLine(grade.studentId, subject, type, grade.score);
+        }
+        journalLocked(lines);
+        return true;
+    }
+
+    // Commit one class's attendance for a date and update those students
+    bool commitAttendance(const string& date, const string& className, const vector<AttendanceLine>& marks)
+    {
+        return commitAttendance(vector<AttendanceSheet>{ AttendanceSheet{ date, className, marks } });
+    }
+
+    // Commit several classes and dates at once, one section each
+    bool commitAttendance(const vector<AttendanceSheet>& sheets)
+    {
+        vector<AttendanceSection> sections;
+        sections.reserve(sheets.size());
+        for (const auto& sheet : sheets)
+        {
+            string section = "\n[ATTENDANCE " + sheet.date + " CLASS " + sheet.className + "]\n";
+            for (const auto& mark : sheet.marks)
+                section += Schema::toLine(mark) + "\n";
+            sections.push_back(AttendanceSection{ sheet.date, section });
+        }
+
+        lock_guard<mutex> guard(lock);
+        syncLocked();
+
+        // A sheet replaces whatever was stored for its class and date, so
+        // those marks come off the summaries before the new ones go on
+        map<pair<string, string>, vector<AttendanceLine>> replaced;
+        DateRange touched{ numeric_limits<long>::max(), numeric_limits<long>::min() };
+        for (const auto& sheet : sheets)
+        {
+            replaced[make_pair(sheet.date, sheet.className)];
+            long day = Utils::dateToDays(sheet.date);
+            touched.from = min(touched.from, day);
+            touched.to = max(touched.to, day);
+        }
+        AttendanceStore::instance().scan(touched, [&](const AttendanceEntry& e)
+            {
+            auto found = replaced.find(make_pair(e.date, e.className));
+            if (found != replaced.end())
+                found->second.push_back(AttendanceLine{ e.studentId, e.present ? "Present" : "Absent" });
+            });
+
+        if (!AttendanceStore::instance().commit(sections))
+            return false;
+
+        auto apply = [this](const string& studentId, const string& month, const string& status, int sign)
+            {
+            pair<int, int>& days = students[studentId].months[month];
+            days.second += sign;
+            if (status == "Present")
+                days.first += sign;
+            };
+
+        set<pair<string, string>> changed;
+        for (const auto& sheet : sheets)
+        {
+            string month = sheet.date.substr(0, 7);
+            vector<AttendanceLine>& previous = replaced[make_pair(sheet.date, sheet.className)];
+            for (const auto& mark : previous)
+            {
+                apply(mark.studentId, month, mark.status, -1);
+                changed.insert(make_pair(mark.studentId, month));
+            }
+            for (const auto& mark : sheet.marks)
+            {
+                apply(mark.studentId, month, mark.status, 1);
+                changed.insert(make_pair(mark.studentId, month));
+            }
+            // A later sheet for the same class and date replaces this one
+            previous = sheet.marks;
+        }
+
+        string lines;
+        for (const auto& item : changed)
+            lines += monthLine(item.first, item.second, students[item.first].months[item.second]);
+        journalLocked(lines);
+        return true;
+    }
+
+    // Visit every student's summary in ID order while holding the store
+    template <class Visit>
+    void forEach(Visit visit)
+    {
+        lock_guard<mutex> guard(lock);
+        syncLocked();
+        vector<const pair<const string, StudentSummary>*> ordered;
+        ordered.reserve(students.size());
+        for (const auto& student : students)
+            ordered.push_back(&student);
+        sort(ordered.begin(), ordered.end(), [](const pair<const string, StudentSummary>* a, const pair<const string, StudentSummary>* b)
+            {
+            return a->first < b->first;
+            });
+        for (const auto* student : ordered)
+            visit(student->first, student->second);
+    }
+
+    // Copy of a student's summary; empty if nothing was recorded for them
+    StudentSummary get(const string& studentId)
+    {
+        lock_guard<mutex> guard(lock);
+        syncLocked();
+        auto found = students.find(studentId);
+        return found == students.end() ? StudentSummary() : found->second;
+    }
+};
+
+#endif
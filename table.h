@@ -0,0 +1,216 @@
+#ifndef TABLE_H
+#define TABLE_H
+
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <algorithm>
+#include <charconv>
+#include <type_traits>
+#include <cstdio>
+
+using namespace std;
+
+// Console tables. Cell text goes into one buffer as rows are added, column
+// widths are worked out once after the last row, and render() formats the
+// whole table into a single string sized up front. print() hands that string
+// to the stream in one write instead of a setw/<< chain per cell.
+class ConsoleTable
+{
+public:
+    enum Align { Left, Right };
+
+private:
+    struct Column
+    {
+        string title;
+        size_t width; // minimum, including the gap to the next column
+        Align align;
+    };
+
+    struct Cell
+    {
+        size_t start; // into text
+        size_t length;
+    };
+
+    vector<Column> columns;
+    vector<Cell> cells; // row after row, one per column
+    string text;
+    size_t gap = 1;
+    size_t ruleWidth = 0;
+    bool underline = false;
+
+    string_view cellText(size_t row, size_t column) const
+    {
+        size_t index = row * columns.size() + column;
+        if (index >= cells.size())
+            return string_view();
+        return string_view(text).substr(cells[index].start, cells[index].length);
+    }
+
+    vector<size_t> widths() const
+    {
+        vector<size_t> result;
+        for (size_t c = 0; c < columns.size(); ++c)
+        {
+            size_t longest = columns[c].title.size();
+            for (size_t r = 0; r < rows(); ++r)
+            {
+                longest = max(longest, cellText(r, c).size());
+            }
+            result.push_back(max(columns[c].width, longest + gap));
+        }
+        return result;
+    }
+
+    // Trailing padding of a left-aligned last column is left out
+    static void appendCell(string& out, string_view value, size_t width, Align align, bool last)
+    {
+        size_t padding = width > value.size() ? width - value.size() : 0;
+        if (align == Right)
+            out.append(padding, ' ');
+        out.append(value.data(), value.size());
+        if (align == Left && !last)
+            out.append(padding, ' ');
+    }
+
+public:
+    ConsoleTable& column(const string& title, size_t width = 0, Align align = Left)
+    {
+        columns.push_back(Column{ title, width, align });
+        return *this;
+    }
+
+    // Dashed lines above and below the header and after the last row, as
+    // wide as the table but at least width characters
+    ConsoleTable& rules(size_t width)
+    {
+        ruleWidth = max<size_t>(width, 1);
+        return *this;
+    }
+
+    // Dashes under each column title and spaces columns apart
+    ConsoleTable& underlined(size_t spacing = 2)
+    {
+        underline = true;
+        gap = spacing;
+        return *this;
+    }
+
+    // Cells fill the current row left to right and wrap to the next one
+    ConsoleTable& cell(string_view value)
+    {
+        cells.push_back(Cell{ text.size(), value.size() });
+        text.append(value.data(), value.size());
+        return *this;
+    }
+
+    ConsoleTable& cell(const char* value)
+    {
+        return cell(string_view(value));
+    }
+
+    ConsoleTable& cell(const string& value)
+    {
+        return cell(string_view(value));
+    }
+
+    template <class Integer, typename enable_if<is_integral<Integer>::value, int>::type = 0>
+    ConsoleTable& cell(Integer value)
+    {
+        char buffer[24];
+        to_chars_result result = to_chars(buffer, buffer + sizeof(buffer), value);
+        return cell(string_view(buffer, result.ptr - buffer));
+    }
+
+    ConsoleTable& cell(double value, int precision)
+    {
+        size_t start = text.size();
+        appendFixed(text, value, precision);
+        cells.push_back(Cell{ start, text.size() - start });
+        return *this;
+    }
+
+    // Append value with a fixed number of decimals, as fixed << setprecision would
+    static void appendFixed(string& out, double value, int precision)
+    {
+        char buffer[64];
+        int length = snprintf(buffer, sizeof(buffer), "%.*f", precision, value);
+        if (length > 0)
+            out.append(buffer, min<size_t>(length, sizeof(buffer) - 1));
+    }
+
+    size_t rows() const
+    {
+        return columns.empty() ? 0 : (cells.size() + columns.size() - 1) / columns.size();
+    }
+
+    bool empty() const
+    {
+        return cells.empty();
+    }
+
+    // Append the formatted table to out
+    void render(string& out) const
+    {
+        vector<size_t> width = widths();
+        size_t lineWidth = 0;
+        for (size_t w : width)
+            lineWidth += w;
+        size_t ruleLength = ruleWidth ? max(ruleWidth, lineWidth) : 0;
+
+        out.reserve(out.size() + (rows() + 2) * (lineWidth + 1) + 3 * (ruleLength + 1));
+
+        auto rule = [&]()
+            {
+            if (ruleLength)
+            {
+                out.append(ruleLength, '-');
+                out += '\n';
+            }
+            };
+
+        rule();
+        for (size_t c = 0; c < columns.size(); ++c)
+        {
+            appendCell(out, columns[c].title, width[c], columns[c].align, c + 1 == columns.size());
+        }
+        out += '\n';
+        if (underline)
+        {
+            // The gap sits on the side the column is padded on
+            for (size_t c = 0; c < columns.size(); ++c)
+            {
+                if (columns[c].align == Right)
+                    out.append(gap, ' ');
+                out.append(width[c] - gap, '-');
+                if (columns[c].align == Left && c + 1 < columns.size())
+                    out.append(gap, ' ');
+            }
+            out += '\n';
+        }
+        rule();
+
+        for (size_t r = 0; r < rows(); ++r)
+        {
+            for (size_t c = 0; c < columns.size(); ++c)
+            {
+                appendCell(out, cellText(r, c), width[c], columns[c].align, c + 1 == columns.size());
+            }
+            out += '\n';
+        }
+        if (rows() > 0)
+            rule();
+    }
+
+    void print(ostream& stream = cout) const
+    {
+        string out;
+        render(out);
+        stream.write(out.data(), out.size());
+    }
+};
+
+#endif
@@ -0,0 +1,464 @@
+#ifndef TERM_ARCHIVE_H
+#define TERM_ARCHIVE_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <sstream>
+#include <cstring>
+#include <cstdint>
+
+#include "utils.h"
+#include "storage.h"
+#include "catalog.h"
+#include "compaction.h"
+#include "attendance_store.h"
+
+using namespace std;
+
+// Small LZ77 block codec. Each block is a series of
+//   <literal count varint> <literals> <match length varint> [<offset u16>]
+// ending with a zero match length.
+namespace Lz
+{
+    void putVarint(string& out, size_t value)
+    {
+        while (value >= 0x80)
+        {
+            out += static_cast<char>((value & 0x7F) | 0x80);
+            value >>= 7;
+        }
+        out += static_cast<char>(value);
+    }
+
+    bool getVarint(const string& in, size_t& pos, size_t& value)
+    {
+        value = 0;
+        for (int shift = 0; pos < in.size() && shift < 64; shift += 7)
+        {
+            unsigned char byte = static_cast<unsigned char>(in[pos++]);
+            value |= static_cast<size_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80))
+                return true;
+        }
+        return false;
+    }
+
+    string compress(const string& in)
+    {
+        const size_t minMatch = 4;
+        const size_t window = 65535;
+        vector<long> table(1 << 15, -1);
+        string out;
+        size_t pos = 0, anchor = 0;
+
+        auto hashAt = [&in](size_t p)
+            {
+            uint32_t seq;
+            memcpy(&seq, in.data() + p, sizeof(seq));
+            return (seq * 2654435761u) >> 17;
+            };
+
+        while (pos + minMatch <= in.size())
+        {
+            uint32_t h = hashAt(pos);
+            long candidate = table[h];
+            table[h] = static_cast<long>(pos);
+
+            if (candidate >= 0 && pos - candidate <= window && memcmp(in.data() + candidate, in.data() + pos, minMatch) == 0)
+            {
+                size_t length = minMatch;
+                while (pos + length < in.size() && in[candidate + length] == in[pos + length])
+                    length++;
+
+                putVarint(out, pos - anchor);
+                out.append(in, anchor, pos - anchor);
+                putVarint(out, length);
+                size_t offset = pos - candidate;
+                out += static_cast<char>(offset & 0xFF);
+                out += static_cast<char>(offset >> 8);
+
+                // Seed the table inside the match so later repeats are found
+                for (size_t p = pos + 1; p < pos + length && p + minMatch <= in.size(); p += 2)
+                    table[hashAt(p)] = static_cast<long>(p);
+                pos += length;
+                anchor = pos;
+            }
+            else
+            {
+                pos++;
+            }
+        }
+
+        putVarint(out, in.size() - anchor);
+        out.append(in, anchor, in.size() - anchor);
+        putVarint(out, 0);
+        return out;
+    }
+
+    bool decompress(const string& in, size_t rawSize, string& out)
+    {
+        out.clear();
+        out.reserve(rawSize);
+        size_t pos = 0;
+
+        while (true)
+        {
+            size_t literals, length;
+            if (!getVarint(in, pos, literals) || pos + literals > in.size())
+                return false;
+            out.append(in, pos, literals);
+            pos += literals;
+
+            if (!getVarint(in, pos, length))
+                return false;
+            if (length == 0)
+                break;
+            if (pos + 2 > in.size())
+                return false;
+            size_t offset = static_cast<unsigned char>(in[pos]) | (static_cast<unsigned char>(in[pos + 1]) << 8);
+            pos += 2;
+            if (offset == 0 || offset > out.size())
+                return false;
+
+            // Byte by byte: matches may overlap their own output
+            size_t from = out.size() - offset;
+            for (size_t i = 0; i < length; ++i)
+                out += out[from + i];
+        }
+        return out.size() == rawSize;
+    }
+}
+
+// Read-only archive of a closed term under archive/:
+//   <term>.lmsa  compressed blocks of grade, attendance and report sections
+//   <term>.idx   B|block|offset|compressed|raw  and  S|studentId|block,block,...
+// A student's history only decompresses the blocks listed for that student.
+class TermArchive
+{
+private:
+    struct Block
+    {
+        long long offset = 0;
+        size_t compressed = 0;
+        size_t raw = 0;
+    };
+
+    string term;
+    vector<Block> blocks;
+    map<string, vector<size_t>> studentBlocks;
+
+    static const size_t blockSize = 64 * 1024;
+
+    string dataName() const
+    {
+        return "archive/" + term + ".lmsa";
+    }
+
+    string indexName() const
+    {
+        return "archive/" + term + ".idx";
+    }
+
+    string dataPath() const
+    {
+        return Catalog::path(dataName());
+    }
+
+    string indexPath() const
+    {
+        return Catalog::path(indexName());
+    }
+
+    // Student ids appearing in a grade, attendance or report section
+    static set<string> studentsIn(const Storage::Section& section)
+    {
+        set<string> ids;
+        for (const auto& line : section.lines)
+        {
+            if (section.header.compare(0, 8, "[GRADES ") == 0)
+            {
+                ids.insert(Utils::parseRecord(line)[0]);
+            }
+            else if (section.header.compare(0, 12, "[ATTENDANCE ") == 0)
+            {
+                ids.insert(Utils::parseRecord(line.substr(0, line.find(':')))[0]);
+            }
+            else if (line.compare(0, 9, "STUDENT: ") == 0)
+            {
+                size_t open = line.rfind('(');
+                size_t close = line.rfind(')');
+                if (open != string::npos && close != string::npos && close > open)
+                    ids.insert(line.substr(open + 1, close - open - 1));
+            }
+        }
+        return ids;
+    }
+
+    bool readBlock(size_t block, string& raw) const
+    {
+        const Block& b = blocks[block];
+        string compressed = Storage::readRange(dataPath(), b.offset, static_cast<long long>(b.compressed));
+        return compressed.size() == b.compressed && Lz::decompress(compressed, b.raw, raw);
+    }
+
+public:
+    explicit TermArchive(const string& termName) : term(termName) {}
+
+    bool exists() const
+    {
+        return Storage::fileSize(indexPath()) >= 0;
+    }
+
+    // Fails if the archive or its index changed since it was written
+    bool load()
+    {
+        blocks.clear();
+        studentBlocks.clear();
+        if (!Catalog::verify(dataName()) || !Catalog::verify(indexName()))
+        {
+            cerr << "Archive for " << term << " does not match the data catalog; not loading it." << endl;
+            return false;
+        }
+        ifstream file(indexPath());
+        string line;
+
+        while (getline(file, line))
+        {
+            vector<string> parts = Utils::parseRecord(line);
+            if (parts.size() == 5 && parts[0] == "B")
+            {
+                blocks.push_back(Block{ stoll(parts[2]), stoul(parts[3]), stoul(parts[4]) });
+            }
+            else if (parts.size() == 3 && parts[0] == "S")
+            {
+                for (const auto& b : Utils::splitString(parts[2], ','))
+                    studentBlocks[parts[1]].push_back(stoul(b));
+            }
+        }
+        return !blocks.empty();
+    }
+
+    // Every archived section, decompressing all blocks
+    vector<Storage::Section> allSections() const
+    {
+        vector<Storage::Section> sections;
+        for (size_t b = 0; b < blocks.size(); ++b)
+        {
+            string raw;
+            if (!readBlock(b, raw))
+                continue;
+            for (auto& section : Storage::parseSections(raw))
+                sections.push_back(section);
+        }
+        return sections;
+    }
+
+    // Sections that mention the student, decompressing only their blocks
+    vector<Storage::Section> studentSections(const string& studentId) const
+    {
+        vector<Storage::Section> sections;
+        auto it = studentBlocks.find(studentId);
+        if (it == studentBlocks.end())
+            return sections;
+
+        for (size_t b : it->second)
+        {
+            string raw;
+            if (b >= blocks.size() || !readBlock(b, raw))
+                continue;
+            for (auto& section : Storage::parseSections(raw))
+            {
+                if (studentsIn(section).count(studentId))
+                    sections.push_back(section);
+            }
+        }
+        return sections;
+    }
+
+    // Write the archive from scratch; sections already in it should be included
+    bool write(const vector<Storage::Section>& sections)
+    {
+        Catalog::subdirectory("archive");
+        blocks.clear();
+        studentBlocks.clear();
+
+        string data;
+        string raw;
+        set<string> blockStudents;
+
+        auto flush = [&]()
+            {
+            if (raw.empty())
+                return;
+            string compressed = Lz::compress(raw);
+            blocks.push_back(Block{ static_cast<long long>(data.size()), compressed.size(), raw.size() });
+            data += compressed;
+            for (const auto& id : blockStudents)
+                studentBlocks[id].push_back(blocks.size() - 1);
+            raw.clear();
+            blockStudents.clear();
+            };
+
+        for (const auto& section : sections)
+        {
+            raw += Storage::formatSections({ section }, true);
+            set<string> ids = studentsIn(section);
+            blockStudents.insert(ids.begin(), ids.end());
+            if (raw.size() >= blockSize)
+                flush();
+        }
+        flush();
+
+        ostringstream index;
+        for (size_t b = 0; b < blocks.size(); ++b)
+        {
+            index << "B|" << b << "|" << blocks[b].offset << "|" << blocks[b].compressed << "|" << blocks[b].raw << "\n";
+        }
+        for (const auto& student : studentBlocks)
+        {
+            vector<string> ids;
+            for (size_t b : student.second)
+                ids.push_back(to_string(b));
+            index << "S|" << student.first << "|" << Utils::joinString(ids, ",") << "\n";
+        }
+
+        string indexText = index.str();
+        if (!Storage::writeAtomic(dataPath(), data) || !Storage::writeAtomic(indexPath(), indexText))
+            return false;
+        Catalog::record(dataName(), data);
+        Catalog::record(indexName(), indexText);
+        return true;
+    }
+
+    // Print one student's grades, attendance and report from the archive
+    bool printStudent(const string& studentId) const
+    {
+        vector<Storage::Section> sections = studentSections(studentId);
+        if (sections.empty())
+            return false;
+
+        int present = 0, total = 0;
+        cout << "\nArchived records for " << studentId << " (" << term << "):\n";
+        for (const auto& section : sections)
+        {
+            if (section.header.compare(0, 8, "[GRADES ") == 0)
+            {
+                for (const auto& line : section.lines)
+                {
+                    vector<string> parts = Utils::parseRecord(line);
+                    if (parts.size() >= 2 && parts[0] == studentId)
+                        cout << "Grade " << section.header.substr(8, section.header.size() - 9) << ": " << parts[1] << "\n";
+                }
+            }
+            else if (section.header.compare(0, 12, "[ATTENDANCE ") == 0)
+            {
+                for (const auto& line : section.lines)
+                {
+                    vector<string> parts = Utils::parseRecord(line.substr(0, line.find(':')));
+                    if (parts[0] == studentId)
+                    {
+                        total++;
+                        if (line.find("Present") != string::npos)
+                            present++;
+                    }
+                }
+            }
+            else
+            {
+                bool inBlock = false;
+                for (const auto& line : section.lines)
+                {
+                    if (line.compare(0, 9, "STUDENT: ") == 0)
+                        inBlock = line.find("(" + studentId + ")") != string::npos;
+                    if (inBlock)
+                        cout << line << "\n";
+                }
+            }
+        }
+        cout << "Attendance: " << present << "/" << total << " days present\n";
+        return true;
+    }
+
+    long long archiveBytes() const
+    {
+        return Storage::fileSize(dataPath());
+    }
+
+    struct CloseResult
+    {
+        size_t sections = 0;
+        long long liveBytesFreed = 0;
+        long long rawBytes = 0;
+        long long archiveBytes = 0;
+        bool unreadableArchive = false;   // an existing archive did not load; nothing was changed
+    };
+
+    // Move a finished term out of the live files. Grade sections are matched by
+    // their commit date; unframed grade sections predate commit dates and go to
+    // the first term that is closed. The archive is written before anything is
+    // removed, and closing the same term again merges into the existing archive.
+    // An existing archive that does not load is left alone, as are the live
+    // files, since rewriting it would lose what it holds.
+    static bool closeTerm(const string& termName, CloseResult& result)
+    {
+        DateRange range = DateRange::term(termName);
+        if (range.from == DateRange::all().from)
+            return false;
+
+        auto isTermGrades = [&range](const Storage::Section& s)
+            {
+            return s.header.compare(0, 8, "[GRADES ") == 0 && (s.committed.empty() || range.contains(Utils::dateToDays(s.committed)));
+            };
+        auto isTermReport = [&termName](const Storage::Section& s)
+            {
+            string prefix = "[TERM REPORTS " + termName + " CLASS ";
+            return s.header.compare(0, prefix.size(), prefix) == 0;
+            };
+
+        TermArchive archive(termName);
+        vector<Storage::Section> sections;
+        if (archive.exists())
+        {
+            if (!archive.load())
+            {
+                result.unreadableArchive = true;
+                return false;
+            }
+            sections = archive.allSections();
+        }
+
+        for (const auto& s : Storage::parseSections(Storage::readAll(Catalog::path("termReports.txt"))))
+        {
+            if (isTermReport(s))
+                sections.push_back(s);
+        }
+        for (const auto& s : Storage::parseSections(Storage::readAll(Catalog::path("grades.txt"))))
+        {
+            if (isTermGrades(s))
+                sections.push_back(s);
+        }
+        vector<Storage::Section> attendance = AttendanceStore::instance().sealedSections(range);
+        sections.insert(sections.end(), attendance.begin(), attendance.end());
+
+        result.sections = sections.size();
+        if (sections.empty())
+            return true;
+
+        for (const auto& s : sections)
+            result.rawBytes += static_cast<long long>(Storage::formatSections({ s }, true).size());
+        if (!archive.write(sections))
+            return false;
+        result.archiveBytes = archive.archiveBytes();
+
+        CompactionResult reports = Compactor::removeSections(Catalog::path("termReports.txt"), isTermReport);
+        CompactionResult grades = Compactor::removeSections(Catalog::path("grades.txt"), isTermGrades);
+        result.liveBytesFreed = (reports.bytesBefore - reports.bytesAfter) + (grades.bytesBefore - grades.bytesAfter);
+        result.liveBytesFreed += AttendanceStore::instance().dropSealed(range);
+        return true;
+    }
+};
+
+#endif
@@ -0,0 +1,545 @@
+#ifndef TIMETABLE_H
+#define TIMETABLE_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <algorithm>
+#include <random>
+#include <future>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#include "utils.h"
+#include "storage.h"
+#include "catalog.h"
+#include "records.h"
+#include "table.h"
+#include "occupancy.h"
+
+using namespace std;
+
+struct TimetablePlan
+{
+    vector<string> rows;        // Day|Period|TeacherId|Class|Room, by slot then class
+    vector<string> problems;    // why no timetable could be built
+    size_t lessons = 0;
+    size_t teachers = 0;
+    size_t classes = 0;
+    size_t rooms = 0;           // specialist rooms from rooms.txt
+    size_t attempts = 0;
+    double millis = 0.0;
+    bool solved = false;
+};
+
+// Weekly timetable from the teacher records. Each teacher's periodsPerWeek is
+// spread as evenly as possible over their assigned classes, so every class
+// sees each of its teachers (and their subject) at least once. A lesson is
+// held in the class's own room unless rooms.txt lists specialist rooms for
+// the teacher's first subject:
+//   Lab-1|Chemistry,Physics
+// Bookings live in an OccupancyGrid, so the slots still open to a
+// teacher-class pair are a few ANDs. Search places the
+// pair with the least slack first, checks after every placement that the
+// pairs sharing its teacher, class or rooms can still fit their remaining
+// lessons, and backtracks otherwise. Each lesson pair is also held to
+// ceil(lessons / days) per day so lessons spread over the week. Every worker
+// thread runs randomized restarts from its own seed; the first complete
+// timetable wins.
+class TimetableSolver
+{
+private:
+    struct Pair
+    {
+        uint32_t teacher;
+        uint32_t classIndex;
+        int group;              // specialist room group, -1 for the class's own room
+        int lessons;
+        int perDay;
+    };
+
+    struct Placement
+    {
+        uint32_t pair;
+        int slot;
+        int room;               // index into rooms, -1 for the class's own room
+    };
+
+    struct Problem
+    {
+        int days = 5;
+        int periods = 8;
+        vector<string> teacherIds;
+        vector<string> classNames;
+        vector<string> rooms;
+        vector<vector<int>> groups;             // room indexes per group
+        vector<Pair> pairs;
+        vector<vector<uint32_t>> byTeacher;     // pairs per teacher, class and group
+        vector<vector<uint32_t>> byClass;
+        vector<vector<uint32_t>> byGroup;
+        size_t lessons = 0;
+    };
+
+    // Bookings of one search attempt
+    struct State
+    {
+        const Problem& problem;
+        OccupancyGrid grid;
+        vector<int> remaining;                  // per pair
+        vector<int> teacherLeft;
+        vector<int> classLeft;
+        vector<int> groupLeft;
+        vector<int> dayCount;                   // pair * days + day
+        vector<uint32_t> tieBreak;
+        vector<Placement> placed;
+        mt19937 random;
+        size_t backtracks = 0;
+        size_t budget = 0;
+        chrono::steady_clock::time_point deadline;
+
+        State(const Problem& p, uint32_t seed) : problem(p), grid(p.days, p.periods), random(seed) {}
+
+        void reset()
+        {
+            grid.reset(SlotOwner::Teacher, problem.teacherIds.size());
+            grid.reset(SlotOwner::Class, problem.classNames.size());
+            grid.reset(SlotOwner::Room, problem.rooms.size());
+            remaining.assign(problem.pairs.size(), 0);
+            teacherLeft.assign(problem.teacherIds.size(), 0);
+            classLeft.assign(problem.classNames.size(), 0);
+            groupLeft.assign(problem.groups.size(), 0);
+            dayCount.assign(problem.pairs.size() * problem.days, 0);
+            tieBreak.resize(problem.pairs.size());
+            for (size_t i = 0; i < problem.pairs.size(); ++i)
+            {
+                const Pair& pair = problem.pairs[i];
+                remaining[i] = pair.lessons;
+                teacherLeft[pair.teacher] += pair.lessons;
+                classLeft[pair.classIndex] += pair.lessons;
+                if (pair.group >= 0)
+                    groupLeft[pair.group] += pair.lessons;
+                tieBreak[i] = random();
+            }
+            placed.clear();
+            backtracks = 0;
+        }
+
+        SlotMask roomsFree(int group) const
+        {
+            if (group < 0)
+                return ~SlotMask(0);
+            SlotMask free = 0;
+            for (int room : problem.groups[group])
+                free |= grid.open(SlotOwner::Room, room);
+            return free;
+        }
+
+        // Slots where another lesson of the pair could go right now
+        SlotMask domain(uint32_t index) const
+        {
+            const Pair& pair = problem.pairs[index];
+            SlotMask free = grid.open(SlotOwner::Teacher, pair.teacher) & grid.open(SlotOwner::Class, pair.classIndex) & roomsFree(pair.group);
+            const int* days = &dayCount[index * problem.days];
+            for (int day = 0; day < problem.days; ++day)
+            {
+                if (days[day] >= pair.perDay)
+                    free &= ~grid.day(day);
+            }
+            return free;
+        }
+
+        bool fits(const vector<uint32_t>& pairs) const
+        {
+            for (uint32_t index : pairs)
+            {
+                if (remaining[index] > 0 && OccupancyGrid::count(domain(index)) < remaining[index])
+                    return false;
+            }
+            return true;
+        }
+
+        // Everything sharing the last placement's teacher, class or rooms can still be placed
+        bool consistent(uint32_t index) const
+        {
+            const Pair& pair = problem.pairs[index];
+            if (OccupancyGrid::count(grid.open(SlotOwner::Teacher, pair.teacher)) < teacherLeft[pair.teacher])
+                return false;
+            if (OccupancyGrid::count(grid.open(SlotOwner::Class, pair.classIndex)) < classLeft[pair.classIndex])
+                return false;
+            if (!fits(problem.byTeacher[pair.teacher]) || !fits(problem.byClass[pair.classIndex]))
+                return false;
+            if (pair.group < 0)
+                return true;
+            int roomSlots = 0;
+            for (int room : problem.groups[pair.group])
+                roomSlots += OccupancyGrid::count(grid.open(SlotOwner::Room, room));
+            return roomSlots >= groupLeft[pair.group] && fits(problem.byGroup[pair.group]);
+        }
+
+        void book(const Placement& p, bool on)
+        {
+            const Pair& pair = problem.pairs[p.pair];
+            int step = on ? 1 : -1;
+            if (on)
+            {
+                grid.book(SlotOwner::Teacher, pair.teacher, p.slot);
+                grid.book(SlotOwner::Class, pair.classIndex, p.slot);
+                if (p.room >= 0)
+                    grid.book(SlotOwner::Room, p.room, p.slot);
+            }
+            else
+            {
+                grid.release(SlotOwner::Teacher, pair.teacher, p.slot);
+                grid.release(SlotOwner::Class, pair.classIndex, p.slot);
+                if (p.room >= 0)
+                    grid.release(SlotOwner::Room, p.room, p.slot);
+            }
+            remaining[p.pair] -= step;
+            teacherLeft[pair.teacher] -= step;
+            classLeft[pair.classIndex] -= step;
+            if (pair.group >= 0)
+                groupLeft[pair.group] -= step;
+            dayCount[p.pair * problem.days + p.slot / problem.periods] += step;
+        }
+
+        // Pair with the fewest spare slots, or -1 once all lessons are placed
+        int choose(SlotMask& options)
+        {
+            int best = -1;
+            int bestSlack = 0;
+            for (size_t i = 0; i < problem.pairs.size(); ++i)
+            {
+                if (remaining[i] == 0)
+                    continue;
+                SlotMask free = domain(static_cast<uint32_t>(i));
+                int slack = OccupancyGrid::count(free) - remaining[i];
+                if (best < 0 || slack < bestSlack || (slack == bestSlack && tieBreak[i] < tieBreak[best]))
+                {
+                    best = static_cast<int>(i);
+                    bestSlack = slack;
+                    options = free;
+                }
+            }
+            return best;
+        }
+
+        int pickRoom(int group, int slot)
+        {
+            if (group < 0)
+                return -1;
+            const vector<int>& rooms = problem.groups[group];
+            size_t start = random() % rooms.size();
+            for (size_t i = 0; i < rooms.size(); ++i)
+            {
+                int room = rooms[(start + i) % rooms.size()];
+                if (grid.isFree(SlotOwner::Room, room, slot))
+                    return room;
+            }
+            return -1;
+        }
+
+        // Open slots of a pair, least wanted by its neighbours first: each
+        // neighbour with the slot still open adds more the less slack it has
+        int order(uint32_t index, SlotMask options, int* slots)
+        {
+            const Pair& pair = problem.pairs[index];
+            float cost[64] = {};
+            auto weigh = [&](const vector<uint32_t>& pairs)
+                {
+                for (uint32_t other : pairs)
+                {
+                    if (other == index || remaining[other] == 0)
+                        continue;
+                    SlotMask open = domain(other) & options;
+                    float weight = 1.0f / (OccupancyGrid::count(open) - remaining[other] + 1.5f);
+                    for (; open != 0; open &= open - 1)
+                        cost[OccupancyGrid::lowest(open)] += weight;
+                }
+                };
+            weigh(problem.byTeacher[pair.teacher]);
+            weigh(problem.byClass[pair.classIndex]);
+            if (pair.group >= 0)
+                weigh(problem.byGroup[pair.group]);
+
+            int count = 0;
+            for (; options != 0; options &= options - 1)
+            {
+                int slot = OccupancyGrid::lowest(options);
+                cost[slot] += (random() & 0xff) / 1024.0f; // random tie break
+                slots[count++] = slot;
+            }
+            sort(slots, slots + count, [&cost](int a, int b)
+                {
+                return cost[a] < cost[b];
+                });
+            return count;
+        }
+
+        bool search(const atomic<bool>& stop)
+        {
+            SlotMask options = 0;
+            int index = choose(options);
+            if (index < 0)
+                return true;
+
+            const Pair& pair = problem.pairs[index];
+            int slots[64];
+            int count = order(static_cast<uint32_t>(index), options, slots);
+            for (int i = 0; i < count && backtracks < budget && !stop.load(memory_order_relaxed); ++i)
+            {
+                int slot = slots[i];
+                Placement p{ static_cast<uint32_t>(index), slot, pickRoom(pair.group, slot) };
+                book(p, true);
+                placed.push_back(p);
+                if (consistent(p.pair) && search(stop))
+                    return true;
+                placed.pop_back();
+                book(p, false);
+                if (++backtracks % 1024 == 0 && chrono::steady_clock::now() >= deadline)
+                    budget = backtracks;
+            }
+            return false;
+        }
+    };
+
+    // rooms.txt: room|subject,subject; missing or empty means every class keeps its own room
+    static map<string, vector<string>> loadRooms()
+    {
+        map<string, vector<string>> bySubject;
+        for (const auto& line : Utils::splitString(Storage::readAll(Catalog::path("rooms.txt")), '\n'))
+        {
+            if (line.empty() || line[0] == '[')
+                continue;
+            vector<string> parts = Utils::parseRecord(line);
+            if (parts.size() < 2)
+                continue;
+            for (const auto& subject : Utils::splitString(parts[1], ','))
+                bySubject[Utils::toLower(subject)].push_back(parts[0]);
+        }
+        return bySubject;
+    }
+
+    static bool build(const vector<TeacherRecord>& teachers, int days, int periods, Problem& problem, TimetablePlan& plan)
+    {
+        problem.days = days;
+        problem.periods = periods;
+        int slots = days * periods;
+
+        map<string, vector<string>> roomsBySubject = loadRooms();
+        map<string, int> roomIndex;
+        map<string, int> groupOf;       // subject -> group
+        map<string, uint32_t> classIndex;
+
+        for (const auto& teacher : teachers)
+        {
+            set<string> classes(teacher.assignedClasses.begin(), teacher.assignedClasses.end());
+            if (classes.empty() || teacher.periodsPerWeek <= 0)
+                continue;
+            if (teacher.periodsPerWeek < static_cast<int>(classes.size()))
+            {
+                plan.problems.push_back(teacher.id + " has " + to_string(teacher.periodsPerWeek) + " periods a week for " + to_string(classes.size()) + " classes");
+                continue;
+            }
+            if (teacher.periodsPerWeek > slots)
+            {
+                plan.problems.push_back(teacher.id + " has " + to_string(teacher.periodsPerWeek) + " periods a week but the week has " + to_string(slots));
+                continue;
+            }
+
+            int group = -1;
+            string subject = teacher.subjects.empty() ? "" : Utils::toLower(teacher.subjects[0]);
+            auto rooms = roomsBySubject.find(subject);
+            if (rooms != roomsBySubject.end())
+            {
+                auto known = groupOf.find(subject);
+                if (known == groupOf.end())
+                {
+                    vector<int> members;
+                    for (const auto& room : rooms->second)
+                    {
+                        auto inserted = roomIndex.insert(make_pair(room, static_cast<int>(problem.rooms.size())));
+                        if (inserted.second)
+                            problem.rooms.push_back(room);
+                        members.push_back(inserted.first->second);
+                    }
+                    known = groupOf.insert(make_pair(subject, static_cast<int>(problem.groups.size()))).first;
+                    problem.groups.push_back(members);
+                }
+                group = known->second;
+            }
+
+            uint32_t teacherIndex = static_cast<uint32_t>(problem.teacherIds.size());
+            problem.teacherIds.push_back(teacher.id);
+            int base = teacher.periodsPerWeek / static_cast<int>(classes.size());
+            int extra = teacher.periodsPerWeek % static_cast<int>(classes.size());
+            for (const auto& className : classes)
+            {
+                auto found = classIndex.insert(make_pair(className, static_cast<uint32_t>(problem.classNames.size())));
+                if (found.second)
+                    problem.classNames.push_back(className);
+                int lessons = base + (extra-- > 0 ? 1 : 0);
+                problem.pairs.push_back(Pair{ teacherIndex, found.first->second, group, lessons, (lessons + days - 1) / days });
+                problem.lessons += lessons;
+            }
+        }
+
+        problem.byTeacher.resize(problem.teacherIds.size());
+        problem.byClass.resize(problem.classNames.size());
+        problem.byGroup.resize(problem.groups.size());
+        vector<int> classLoad(problem.classNames.size(), 0);
+        vector<int> groupLoad(problem.groups.size(), 0);
+        for (uint32_t i = 0; i < problem.pairs.size(); ++i)
+        {
+            const Pair& pair = problem.pairs[i];
+            problem.byTeacher[pair.teacher].push_back(i);
+            problem.byClass[pair.classIndex].push_back(i);
+            classLoad[pair.classIndex] += pair.lessons;
+            if (pair.group >= 0)
+            {
+                problem.byGroup[pair.group].push_back(i);
+                groupLoad[pair.group] += pair.lessons;
+            }
+        }
+        for (size_t c = 0; c < classLoad.size(); ++c)
+        {
+            if (classLoad[c] > slots)
+                plan.problems.push_back("Class " + problem.classNames[c] + " needs " + to_string(classLoad[c]) + " periods but the week has " + to_string(slots));
+        }
+        for (const auto& subject : groupOf)
+        {
+            int capacity = slots * static_cast<int>(problem.groups[subject.second].size());
+            if (groupLoad[subject.second] > capacity)
+                plan.problems.push_back("Rooms for " + subject.first + " are needed " + to_string(groupLoad[subject.second]) + " times but have " + to_string(capacity) + " slots");
+        }
+
+        plan.lessons = problem.lessons;
+        plan.teachers = problem.teacherIds.size();
+        plan.classes = problem.classNames.size();
+        plan.rooms = problem.rooms.size();
+        return plan.problems.empty();
+    }
+
+    // Restarts with a growing backtrack budget until solved, stopped or out of time
+    static bool work(const Problem& problem, uint32_t seed, atomic<bool>& stop, atomic<size_t>& attempts, chrono::steady_clock::time_point deadline, vector<Placement>& result)
+    {
+        State state(problem, seed);
+        state.deadline = deadline;
+        size_t budget = problem.lessons + 1000;
+        while (!stop.load() && chrono::steady_clock::now() < deadline)
+        {
+            state.reset();
+            state.budget = budget;
+            attempts++;
+            if (state.search(stop))
+            {
+                if (stop.exchange(true))
+                    return false;
+                result = state.placed;
+                return true;
+            }
+            budget += budget / 2;
+        }
+        return false;
+    }
+
+public:
+    static const char* dayName(int day)
+    {
+        static const char* names[] = { "Monday", "Tuesday", "Wednesday", "Thursday", "Friday", "Saturday" };
+        return names[day];
+    }
+
+    // days 1-6, periods per day such that the week has at most 64 slots
+    static TimetablePlan solve(const vector<TeacherRecord>& teachers, int days, int periods, int seconds = 30)
+    {
+        TimetablePlan plan;
+        auto started = chrono::steady_clock::now();
+        Problem problem;
+        if (!build(teachers, days, periods, problem, plan))
+            return plan;
+        if (problem.lessons == 0)
+        {
+            plan.problems.push_back("No teacher has classes and periods to schedule");
+            return plan;
+        }
+
+        atomic<bool> stop(false);
+        atomic<size_t> attempts(0);
+        auto deadline = started + chrono::seconds(seconds);
+        uint32_t seed = random_device()();
+        size_t workers = max(1u, thread::hardware_concurrency());
+        vector<vector<Placement>> results(workers);
+        vector<future<bool>> jobs;
+        for (size_t w = 0; w < workers; ++w)
+        {
+            jobs.push_back(async(launch::async, work, cref(problem), seed + static_cast<uint32_t>(w), ref(stop), ref(attempts), deadline, ref(results[w])));
+        }
+
+        const vector<Placement>* solution = nullptr;
+        for (size_t w = 0; w < workers; ++w)
+        {
+            if (jobs[w].get())
+                solution = &results[w];
+        }
+        plan.attempts = attempts.load();
+        plan.millis = chrono::duration<double, milli>(chrono::steady_clock::now() - started).count();
+        if (!solution)
+        {
+            plan.problems.push_back("No timetable found within " + to_string(seconds) + " seconds; fewer periods or more rooms may help");
+            return plan;
+        }
+
+        vector<Placement> lessons = *solution;
+        sort(lessons.begin(), lessons.end(), [&problem](const Placement& a, const Placement& b)
+            {
+            if (a.slot != b.slot)
+                return a.slot < b.slot;
+            return problem.classNames[problem.pairs[a.pair].classIndex] < problem.classNames[problem.pairs[b.pair].classIndex];
+            });
+        for (const auto& lesson : lessons)
+        {
+            const Pair& pair = problem.pairs[lesson.pair];
+            const string& className = problem.classNames[pair.classIndex];
+            plan.rows.push_back(string(dayName(lesson.slot / periods)) + "|" + to_string(lesson.slot % periods + 1) + "|" + problem.teacherIds[pair.teacher] + "|" + className + "|" + (lesson.room < 0 ? className : problem.rooms[lesson.room]));
+        }
+        plan.solved = true;
+        return plan;
+    }
+
+    static bool save(const TimetablePlan& plan)
+    {
+        string content = "[TIMETABLE]\n";
+        for (const auto& row : plan.rows)
+            content += row + "\n";
+        return Storage::writeAtomic(Catalog::path("timetable.txt"), content);
+    }
+
+    static void printSummary(const TimetablePlan& plan)
+    {
+        string out;
+        if (!plan.solved)
+        {
+            out += "\nNo timetable could be built:\n";
+            for (const auto& problem : plan.problems)
+                out += "  - " + problem + "\n";
+            cout << out;
+            return;
+        }
+
+        ConsoleTable table;
+        table.column("Lessons", 10, ConsoleTable::Right).column("Teachers", 10, ConsoleTable::Right).column("Classes", 10, ConsoleTable::Right).column("Lab rooms", 10, ConsoleTable::Right).underlined();
+        table.cell(plan.lessons).cell(plan.teachers).cell(plan.classes).cell(plan.rooms);
+        out += "\n";
+        table.render(out);
+        out += "Solved in ";
+        ConsoleTable::appendFixed(out, plan.millis, 0);
+        out += " ms after " + to_string(plan.attempts) + " attempt(s)\n";
+        cout << out;
+    }
+};
+
+#endif
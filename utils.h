@@ -12,6 +12,8 @@
 #include <cctype>
 #include <limits>
 
+#include "scan.h"
+
 using namespace std;
 
 namespace Utils 
@@ -19,16 +21,16 @@ namespace Utils
     vector<string> splitString(const string& s, char delimiter)
     {
         vector<string> tokens;
-        string token;
-        istringstream tokenStream(s);
-        while (getline(tokenStream, token, delimiter)) 
+        thread_local vector<Scan::Span> spans;
+        spans.clear();
+        Scan::split(s.data(), s.size(), delimiter, spans);
+
+        // Fields come back trimmed; empty ones are dropped
+        for (const auto& span : spans)
         {
-            // Trim whitespace from each token
-            token.erase(token.find_last_not_of(" \t\n\r\f\v") + 1);
-            token.erase(0, token.find_first_not_of(" \t\n\r\f\v"));
-            if (!token.empty()) 
+            if (span.end > span.begin) 
             {
-                tokens.push_back(token);
+                tokens.emplace_back(s, span.begin, span.end - span.begin);
             }
         }
         return tokens;
@@ -95,6 +97,42 @@ namespace Utils
         }
     }
 
+    // Days since 1970-01-01 for a YYYY-MM-DD date (civil calendar), 0 if malformed
+    long dateToDays(const string& date)
+    {
+        if (!validateDate(date))
+            return 0;
+
+        int y = stoi(date.substr(0, 4));
+        unsigned m = stoi(date.substr(5, 2));
+        unsigned d = stoi(date.substr(8, 2));
+
+        y -= m <= 2;
+        const int era = (y >= 0 ? y : y - 399) / 400;
+        const unsigned yoe = static_cast<unsigned>(y - era * 400);
+        const unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+        const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+        return era * 146097L + static_cast<long>(doe) - 719468L;
+    }
+
+    // Inverse of dateToDays
+    string daysToDate(long days)
+    {
+        days += 719468L;
+        const long era = (days >= 0 ? days : days - 146096) / 146097;
+        const unsigned doe = static_cast<unsigned>(days - era * 146097);
+        const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+        const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+        const unsigned mp = (5 * doy + 2) / 153;
+        const unsigned d = doy - (153 * mp + 2) / 5 + 1;
+        const unsigned m = mp < 10 ? mp + 3 : mp - 9;
+        const long y = static_cast<long>(yoe) + era * 400 + (m <= 2);
+
+        stringstream ss;
+        ss << y << "-" << setw(2) << setfill('0') << m << "-" << setw(2) << setfill('0') << d;
+        return ss.str();
+    }
+
     bool validateGrade(int grade) 
     {
         return grade >= 0 && grade <= 100;
@@ -109,22 +147,15 @@ namespace Utils
     vector<string> parseRecord(const string& record) 
     {
         vector<string> parts;
-        size_t start = 0;
-        size_t end = record.find('|');
-
-        while (end != string::npos)
-        {
-            parts.push_back(record.substr(start, end - start));
-            start = end + 1;
-            end = record.find('|', start);
-        }
-        parts.push_back(record.substr(start));
+        thread_local vector<Scan::Span> spans;
+        spans.clear();
+        Scan::split(record.data(), record.size(), '|', spans);
 
-        // Trim whitespace from each part
-        for (auto& part : parts) 
+        // Each part is trimmed of surrounding whitespace
+        parts.reserve(spans.size());
+        for (const auto& span : spans) 
         {
-            part.erase(part.find_last_not_of(" \t\n\r\f\v") + 1);
-            part.erase(0, part.find_first_not_of(" \t\n\r\f\v"));
+            parts.emplace_back(record, span.begin, span.end - span.begin);
         }
 
         return parts;